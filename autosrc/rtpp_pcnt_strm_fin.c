@@ -11,17 +11,38 @@ static void rtpp_pcnt_strm_get_stats_fin(void *pub) {
     fprintf(stderr, "Method rtpp_pcnt_strm@%p::get_stats (rtpp_pcnt_strm_get_stats) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_pcnt_strm_reg_kdropped_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_pcnt_strm@%p::reg_kdropped (rtpp_pcnt_strm_reg_kdropped) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_pcnt_strm_reg_npktin_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_pcnt_strm@%p::reg_npktin (rtpp_pcnt_strm_reg_npktin) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_pcnt_strm_reg_pktin_fin(void *pub) {
     fprintf(stderr, "Method rtpp_pcnt_strm@%p::reg_pktin (rtpp_pcnt_strm_reg_pktin) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_pcnt_strm_reg_throttled_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_pcnt_strm@%p::reg_throttled (rtpp_pcnt_strm_reg_throttled) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 void rtpp_pcnt_strm_fin(struct rtpp_pcnt_strm *pub) {
     RTPP_DBG_ASSERT(pub->get_stats != (rtpp_pcnt_strm_get_stats_t)NULL);
     RTPP_DBG_ASSERT(pub->get_stats != (rtpp_pcnt_strm_get_stats_t)&rtpp_pcnt_strm_get_stats_fin);
     pub->get_stats = (rtpp_pcnt_strm_get_stats_t)&rtpp_pcnt_strm_get_stats_fin;
+    RTPP_DBG_ASSERT(pub->reg_kdropped != (rtpp_pcnt_strm_reg_kdropped_t)NULL);
+    RTPP_DBG_ASSERT(pub->reg_kdropped != (rtpp_pcnt_strm_reg_kdropped_t)&rtpp_pcnt_strm_reg_kdropped_fin);
+    pub->reg_kdropped = (rtpp_pcnt_strm_reg_kdropped_t)&rtpp_pcnt_strm_reg_kdropped_fin;
+    RTPP_DBG_ASSERT(pub->reg_npktin != (rtpp_pcnt_strm_reg_npktin_t)NULL);
+    RTPP_DBG_ASSERT(pub->reg_npktin != (rtpp_pcnt_strm_reg_npktin_t)&rtpp_pcnt_strm_reg_npktin_fin);
+    pub->reg_npktin = (rtpp_pcnt_strm_reg_npktin_t)&rtpp_pcnt_strm_reg_npktin_fin;
     RTPP_DBG_ASSERT(pub->reg_pktin != (rtpp_pcnt_strm_reg_pktin_t)NULL);
     RTPP_DBG_ASSERT(pub->reg_pktin != (rtpp_pcnt_strm_reg_pktin_t)&rtpp_pcnt_strm_reg_pktin_fin);
     pub->reg_pktin = (rtpp_pcnt_strm_reg_pktin_t)&rtpp_pcnt_strm_reg_pktin_fin;
+    RTPP_DBG_ASSERT(pub->reg_throttled != (rtpp_pcnt_strm_reg_throttled_t)NULL);
+    RTPP_DBG_ASSERT(pub->reg_throttled != (rtpp_pcnt_strm_reg_throttled_t)&rtpp_pcnt_strm_reg_throttled_fin);
+    pub->reg_throttled = (rtpp_pcnt_strm_reg_throttled_t)&rtpp_pcnt_strm_reg_throttled_fin;
 }
 #if defined(RTPP_FINTEST)
 #include <assert.h>
@@ -45,13 +66,19 @@ rtpp_pcnt_strm_fintest()
     assert(tp != NULL);
     assert(tp->pub.rcnt != NULL);
     tp->pub.get_stats = (rtpp_pcnt_strm_get_stats_t)((void *)0x1);
+    tp->pub.reg_kdropped = (rtpp_pcnt_strm_reg_kdropped_t)((void *)0x1);
+    tp->pub.reg_npktin = (rtpp_pcnt_strm_reg_npktin_t)((void *)0x1);
     tp->pub.reg_pktin = (rtpp_pcnt_strm_reg_pktin_t)((void *)0x1);
+    tp->pub.reg_throttled = (rtpp_pcnt_strm_reg_throttled_t)((void *)0x1);
     CALL_SMETHOD(tp->pub.rcnt, attach, (rtpp_refcnt_dtor_t)&rtpp_pcnt_strm_fin,
       &tp->pub);
     RTPP_OBJ_DECREF(&(tp->pub));
     CALL_TFIN(&tp->pub, get_stats);
+    CALL_TFIN(&tp->pub, reg_kdropped);
+    CALL_TFIN(&tp->pub, reg_npktin);
     CALL_TFIN(&tp->pub, reg_pktin);
-    assert((_naborts - naborts_s) == 2);
+    CALL_TFIN(&tp->pub, reg_throttled);
+    assert((_naborts - naborts_s) == 5);
 }
 const static void *_rtpp_pcnt_strm_ftp = (void *)&rtpp_pcnt_strm_fintest;
 DATA_SET(rtpp_fintests, _rtpp_pcnt_strm_ftp);
@@ -19,6 +19,14 @@ static void rtpp_pcount_reg_ignr_fin(void *pub) {
     fprintf(stderr, "Method rtpp_pcount@%p::reg_ignr (rtpp_pcount_reg_ignr) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_pcount_reg_nreld_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_pcount@%p::reg_nreld (rtpp_pcount_reg_nreld) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_pcount_reg_plcd_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_pcount@%p::reg_plcd (rtpp_pcount_reg_plcd) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_pcount_reg_reld_fin(void *pub) {
     fprintf(stderr, "Method rtpp_pcount@%p::reg_reld (rtpp_pcount_reg_reld) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
@@ -33,6 +41,12 @@ void rtpp_pcount_fin(struct rtpp_pcount *pub) {
     RTPP_DBG_ASSERT(pub->reg_ignr != (rtpp_pcount_reg_ignr_t)NULL);
     RTPP_DBG_ASSERT(pub->reg_ignr != (rtpp_pcount_reg_ignr_t)&rtpp_pcount_reg_ignr_fin);
     pub->reg_ignr = (rtpp_pcount_reg_ignr_t)&rtpp_pcount_reg_ignr_fin;
+    RTPP_DBG_ASSERT(pub->reg_nreld != (rtpp_pcount_reg_nreld_t)NULL);
+    RTPP_DBG_ASSERT(pub->reg_nreld != (rtpp_pcount_reg_nreld_t)&rtpp_pcount_reg_nreld_fin);
+    pub->reg_nreld = (rtpp_pcount_reg_nreld_t)&rtpp_pcount_reg_nreld_fin;
+    RTPP_DBG_ASSERT(pub->reg_plcd != (rtpp_pcount_reg_plcd_t)NULL);
+    RTPP_DBG_ASSERT(pub->reg_plcd != (rtpp_pcount_reg_plcd_t)&rtpp_pcount_reg_plcd_fin);
+    pub->reg_plcd = (rtpp_pcount_reg_plcd_t)&rtpp_pcount_reg_plcd_fin;
     RTPP_DBG_ASSERT(pub->reg_reld != (rtpp_pcount_reg_reld_t)NULL);
     RTPP_DBG_ASSERT(pub->reg_reld != (rtpp_pcount_reg_reld_t)&rtpp_pcount_reg_reld_fin);
     pub->reg_reld = (rtpp_pcount_reg_reld_t)&rtpp_pcount_reg_reld_fin;
@@ -61,6 +75,8 @@ rtpp_pcount_fintest()
     tp->pub.get_stats = (rtpp_pcount_get_stats_t)((void *)0x1);
     tp->pub.reg_drop = (rtpp_pcount_reg_drop_t)((void *)0x1);
     tp->pub.reg_ignr = (rtpp_pcount_reg_ignr_t)((void *)0x1);
+    tp->pub.reg_nreld = (rtpp_pcount_reg_nreld_t)((void *)0x1);
+    tp->pub.reg_plcd = (rtpp_pcount_reg_plcd_t)((void *)0x1);
     tp->pub.reg_reld = (rtpp_pcount_reg_reld_t)((void *)0x1);
     CALL_SMETHOD(tp->pub.rcnt, attach, (rtpp_refcnt_dtor_t)&rtpp_pcount_fin,
       &tp->pub);
@@ -68,8 +84,10 @@ rtpp_pcount_fintest()
     CALL_TFIN(&tp->pub, get_stats);
     CALL_TFIN(&tp->pub, reg_drop);
     CALL_TFIN(&tp->pub, reg_ignr);
+    CALL_TFIN(&tp->pub, reg_nreld);
+    CALL_TFIN(&tp->pub, reg_plcd);
     CALL_TFIN(&tp->pub, reg_reld);
-    assert((_naborts - naborts_s) == 4);
+    assert((_naborts - naborts_s) == 6);
 }
 const static void *_rtpp_pcount_ftp = (void *)&rtpp_pcount_fintest;
 DATA_SET(rtpp_fintests, _rtpp_pcount_ftp);
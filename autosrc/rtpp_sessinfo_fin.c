@@ -7,10 +7,18 @@
 #include "rtpp_debug.h"
 #include "rtpp_sessinfo.h"
 #include "rtpp_sessinfo_fin.h"
+static void rtpp_si_activate_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_sessinfo@%p::activate (rtpp_si_activate) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_si_append_fin(void *pub) {
     fprintf(stderr, "Method rtpp_sessinfo@%p::append (rtpp_si_append) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_si_get_wakefd_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_sessinfo@%p::get_wakefd (rtpp_si_get_wakefd) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_si_remove_fin(void *pub) {
     fprintf(stderr, "Method rtpp_sessinfo@%p::remove (rtpp_si_remove) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
@@ -23,10 +31,20 @@ static void rtpp_si_update_fin(void *pub) {
     fprintf(stderr, "Method rtpp_sessinfo@%p::update (rtpp_si_update) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_si_wakeup_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_sessinfo@%p::wakeup (rtpp_si_wakeup) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 void rtpp_sessinfo_fin(struct rtpp_sessinfo *pub) {
+    RTPP_DBG_ASSERT(pub->activate != (rtpp_si_activate_t)NULL);
+    RTPP_DBG_ASSERT(pub->activate != (rtpp_si_activate_t)&rtpp_si_activate_fin);
+    pub->activate = (rtpp_si_activate_t)&rtpp_si_activate_fin;
     RTPP_DBG_ASSERT(pub->append != (rtpp_si_append_t)NULL);
     RTPP_DBG_ASSERT(pub->append != (rtpp_si_append_t)&rtpp_si_append_fin);
     pub->append = (rtpp_si_append_t)&rtpp_si_append_fin;
+    RTPP_DBG_ASSERT(pub->get_wakefd != (rtpp_si_get_wakefd_t)NULL);
+    RTPP_DBG_ASSERT(pub->get_wakefd != (rtpp_si_get_wakefd_t)&rtpp_si_get_wakefd_fin);
+    pub->get_wakefd = (rtpp_si_get_wakefd_t)&rtpp_si_get_wakefd_fin;
     RTPP_DBG_ASSERT(pub->remove != (rtpp_si_remove_t)NULL);
     RTPP_DBG_ASSERT(pub->remove != (rtpp_si_remove_t)&rtpp_si_remove_fin);
     pub->remove = (rtpp_si_remove_t)&rtpp_si_remove_fin;
@@ -36,6 +54,9 @@ void rtpp_sessinfo_fin(struct rtpp_sessinfo *pub) {
     RTPP_DBG_ASSERT(pub->update != (rtpp_si_update_t)NULL);
     RTPP_DBG_ASSERT(pub->update != (rtpp_si_update_t)&rtpp_si_update_fin);
     pub->update = (rtpp_si_update_t)&rtpp_si_update_fin;
+    RTPP_DBG_ASSERT(pub->wakeup != (rtpp_si_wakeup_t)NULL);
+    RTPP_DBG_ASSERT(pub->wakeup != (rtpp_si_wakeup_t)&rtpp_si_wakeup_fin);
+    pub->wakeup = (rtpp_si_wakeup_t)&rtpp_si_wakeup_fin;
 }
 #if defined(RTPP_FINTEST)
 #include <assert.h>
@@ -58,18 +79,24 @@ rtpp_sessinfo_fintest()
     tp = rtpp_rzmalloc(sizeof(*tp), offsetof(typeof(*tp), pub.rcnt));
     assert(tp != NULL);
     assert(tp->pub.rcnt != NULL);
+    tp->pub.activate = (rtpp_si_activate_t)((void *)0x1);
     tp->pub.append = (rtpp_si_append_t)((void *)0x1);
+    tp->pub.get_wakefd = (rtpp_si_get_wakefd_t)((void *)0x1);
     tp->pub.remove = (rtpp_si_remove_t)((void *)0x1);
     tp->pub.sync_polltbl = (rtpp_si_sync_polltbl_t)((void *)0x1);
     tp->pub.update = (rtpp_si_update_t)((void *)0x1);
+    tp->pub.wakeup = (rtpp_si_wakeup_t)((void *)0x1);
     CALL_SMETHOD(tp->pub.rcnt, attach, (rtpp_refcnt_dtor_t)&rtpp_sessinfo_fin,
       &tp->pub);
     RTPP_OBJ_DECREF(&(tp->pub));
+    CALL_TFIN(&tp->pub, activate);
     CALL_TFIN(&tp->pub, append);
+    CALL_TFIN(&tp->pub, get_wakefd);
     CALL_TFIN(&tp->pub, remove);
     CALL_TFIN(&tp->pub, sync_polltbl);
     CALL_TFIN(&tp->pub, update);
-    assert((_naborts - naborts_s) == 4);
+    CALL_TFIN(&tp->pub, wakeup);
+    assert((_naborts - naborts_s) == 7);
 }
 const static void *_rtpp_sessinfo_ftp = (void *)&rtpp_sessinfo_fintest;
 DATA_SET(rtpp_fintests, _rtpp_sessinfo_ftp);
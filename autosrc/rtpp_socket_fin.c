@@ -19,22 +19,62 @@ static void rtpp_socket_getfd_fin(void *pub) {
     fprintf(stderr, "Method rtpp_socket@%p::getfd (rtpp_socket_getfd) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_socket_getrbuf_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::getrbuf (rtpp_socket_getrbuf) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_socket_kdrops_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::kdrops (rtpp_socket_kdrops) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_socket_rtp_recv_fin(void *pub) {
     fprintf(stderr, "Method rtpp_socket@%p::rtp_recv (rtpp_socket_rtp_recv) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_socket_rtp_recvm_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::rtp_recvm (rtpp_socket_rtp_recvm) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_socket_rx_backlog_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::rx_backlog (rtpp_socket_rx_backlog) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_socket_rx_pending_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::rx_pending (rtpp_socket_rx_pending) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_socket_send_pkt_na_fin(void *pub) {
     fprintf(stderr, "Method rtpp_socket@%p::send_pkt_na (rtpp_socket_send_pkt_na) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_socket_setbusypoll_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::setbusypoll (rtpp_socket_setbusypoll) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_socket_setconnect_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::setconnect (rtpp_socket_setconnect) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_socket_setgro_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::setgro (rtpp_socket_setgro) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_socket_setnonblock_fin(void *pub) {
     fprintf(stderr, "Method rtpp_socket@%p::setnonblock (rtpp_socket_setnonblock) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_socket_setpeer_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::setpeer (rtpp_socket_setpeer) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_socket_setrbuf_fin(void *pub) {
     fprintf(stderr, "Method rtpp_socket@%p::setrbuf (rtpp_socket_setrbuf) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_socket_setsrcfilter_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::setsrcfilter (rtpp_socket_setsrcfilter) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_socket_settimestamp_fin(void *pub) {
     fprintf(stderr, "Method rtpp_socket@%p::settimestamp (rtpp_socket_settimestamp) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
@@ -43,6 +83,14 @@ static void rtpp_socket_settos_fin(void *pub) {
     fprintf(stderr, "Method rtpp_socket@%p::settos (rtpp_socket_settos) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_socket_settxtime_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::settxtime (rtpp_socket_settxtime) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_socket_seturing_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_socket@%p::seturing (rtpp_socket_seturing) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 void rtpp_socket_fin(struct rtpp_socket *pub) {
     RTPP_DBG_ASSERT(pub->bind2 != (rtpp_socket_bind_t)NULL);
     RTPP_DBG_ASSERT(pub->bind2 != (rtpp_socket_bind_t)&rtpp_socket_bind_fin);
@@ -53,24 +101,60 @@ void rtpp_socket_fin(struct rtpp_socket *pub) {
     RTPP_DBG_ASSERT(pub->getfd != (rtpp_socket_getfd_t)NULL);
     RTPP_DBG_ASSERT(pub->getfd != (rtpp_socket_getfd_t)&rtpp_socket_getfd_fin);
     pub->getfd = (rtpp_socket_getfd_t)&rtpp_socket_getfd_fin;
+    RTPP_DBG_ASSERT(pub->getrbuf != (rtpp_socket_getrbuf_t)NULL);
+    RTPP_DBG_ASSERT(pub->getrbuf != (rtpp_socket_getrbuf_t)&rtpp_socket_getrbuf_fin);
+    pub->getrbuf = (rtpp_socket_getrbuf_t)&rtpp_socket_getrbuf_fin;
+    RTPP_DBG_ASSERT(pub->kdrops != (rtpp_socket_kdrops_t)NULL);
+    RTPP_DBG_ASSERT(pub->kdrops != (rtpp_socket_kdrops_t)&rtpp_socket_kdrops_fin);
+    pub->kdrops = (rtpp_socket_kdrops_t)&rtpp_socket_kdrops_fin;
     RTPP_DBG_ASSERT(pub->rtp_recv != (rtpp_socket_rtp_recv_t)NULL);
     RTPP_DBG_ASSERT(pub->rtp_recv != (rtpp_socket_rtp_recv_t)&rtpp_socket_rtp_recv_fin);
     pub->rtp_recv = (rtpp_socket_rtp_recv_t)&rtpp_socket_rtp_recv_fin;
+    RTPP_DBG_ASSERT(pub->rtp_recvm != (rtpp_socket_rtp_recvm_t)NULL);
+    RTPP_DBG_ASSERT(pub->rtp_recvm != (rtpp_socket_rtp_recvm_t)&rtpp_socket_rtp_recvm_fin);
+    pub->rtp_recvm = (rtpp_socket_rtp_recvm_t)&rtpp_socket_rtp_recvm_fin;
+    RTPP_DBG_ASSERT(pub->rx_backlog != (rtpp_socket_rx_backlog_t)NULL);
+    RTPP_DBG_ASSERT(pub->rx_backlog != (rtpp_socket_rx_backlog_t)&rtpp_socket_rx_backlog_fin);
+    pub->rx_backlog = (rtpp_socket_rx_backlog_t)&rtpp_socket_rx_backlog_fin;
+    RTPP_DBG_ASSERT(pub->rx_pending != (rtpp_socket_rx_pending_t)NULL);
+    RTPP_DBG_ASSERT(pub->rx_pending != (rtpp_socket_rx_pending_t)&rtpp_socket_rx_pending_fin);
+    pub->rx_pending = (rtpp_socket_rx_pending_t)&rtpp_socket_rx_pending_fin;
     RTPP_DBG_ASSERT(pub->send_pkt_na != (rtpp_socket_send_pkt_na_t)NULL);
     RTPP_DBG_ASSERT(pub->send_pkt_na != (rtpp_socket_send_pkt_na_t)&rtpp_socket_send_pkt_na_fin);
     pub->send_pkt_na = (rtpp_socket_send_pkt_na_t)&rtpp_socket_send_pkt_na_fin;
+    RTPP_DBG_ASSERT(pub->setbusypoll != (rtpp_socket_setbusypoll_t)NULL);
+    RTPP_DBG_ASSERT(pub->setbusypoll != (rtpp_socket_setbusypoll_t)&rtpp_socket_setbusypoll_fin);
+    pub->setbusypoll = (rtpp_socket_setbusypoll_t)&rtpp_socket_setbusypoll_fin;
+    RTPP_DBG_ASSERT(pub->setconnect != (rtpp_socket_setconnect_t)NULL);
+    RTPP_DBG_ASSERT(pub->setconnect != (rtpp_socket_setconnect_t)&rtpp_socket_setconnect_fin);
+    pub->setconnect = (rtpp_socket_setconnect_t)&rtpp_socket_setconnect_fin;
+    RTPP_DBG_ASSERT(pub->setgro != (rtpp_socket_setgro_t)NULL);
+    RTPP_DBG_ASSERT(pub->setgro != (rtpp_socket_setgro_t)&rtpp_socket_setgro_fin);
+    pub->setgro = (rtpp_socket_setgro_t)&rtpp_socket_setgro_fin;
     RTPP_DBG_ASSERT(pub->setnonblock != (rtpp_socket_setnonblock_t)NULL);
     RTPP_DBG_ASSERT(pub->setnonblock != (rtpp_socket_setnonblock_t)&rtpp_socket_setnonblock_fin);
     pub->setnonblock = (rtpp_socket_setnonblock_t)&rtpp_socket_setnonblock_fin;
+    RTPP_DBG_ASSERT(pub->setpeer != (rtpp_socket_setpeer_t)NULL);
+    RTPP_DBG_ASSERT(pub->setpeer != (rtpp_socket_setpeer_t)&rtpp_socket_setpeer_fin);
+    pub->setpeer = (rtpp_socket_setpeer_t)&rtpp_socket_setpeer_fin;
     RTPP_DBG_ASSERT(pub->setrbuf != (rtpp_socket_setrbuf_t)NULL);
     RTPP_DBG_ASSERT(pub->setrbuf != (rtpp_socket_setrbuf_t)&rtpp_socket_setrbuf_fin);
     pub->setrbuf = (rtpp_socket_setrbuf_t)&rtpp_socket_setrbuf_fin;
+    RTPP_DBG_ASSERT(pub->setsrcfilter != (rtpp_socket_setsrcfilter_t)NULL);
+    RTPP_DBG_ASSERT(pub->setsrcfilter != (rtpp_socket_setsrcfilter_t)&rtpp_socket_setsrcfilter_fin);
+    pub->setsrcfilter = (rtpp_socket_setsrcfilter_t)&rtpp_socket_setsrcfilter_fin;
     RTPP_DBG_ASSERT(pub->settimestamp != (rtpp_socket_settimestamp_t)NULL);
     RTPP_DBG_ASSERT(pub->settimestamp != (rtpp_socket_settimestamp_t)&rtpp_socket_settimestamp_fin);
     pub->settimestamp = (rtpp_socket_settimestamp_t)&rtpp_socket_settimestamp_fin;
     RTPP_DBG_ASSERT(pub->settos != (rtpp_socket_settos_t)NULL);
     RTPP_DBG_ASSERT(pub->settos != (rtpp_socket_settos_t)&rtpp_socket_settos_fin);
     pub->settos = (rtpp_socket_settos_t)&rtpp_socket_settos_fin;
+    RTPP_DBG_ASSERT(pub->settxtime != (rtpp_socket_settxtime_t)NULL);
+    RTPP_DBG_ASSERT(pub->settxtime != (rtpp_socket_settxtime_t)&rtpp_socket_settxtime_fin);
+    pub->settxtime = (rtpp_socket_settxtime_t)&rtpp_socket_settxtime_fin;
+    RTPP_DBG_ASSERT(pub->seturing != (rtpp_socket_seturing_t)NULL);
+    RTPP_DBG_ASSERT(pub->seturing != (rtpp_socket_seturing_t)&rtpp_socket_seturing_fin);
+    pub->seturing = (rtpp_socket_seturing_t)&rtpp_socket_seturing_fin;
 }
 #if defined(RTPP_FINTEST)
 #include <assert.h>
@@ -96,25 +180,49 @@ rtpp_socket_fintest()
     tp->pub.bind2 = (rtpp_socket_bind_t)((void *)0x1);
     tp->pub.drain = (rtpp_socket_drain_t)((void *)0x1);
     tp->pub.getfd = (rtpp_socket_getfd_t)((void *)0x1);
+    tp->pub.getrbuf = (rtpp_socket_getrbuf_t)((void *)0x1);
+    tp->pub.kdrops = (rtpp_socket_kdrops_t)((void *)0x1);
     tp->pub.rtp_recv = (rtpp_socket_rtp_recv_t)((void *)0x1);
+    tp->pub.rtp_recvm = (rtpp_socket_rtp_recvm_t)((void *)0x1);
+    tp->pub.rx_backlog = (rtpp_socket_rx_backlog_t)((void *)0x1);
+    tp->pub.rx_pending = (rtpp_socket_rx_pending_t)((void *)0x1);
     tp->pub.send_pkt_na = (rtpp_socket_send_pkt_na_t)((void *)0x1);
+    tp->pub.setbusypoll = (rtpp_socket_setbusypoll_t)((void *)0x1);
+    tp->pub.setconnect = (rtpp_socket_setconnect_t)((void *)0x1);
+    tp->pub.setgro = (rtpp_socket_setgro_t)((void *)0x1);
     tp->pub.setnonblock = (rtpp_socket_setnonblock_t)((void *)0x1);
+    tp->pub.setpeer = (rtpp_socket_setpeer_t)((void *)0x1);
     tp->pub.setrbuf = (rtpp_socket_setrbuf_t)((void *)0x1);
+    tp->pub.setsrcfilter = (rtpp_socket_setsrcfilter_t)((void *)0x1);
     tp->pub.settimestamp = (rtpp_socket_settimestamp_t)((void *)0x1);
     tp->pub.settos = (rtpp_socket_settos_t)((void *)0x1);
+    tp->pub.settxtime = (rtpp_socket_settxtime_t)((void *)0x1);
+    tp->pub.seturing = (rtpp_socket_seturing_t)((void *)0x1);
     CALL_SMETHOD(tp->pub.rcnt, attach, (rtpp_refcnt_dtor_t)&rtpp_socket_fin,
       &tp->pub);
     RTPP_OBJ_DECREF(&(tp->pub));
     CALL_TFIN(&tp->pub, bind2);
     CALL_TFIN(&tp->pub, drain);
     CALL_TFIN(&tp->pub, getfd);
+    CALL_TFIN(&tp->pub, getrbuf);
+    CALL_TFIN(&tp->pub, kdrops);
     CALL_TFIN(&tp->pub, rtp_recv);
+    CALL_TFIN(&tp->pub, rtp_recvm);
+    CALL_TFIN(&tp->pub, rx_backlog);
+    CALL_TFIN(&tp->pub, rx_pending);
     CALL_TFIN(&tp->pub, send_pkt_na);
+    CALL_TFIN(&tp->pub, setbusypoll);
+    CALL_TFIN(&tp->pub, setconnect);
+    CALL_TFIN(&tp->pub, setgro);
     CALL_TFIN(&tp->pub, setnonblock);
+    CALL_TFIN(&tp->pub, setpeer);
     CALL_TFIN(&tp->pub, setrbuf);
+    CALL_TFIN(&tp->pub, setsrcfilter);
     CALL_TFIN(&tp->pub, settimestamp);
     CALL_TFIN(&tp->pub, settos);
-    assert((_naborts - naborts_s) == 9);
+    CALL_TFIN(&tp->pub, settxtime);
+    CALL_TFIN(&tp->pub, seturing);
+    assert((_naborts - naborts_s) == 21);
 }
 const static void *_rtpp_socket_ftp = (void *)&rtpp_socket_fintest;
 DATA_SET(rtpp_fintests, _rtpp_socket_ftp);
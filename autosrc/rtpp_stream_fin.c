@@ -55,6 +55,18 @@ static void rtpp_stream_locklatch_fin(void *pub) {
     fprintf(stderr, "Method rtpp_stream@%p::locklatch (rtpp_stream_locklatch) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_stream_offload_reset_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_stream@%p::offload_reset (rtpp_stream_offload_reset) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_stream_offload_sync_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_stream@%p::offload_sync (rtpp_stream_offload_sync) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_stream_offload_target_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_stream@%p::offload_target (rtpp_stream_offload_target) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_stream_prefill_addr_fin(void *pub) {
     fprintf(stderr, "Method rtpp_stream@%p::prefill_addr (rtpp_stream_prefill_addr) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
@@ -67,14 +79,30 @@ static void rtpp_stream_rx_fin(void *pub) {
     fprintf(stderr, "Method rtpp_stream@%p::rx (rtpp_stream_rx) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_stream_rx_batch_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_stream@%p::rx_batch (rtpp_stream_rx_batch) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
+static void rtpp_stream_rx_demux_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_stream@%p::rx_demux (rtpp_stream_rx_demux) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_stream_send_pkt_fin(void *pub) {
     fprintf(stderr, "Method rtpp_stream@%p::send_pkt (rtpp_stream_send_pkt) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_stream_set_police_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_stream@%p::set_police (rtpp_stream_set_police) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_stream_set_skt_fin(void *pub) {
     fprintf(stderr, "Method rtpp_stream@%p::set_skt (rtpp_stream_set_skt) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
 }
+static void rtpp_stream_tune_rbuf_fin(void *pub) {
+    fprintf(stderr, "Method rtpp_stream@%p::tune_rbuf (rtpp_stream_tune_rbuf) is invoked after destruction\x0a", pub);
+    RTPP_AUTOTRAP();
+}
 static void rtpp_stream_update_skt_fin(void *pub) {
     fprintf(stderr, "Method rtpp_stream@%p::update_skt (rtpp_stream_update_skt) is invoked after destruction\x0a", pub);
     RTPP_AUTOTRAP();
@@ -92,11 +120,18 @@ static const struct rtpp_stream_smethods rtpp_stream_smethods_fin = {
     .isplayer_active = (rtpp_stream_isplayer_active_t)&rtpp_stream_isplayer_active_fin,
     .issendable = (rtpp_stream_issendable_t)&rtpp_stream_issendable_fin,
     .locklatch = (rtpp_stream_locklatch_t)&rtpp_stream_locklatch_fin,
+    .offload_reset = (rtpp_stream_offload_reset_t)&rtpp_stream_offload_reset_fin,
+    .offload_sync = (rtpp_stream_offload_sync_t)&rtpp_stream_offload_sync_fin,
+    .offload_target = (rtpp_stream_offload_target_t)&rtpp_stream_offload_target_fin,
     .prefill_addr = (rtpp_stream_prefill_addr_t)&rtpp_stream_prefill_addr_fin,
     .reg_onhold = (rtpp_stream_reg_onhold_t)&rtpp_stream_reg_onhold_fin,
     .rx = (rtpp_stream_rx_t)&rtpp_stream_rx_fin,
+    .rx_batch = (rtpp_stream_rx_batch_t)&rtpp_stream_rx_batch_fin,
+    .rx_demux = (rtpp_stream_rx_demux_t)&rtpp_stream_rx_demux_fin,
     .send_pkt = (rtpp_stream_send_pkt_t)&rtpp_stream_send_pkt_fin,
+    .set_police = (rtpp_stream_set_police_t)&rtpp_stream_set_police_fin,
     .set_skt = (rtpp_stream_set_skt_t)&rtpp_stream_set_skt_fin,
+    .tune_rbuf = (rtpp_stream_tune_rbuf_t)&rtpp_stream_tune_rbuf_fin,
     .update_skt = (rtpp_stream_update_skt_t)&rtpp_stream_update_skt_fin,
 };
 void rtpp_stream_fin(struct rtpp_stream *pub) {
@@ -112,11 +147,18 @@ void rtpp_stream_fin(struct rtpp_stream *pub) {
     RTPP_DBG_ASSERT(pub->smethods->isplayer_active != (rtpp_stream_isplayer_active_t)NULL);
     RTPP_DBG_ASSERT(pub->smethods->issendable != (rtpp_stream_issendable_t)NULL);
     RTPP_DBG_ASSERT(pub->smethods->locklatch != (rtpp_stream_locklatch_t)NULL);
+    RTPP_DBG_ASSERT(pub->smethods->offload_reset != (rtpp_stream_offload_reset_t)NULL);
+    RTPP_DBG_ASSERT(pub->smethods->offload_sync != (rtpp_stream_offload_sync_t)NULL);
+    RTPP_DBG_ASSERT(pub->smethods->offload_target != (rtpp_stream_offload_target_t)NULL);
     RTPP_DBG_ASSERT(pub->smethods->prefill_addr != (rtpp_stream_prefill_addr_t)NULL);
     RTPP_DBG_ASSERT(pub->smethods->reg_onhold != (rtpp_stream_reg_onhold_t)NULL);
     RTPP_DBG_ASSERT(pub->smethods->rx != (rtpp_stream_rx_t)NULL);
+    RTPP_DBG_ASSERT(pub->smethods->rx_batch != (rtpp_stream_rx_batch_t)NULL);
+    RTPP_DBG_ASSERT(pub->smethods->rx_demux != (rtpp_stream_rx_demux_t)NULL);
     RTPP_DBG_ASSERT(pub->smethods->send_pkt != (rtpp_stream_send_pkt_t)NULL);
+    RTPP_DBG_ASSERT(pub->smethods->set_police != (rtpp_stream_set_police_t)NULL);
     RTPP_DBG_ASSERT(pub->smethods->set_skt != (rtpp_stream_set_skt_t)NULL);
+    RTPP_DBG_ASSERT(pub->smethods->tune_rbuf != (rtpp_stream_tune_rbuf_t)NULL);
     RTPP_DBG_ASSERT(pub->smethods->update_skt != (rtpp_stream_update_skt_t)NULL);
     RTPP_DBG_ASSERT(pub->smethods != &rtpp_stream_smethods_fin &&
       pub->smethods != NULL);
@@ -156,11 +198,18 @@ rtpp_stream_fintest()
         .isplayer_active = (rtpp_stream_isplayer_active_t)((void *)0x1),
         .issendable = (rtpp_stream_issendable_t)((void *)0x1),
         .locklatch = (rtpp_stream_locklatch_t)((void *)0x1),
+        .offload_reset = (rtpp_stream_offload_reset_t)((void *)0x1),
+        .offload_sync = (rtpp_stream_offload_sync_t)((void *)0x1),
+        .offload_target = (rtpp_stream_offload_target_t)((void *)0x1),
         .prefill_addr = (rtpp_stream_prefill_addr_t)((void *)0x1),
         .reg_onhold = (rtpp_stream_reg_onhold_t)((void *)0x1),
         .rx = (rtpp_stream_rx_t)((void *)0x1),
+        .rx_batch = (rtpp_stream_rx_batch_t)((void *)0x1),
+        .rx_demux = (rtpp_stream_rx_demux_t)((void *)0x1),
         .send_pkt = (rtpp_stream_send_pkt_t)((void *)0x1),
+        .set_police = (rtpp_stream_set_police_t)((void *)0x1),
         .set_skt = (rtpp_stream_set_skt_t)((void *)0x1),
+        .tune_rbuf = (rtpp_stream_tune_rbuf_t)((void *)0x1),
         .update_skt = (rtpp_stream_update_skt_t)((void *)0x1),
     };
     tp->pub.smethods = &dummy;
@@ -179,13 +228,20 @@ rtpp_stream_fintest()
     CALL_TFIN(&tp->pub, isplayer_active);
     CALL_TFIN(&tp->pub, issendable);
     CALL_TFIN(&tp->pub, locklatch);
+    CALL_TFIN(&tp->pub, offload_reset);
+    CALL_TFIN(&tp->pub, offload_sync);
+    CALL_TFIN(&tp->pub, offload_target);
     CALL_TFIN(&tp->pub, prefill_addr);
     CALL_TFIN(&tp->pub, reg_onhold);
     CALL_TFIN(&tp->pub, rx);
+    CALL_TFIN(&tp->pub, rx_batch);
+    CALL_TFIN(&tp->pub, rx_demux);
     CALL_TFIN(&tp->pub, send_pkt);
+    CALL_TFIN(&tp->pub, set_police);
     CALL_TFIN(&tp->pub, set_skt);
+    CALL_TFIN(&tp->pub, tune_rbuf);
     CALL_TFIN(&tp->pub, update_skt);
-    assert((_naborts - naborts_s) == 18);
+    assert((_naborts - naborts_s) == 25);
 }
 const static void *_rtpp_stream_ftp = (void *)&rtpp_stream_fintest;
 DATA_SET(rtpp_fintests, _rtpp_stream_ftp);
@@ -80,6 +80,7 @@ rtpp_po_mgr_register(struct po_manager *pub, const struct packet_observer_if *ip
     if (i >= MAX_OBSERVERS)
         return (-1);
     pvt->observers[i] = *ip;
+    pub->nobservers = i + 1;
     return (0);
 }
 
@@ -45,6 +45,8 @@ struct po_manager {
     struct rtpp_refcnt *rcnt;
     po_manager_reg_t reg;
     po_manager_observe_t observe;
+    /* Number of observers registered, read-only */
+    int nobservers;
 };
 
 struct po_manager *rtpp_po_mgr_ctor(void);
@@ -85,8 +85,12 @@
 #include "rtpp_command_async.h"
 #include "rtpp_command_ecodes.h"
 #include "rtpp_port_table.h"
+#include "rtpp_proc.h"
+#include "rtpp_stream.h"
 #include "rtpp_proc_async.h"
 #include "rtpp_proc_ttl.h"
+#include "rtpp_ebpf.h"
+#include "rtpp_demux.h"
 #include "rtpp_bindaddrs.h"
 #include "rtpp_network.h"
 #include "rtpp_notify.h"
@@ -223,6 +227,25 @@ rtpp_rlim_max(const struct rtpp_cfg *cfsp)
 #define LOPT_NICE     258
 #define LOPT_OVL_PROT 259
 #define LOPT_CONFIG   260
+#define LOPT_POLL_ENG 261
+#define LOPT_NWORKERS 262
+#define LOPT_NSENDERS 263
+#define LOPT_INLINE_SEND 264
+#define LOPT_SEND_ENG 265
+#define LOPT_UDP_GRO 266
+#define LOPT_UDP_GSO 267
+#define LOPT_CONN_LATCHED 268
+#define LOPT_BPF_FILTER 269
+#define LOPT_EBPF_OFFLOAD 270
+#define LOPT_TICKLESS 271
+#define LOPT_BUSY_POLL 272
+#define LOPT_TXTIME 273
+#define LOPT_DEMUX 274
+#define LOPT_DRR_QUANTUM 275
+#define LOPT_DRR_CARRY 276
+#define LOPT_POLICE_PPS 277
+#define LOPT_POLICE_KBPS 278
+#define LOPT_RECV_ENG 279
 
 const static struct option longopts[] = {
     { "dso", required_argument, NULL, LOPT_DSO },
@@ -230,6 +253,25 @@ const static struct option longopts[] = {
     { "nice", required_argument, NULL, LOPT_NICE },
     { "overload_prot", optional_argument, NULL, LOPT_OVL_PROT },
     { "config", required_argument, NULL, LOPT_CONFIG },
+    { "poll_engine", required_argument, NULL, LOPT_POLL_ENG },
+    { "nworkers", required_argument, NULL, LOPT_NWORKERS },
+    { "send_threads", required_argument, NULL, LOPT_NSENDERS },
+    { "inline_send", no_argument, NULL, LOPT_INLINE_SEND },
+    { "send_engine", required_argument, NULL, LOPT_SEND_ENG },
+    { "recv_engine", required_argument, NULL, LOPT_RECV_ENG },
+    { "udp_gro", no_argument, NULL, LOPT_UDP_GRO },
+    { "udp_gso", no_argument, NULL, LOPT_UDP_GSO },
+    { "connect_latched", no_argument, NULL, LOPT_CONN_LATCHED },
+    { "bpf_filter", no_argument, NULL, LOPT_BPF_FILTER },
+    { "ebpf_offload", required_argument, NULL, LOPT_EBPF_OFFLOAD },
+    { "tickless", no_argument, NULL, LOPT_TICKLESS },
+    { "busy_poll", optional_argument, NULL, LOPT_BUSY_POLL },
+    { "txtime", no_argument, NULL, LOPT_TXTIME },
+    { "demux", no_argument, NULL, LOPT_DEMUX },
+    { "drr_quantum", required_argument, NULL, LOPT_DRR_QUANTUM },
+    { "drr_carry", required_argument, NULL, LOPT_DRR_CARRY },
+    { "police_pps", required_argument, NULL, LOPT_POLICE_PPS },
+    { "police_kbps", required_argument, NULL, LOPT_POLICE_KBPS },
     { NULL,  0,                 NULL, 0 }
 };
 
@@ -303,6 +345,16 @@ init_config(struct rtpp_cfg *cfsp, int argc, char **argv)
     cfsp->sched_policy = SCHED_OTHER;
     cfsp->sched_nice = PRIO_UNSET;
     cfsp->target_pfreq = MIN(POLL_RATE, cfsp->sched_hz);
+#if HAVE_SYS_EPOLL_H
+    cfsp->poll_engine = RTPP_POLL_EPOLL;
+#else
+    cfsp->poll_engine = RTPP_POLL_POLL;
+#endif
+    cfsp->nworkers = 1;
+    cfsp->drr_carry = -1;
+    cfsp->nsend_threads = 1;
+    cfsp->send_engine = RTPP_SEND_SYNC;
+    cfsp->recv_engine = RTPP_RECV_SYNC;
     RTPP_DBGCODE() {
         if (cfsp->target_pfreq != cfsp->sched_hz)
             fprintf(stderr, "target_pfreq = %f\n", cfsp->target_pfreq);
@@ -383,6 +435,195 @@ init_config(struct rtpp_cfg *cfsp, int argc, char **argv)
             cfsp->cfile = optarg;
             break;
 
+        case LOPT_POLL_ENG:
+            if (strcmp(optarg, "poll") == 0) {
+                cfsp->poll_engine = RTPP_POLL_POLL;
+                break;
+            }
+#if HAVE_SYS_EPOLL_H
+            if (strcmp(optarg, "epoll") == 0) {
+                cfsp->poll_engine = RTPP_POLL_EPOLL;
+                break;
+            }
+#endif
+            errx(1, "%s: unknown or unsupported poll engine", optarg);
+            break;
+
+        case LOPT_NWORKERS:
+            switch (atoi_saferange(optarg, &cfsp->nworkers, 1,
+              RTPP_MAX_WORKERS)) {
+            case ATOI_OK:
+                break;
+            case ATOI_OUTRANGE:
+                errx(1, "%s: number of workers is out of range 1..%d", optarg,
+                  RTPP_MAX_WORKERS);
+            default:
+                errx(1, "%s: number of workers argument is invalid", optarg);
+            }
+            break;
+
+        case LOPT_NSENDERS:
+            switch (atoi_saferange(optarg, &cfsp->nsend_threads, 1,
+              RTPP_MAX_SENDERS)) {
+            case ATOI_OK:
+                break;
+            case ATOI_OUTRANGE:
+                errx(1, "%s: number of send threads is out of range 1..%d",
+                  optarg, RTPP_MAX_SENDERS);
+            default:
+                errx(1, "%s: number of send threads argument is invalid",
+                  optarg);
+            }
+            break;
+
+        case LOPT_INLINE_SEND:
+            cfsp->inline_send = 1;
+            break;
+
+        case LOPT_SEND_ENG:
+            if (strcmp(optarg, "sync") == 0) {
+                cfsp->send_engine = RTPP_SEND_SYNC;
+                break;
+            }
+#if HAVE_LINUX_IO_URING_H
+            if (strcmp(optarg, "io_uring") == 0) {
+                cfsp->send_engine = RTPP_SEND_URING;
+                break;
+            }
+#endif
+            errx(1, "%s: unknown or unsupported send engine", optarg);
+            break;
+
+        case LOPT_RECV_ENG:
+            if (strcmp(optarg, "sync") == 0) {
+                cfsp->recv_engine = RTPP_RECV_SYNC;
+                break;
+            }
+#if HAVE_LINUX_IO_URING_H
+            if (strcmp(optarg, "io_uring") == 0) {
+                cfsp->recv_engine = RTPP_RECV_URING;
+                break;
+            }
+#endif
+            errx(1, "%s: unknown or unsupported receive engine", optarg);
+            break;
+
+        case LOPT_UDP_GRO:
+            cfsp->udp_gro = 1;
+            break;
+
+        case LOPT_UDP_GSO:
+            cfsp->udp_gso = 1;
+            break;
+
+        case LOPT_CONN_LATCHED:
+            cfsp->connect_latched = 1;
+            break;
+
+        case LOPT_BPF_FILTER:
+#if !HAVE_LINUX_FILTER_H
+            errx(1, "--bpf_filter is not supported on this platform");
+#endif
+            cfsp->bpf_filter = 1;
+            break;
+
+        case LOPT_EBPF_OFFLOAD:
+#if !HAVE_LINUX_BPF_H
+            errx(1, "--ebpf_offload is not supported on this platform");
+#endif
+            cfsp->ebpf_offload = optarg;
+            break;
+
+        case LOPT_TICKLESS:
+#if !HAVE_SYS_EPOLL_H || !HAVE_SYS_TIMERFD_H || !HAVE_SYS_EVENTFD_H
+            errx(1, "--tickless is not supported on this platform");
+#endif
+            cfsp->tickless = 1;
+            break;
+
+        case LOPT_BUSY_POLL:
+            cfsp->busy_poll = 1;
+            cfsp->busy_poll_usecs = 50;
+            if (optarg == NULL)
+                break;
+            switch (atoi_saferange(optarg, &cfsp->busy_poll_usecs, 0,
+              1000000)) {
+            case ATOI_OK:
+                break;
+            case ATOI_OUTRANGE:
+                errx(1, "%s: busy poll time is out of range 0..1000000",
+                  optarg);
+            default:
+                errx(1, "%s: busy poll time argument is invalid", optarg);
+            }
+            break;
+
+        case LOPT_TXTIME:
+#if !HAVE_LINUX_NET_TSTAMP_H || !defined(SO_TXTIME)
+            errx(1, "--txtime is not supported on this platform");
+#endif
+            cfsp->txtime = 1;
+            break;
+
+        case LOPT_DRR_QUANTUM:
+            switch (atoi_saferange(optarg, &cfsp->drr_quantum, 1,
+              RTPP_PROC_DRR_MAX)) {
+            case ATOI_OK:
+                break;
+            case ATOI_OUTRANGE:
+                errx(1, "%s: DRR quantum is out of range 1..%d", optarg,
+                  RTPP_PROC_DRR_MAX);
+            default:
+                errx(1, "%s: DRR quantum argument is invalid", optarg);
+            }
+            break;
+
+        case LOPT_DRR_CARRY:
+            switch (atoi_saferange(optarg, &cfsp->drr_carry, 0,
+              RTPP_PROC_DRR_MAX)) {
+            case ATOI_OK:
+                break;
+            case ATOI_OUTRANGE:
+                errx(1, "%s: DRR carry-over is out of range 0..%d", optarg,
+                  RTPP_PROC_DRR_MAX);
+            default:
+                errx(1, "%s: DRR carry-over argument is invalid", optarg);
+            }
+            break;
+
+        case LOPT_POLICE_PPS:
+            switch (atoi_saferange(optarg, &cfsp->police_pps, 0,
+              RTPP_POLICE_PPS_MAX)) {
+            case ATOI_OK:
+                break;
+            case ATOI_OUTRANGE:
+                errx(1, "%s: packet rate limit is out of range 0..%d", optarg,
+                  RTPP_POLICE_PPS_MAX);
+            default:
+                errx(1, "%s: packet rate limit argument is invalid", optarg);
+            }
+            break;
+
+        case LOPT_POLICE_KBPS:
+            switch (atoi_saferange(optarg, &cfsp->police_kbps, 0,
+              RTPP_POLICE_KBPS_MAX)) {
+            case ATOI_OK:
+                break;
+            case ATOI_OUTRANGE:
+                errx(1, "%s: bit rate limit is out of range 0..%d", optarg,
+                  RTPP_POLICE_KBPS_MAX);
+            default:
+                errx(1, "%s: bit rate limit argument is invalid", optarg);
+            }
+            break;
+
+        case LOPT_DEMUX:
+#if !HAVE_LINUX_BPF_H
+            errx(1, "--demux is not supported on this platform");
+#endif
+            cfsp->demux = 1;
+            break;
+
         case 'c':
             if (strcmp(optarg, "fifo") == 0) {
                  cfsp->sched_policy = SCHED_FIFO;
@@ -683,6 +924,18 @@ init_config(struct rtpp_cfg *cfsp, int argc, char **argv)
     if (cfsp->nodaemon == 0 && stdio_mode != 0)
         errx(1, "stdio command mode requires -f switch");
 
+    if (cfsp->tickless != 0 && cfsp->poll_engine != RTPP_POLL_EPOLL)
+        errx(1, "--tickless requires epoll poll engine");
+
+    if (cfsp->tickless != 0 && cfsp->recv_engine != RTPP_RECV_SYNC)
+        errx(1, "--tickless can't be used with the io_uring receive engine");
+
+    if (cfsp->tickless != 0 && cfsp->busy_poll != 0)
+        errx(1, "--tickless and --busy_poll are mutually exclusive");
+
+    if (cfsp->demux != 0 && (cfsp->ebpf_offload != NULL || cfsp->udp_gso != 0))
+        errx(1, "--demux can't be used with --ebpf_offload or --udp_gso");
+
     if (cfsp->no_check == 0 && getuid() == 0 && cfsp->runcreds->uname == NULL) {
 	if (umode != 0) {
 	    errx(1, "running this program as superuser in a remote control "
@@ -870,6 +1123,14 @@ main(int argc, char **argv)
         err(1, "can't allocate memory for the servers weakref table");
          /* NOTREACHED */
     }
+    if (cfs.demux != 0) {
+        char ebuf[128];
+
+        cfs.rtpp_demux_cf = rtpp_demux_ctor(&cfs, ebuf, sizeof(ebuf));
+        if (cfs.rtpp_demux_cf == NULL) {
+            errx(1, "can't init demultiplexing mode: %s", ebuf);
+        }
+    }
     cfs.sessinfo = rtpp_sessinfo_ctor(&cfs);
     if (cfs.sessinfo == NULL) {
         errx(1, "cannot construct rtpp_sessinfo structure");
@@ -937,6 +1198,17 @@ main(int argc, char **argv)
         }
     }
 
+    if (cfs.ebpf_offload != NULL) {
+        char ebuf[128];
+
+        cfs.rtpp_ebpf_cf = rtpp_ebpf_ctor(cfs.ebpf_offload, ebuf, sizeof(ebuf));
+        if (cfs.rtpp_ebpf_cf == NULL) {
+            RTPP_LOG(cfs.glog, RTPP_LOG_ERR,
+              "can't init eBPF offload: %s", ebuf);
+            exit(1);
+        }
+    }
+
     if (cfs.runcreds->uname != NULL || cfs.runcreds->gname != NULL) {
 	if (drop_privileges(&cfs) != 0) {
 	    RTPP_ELOG(cfs.glog, RTPP_LOG_ERR,
@@ -1099,7 +1371,11 @@ main(int argc, char **argv)
     RTPP_OBJ_DECREF(cfs.rtpp_timed_cf);
     CALL_METHOD(cfs.rtpp_proc_ttl_cf, dtor);
     CALL_METHOD(cfs.rtpp_proc_cf, dtor);
+    if (cfs.rtpp_ebpf_cf != NULL)
+        rtpp_ebpf_dtor(cfs.rtpp_ebpf_cf);
     RTPP_OBJ_DECREF(cfs.sessinfo);
+    if (cfs.rtpp_demux_cf != NULL)
+        RTPP_OBJ_DECREF(cfs.rtpp_demux_cf);
     RTPP_OBJ_DECREF(cfs.rtpp_stats);
     for (i = 0; i <= RTPP_PT_MAX; i++) {
         RTPP_OBJ_DECREF(cfs.port_table[i]);
@@ -134,6 +134,13 @@ struct rtp_packet_chunk {
 };
 
 #define	RTP_HDR_LEN(rhp)	(sizeof(*(rhp)) + ((rhp)->cc * sizeof((rhp)->csrc[0])))
+/*
+ * Tell RTCP from RTP when both are received on the same port: the second
+ * octet of RTCP is a packet type in 192-223 range, which corresponds to
+ * the M bit set and the PT of 64-95 for RTP (RFC 5761, section 4).
+ */
+#define	RTP_IS_RTCP_MUX(buf, len)	((len) >= 2 && \
+  ((buf)[0] & 0xc0) == 0x80 && (buf)[1] >= 192 && (buf)[1] <= 223)
 #define	SEQ_DIST(seq1, seq2) \
   ((seq2) >= (seq1) ? ((seq2) - (seq1)) : ((int)(seq2) + 65536 - (int)(seq1)))
 const char *rtp_packet_parse_errstr(rtp_parser_err_t);
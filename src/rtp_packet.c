@@ -57,6 +57,8 @@ struct rtp_packet_full {
     struct rtp_packet_priv pvt;
 };
 
+RTPP_LAYOUT_FITS(struct rtp_packet, txtime, 2);
+
 void
 rtp_packet_dup(struct rtp_packet *dpkt, const struct rtp_packet *spkt, int flags)
 {
@@ -45,16 +45,21 @@ struct rtp_packet {
     /* ^^^ Elements above are not copied by the rtp_packet_dup() ^^^ */
     rtp_parser_err_t parse_result;
 
+    /*
+     * Scalars go ahead of the (mostly unused) tails of the address
+     * storage, so that they all share the first two cache lines.
+     */
+    socklen_t   rlen;
     size_t      size;
+    int         lport;
+    const struct sockaddr *laddr;
+    struct rtpp_timestamp rtime;
+    /* Intended departure time (monotonic), 0 to send out right away */
+    double      txtime;
 
     struct sockaddr_storage raddr;
     struct sockaddr_storage sendto;
     struct sockaddr_storage _laddr;
-    const struct sockaddr *laddr;
-    int         lport;
-
-    socklen_t   rlen;
-    struct rtpp_timestamp rtime;
 
     /*
      * The packet, keep it the last member so that we can use
@@ -60,6 +60,9 @@ struct rtp_resizer {
     int         output_nsamples;
     int         max_buf_nsamples;
 
+    /* Earliest departure time for the next output packet */
+    double      next_txtime;
+
     struct {
         struct rtp_packet *first;
         struct rtp_packet *last;
@@ -289,6 +292,7 @@ rtp_resizer_get(struct rtp_resizer *this, double dtime)
     struct rtp_packet *ret = NULL;
     struct rtp_packet *p;
     uint32_t    ref_ts;
+    double      txtime, duration;
     int         count = 0;
     int         split = 0;
     int         nsamples_left;
@@ -415,6 +419,19 @@ rtp_resizer_get(struct rtp_resizer *this, double dtime)
 	++this->seq;
 	this->last_sent_ts_inited = 1;
 	this->last_sent_ts = ret->parsed->ts + ret->parsed->nsamples;
+	/*
+	 * Space packets out by their duration, so that a burst on input does
+	 * not turn into a burst on output, but never hold any of them for
+	 * longer than that.
+	 */
+	duration = (double)ret->parsed->nsamples / 8000.0;
+	txtime = this->next_txtime;
+	if (txtime < dtime)
+	    txtime = dtime;
+	else if (txtime > dtime + duration)
+	    txtime = dtime + duration;
+	ret->txtime = txtime;
+	this->next_txtime = txtime + duration;
 /*
 	printf("Payload %d, %d packets aggregated, %d splits done, final size %dms\n", ret->data.header.pt, count, split, ret->parsed->nsamples / 8);
 */
@@ -47,6 +47,8 @@ struct rtpp_log;
 struct rtpp_module_if;
 struct rtpp_runcreds;
 struct rtpp_proc_ttl;
+struct rtpp_ebpf;
+struct rtpp_demux;
 struct po_manager;
 struct rtpp_locking;
 struct rtpp_nofile;
@@ -58,6 +60,18 @@ struct rtpp_nofile;
 #define	RTPP_PT_SELECT(cp, af) (((af) == AF_INET) ? \
   (cp)->port_table[RTPP_PT_INET] : (cp)->port_table[RTPP_PT_INET6])
 
+#define	RTPP_POLL_POLL	0	/* poll(2) over the whole table every cycle */
+#define	RTPP_POLL_EPOLL	1	/* epoll(7), cost is proportional to # of ready fds */
+
+#define	RTPP_SEND_SYNC	0	/* sendmmsg(2) or sendto(2) */
+#define	RTPP_SEND_URING	1	/* io_uring(7), batch spans multiple sockets */
+
+#define	RTPP_RECV_SYNC	0	/* recvmmsg(2) on sockets reported by the poll engine */
+#define	RTPP_RECV_URING	1	/* io_uring(7) multishot recvmsg, per-worker ring */
+
+#define	RTPP_MAX_WORKERS	64	/* max # of RTP/RTCP forwarding threads */
+#define	RTPP_MAX_SENDERS	64	/* max # of network output threads */
+
 struct overload_prot {
     double low_trs;
     double high_trs;
@@ -117,9 +131,31 @@ struct rtpp_cfg {
     int sched_hz;
     int sched_nice;
     double target_pfreq;
+    int poll_engine;                /* RTPP_POLL_xxx */
+    int nworkers;                   /* # of RTP/RTCP forwarding threads */
+    int nsend_threads;              /* # of network output threads */
+    int inline_send;                /* send from forwarding thread when idle */
+    int tickless;                   /* sleep until the next event or deadline */
+    int busy_poll;                  /* spin instead of sleeping at all */
+    int busy_poll_usecs;            /* SO_BUSY_POLL for media sockets */
+    int txtime;                     /* kernel-paced player / resizer output */
+    int drr_quantum;                /* per-socket packets per round, 0 - auto */
+    int drr_carry;                  /* unused budget carried over, -1 - auto */
+    int police_pps;                 /* default per-stream pps limit, 0 - none */
+    int police_kbps;                /* default per-stream kbps limit, 0 - none */
+    int send_engine;                /* RTPP_SEND_xxx */
+    int recv_engine;                /* RTPP_RECV_xxx */
+    int udp_gro;                    /* enable UDP_GRO on media sockets */
+    int udp_gso;                    /* coalesce sends using UDP_SEGMENT */
+    int connect_latched;            /* connect() sockets to latched peers */
+    int bpf_filter;                 /* filter out non-latched sources */
+    const char *ebpf_offload;       /* interface(s) to relay in-kernel on */
+    int demux;                      /* receive via shared sockets only */
     struct rtpp_cmd_async *rtpp_cmd_cf;
     struct rtpp_proc_async *rtpp_proc_cf;
     struct rtpp_proc_ttl *rtpp_proc_ttl_cf;
+    struct rtpp_ebpf *rtpp_ebpf_cf;
+    struct rtpp_demux *rtpp_demux_cf;
     struct rtpp_tnotify_set *rtpp_tnset_cf;
     struct rtpp_notify *rtpp_notify_cf;
     struct rtpp_bindaddrs *bindaddrs_cf;
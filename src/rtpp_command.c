@@ -64,6 +64,7 @@
 #include "rtpp_command_ul.h"
 #include "rtpp_command_ver.h"
 #include "rtpp_controlfd.h"
+#include "rtpp_demux.h"
 #include "rtpp_hash_table.h"
 #include "rtpp_mallocs.h"
 #include "rtpp_netio_async.h"
@@ -72,6 +73,7 @@
 #include "rtpp_port_table.h"
 #include "rtpp_stream.h"
 #include "rtpp_session.h"
+#include "rtpp_sessinfo.h"
 #include "rtpp_socket.h"
 #include "rtpp_util.h"
 #include "rtpp_stats.h"
@@ -99,13 +101,14 @@ struct create_twinlistener_args {
     const struct sockaddr *ia;
     struct rtpp_socket **fds;
     int *port;
+    int rtcp_mux;
 };
 
 static int
 create_twinlistener(uint16_t port, void *ap)
 {
     struct sockaddr_storage iac;
-    int rval, i, so_rcvbuf;
+    int rval, i, so_rcvbuf, nfds;
     struct create_twinlistener_args *ctap;
 
     ctap = (struct create_twinlistener_args *)ap;
@@ -113,7 +116,28 @@ create_twinlistener(uint16_t port, void *ap)
     ctap->fds[0] = ctap->fds[1] = NULL;
 
     rval = RTPP_PTU_BRKERR;
-    for (i = 0; i < 2; i++) {
+    /*
+     * With rtcp-mux only the RTP socket is created, the port pair is still
+     * reserved in the port table so that the layout does not change.
+     */
+    nfds = (ctap->rtcp_mux != 0) ? 1 : 2;
+    if (ctap->cfs->rtpp_demux_cf != NULL) {
+        /* No sockets of our own, see rtpp_demux.c */
+        for (i = 0; i < nfds; i++) {
+            ctap->fds[i] = rtpp_demux_skt_ctor(ctap->cfs->rtpp_demux_cf,
+              ctap->ia, port + i);
+            if (ctap->fds[i] == NULL) {
+                if (errno == EADDRINUSE || errno == EINVAL)
+                    rval = RTPP_PTU_ONEMORE;
+                goto failure;
+            }
+            if (ctap->cfs->tos >= 0)
+                CALL_METHOD(ctap->fds[i], settos, ctap->cfs->tos);
+        }
+        port += nfds;
+        goto done;
+    }
+    for (i = 0; i < nfds; i++) {
 	ctap->fds[i] = rtpp_socket_ctor(ctap->ia->sa_family, SOCK_DGRAM);
 	if (ctap->fds[i] == NULL) {
 	    RTPP_ELOG(ctap->cfs->glog, RTPP_LOG_ERR, "can't create %s socket",
@@ -135,14 +159,33 @@ create_twinlistener(uint16_t port, void *ap)
 	if ((ctap->ia->sa_family == AF_INET) && (ctap->cfs->tos >= 0) &&
 	  (CALL_METHOD(ctap->fds[i], settos, ctap->cfs->tos) == -1))
 	    RTPP_ELOG(ctap->cfs->glog, RTPP_LOG_ERR, "unable to set TOS to %d", ctap->cfs->tos);
-	so_rcvbuf = 256 * 1024;
+	so_rcvbuf = (i == 0) ? MEDIA_RBUF_SIZE : MEDIA_RBUF_RTCP;
 	if (CALL_METHOD(ctap->fds[i], setrbuf, so_rcvbuf) == -1)
-	    RTPP_ELOG(ctap->cfs->glog, RTPP_LOG_ERR, "unable to set 256K receive buffer size");
+	    RTPP_ELOG(ctap->cfs->glog, RTPP_LOG_ERR, "unable to set %dK receive buffer size",
+	      so_rcvbuf / 1024);
         if (CALL_METHOD(ctap->fds[i], setnonblock) < 0)
             goto failure;
         CALL_METHOD(ctap->fds[i], settimestamp);
+        if (ctap->cfs->udp_gro != 0 &&
+          CALL_METHOD(ctap->fds[i], setgro) != 0)
+            RTPP_ELOG(ctap->cfs->glog, RTPP_LOG_ERR, "unable to enable UDP_GRO");
+        if (ctap->cfs->busy_poll_usecs > 0 &&
+          CALL_METHOD(ctap->fds[i], setbusypoll, ctap->cfs->busy_poll_usecs) != 0)
+            RTPP_ELOG(ctap->cfs->glog, RTPP_LOG_ERR, "unable to enable SO_BUSY_POLL");
+        if (ctap->cfs->txtime != 0 &&
+          CALL_METHOD(ctap->fds[i], settxtime) != 0)
+            RTPP_ELOG(ctap->cfs->glog, RTPP_LOG_ERR, "unable to enable SO_TXTIME");
+        if (ctap->cfs->connect_latched != 0)
+            CALL_METHOD(ctap->fds[i], setconnect);
+        if (ctap->cfs->bpf_filter != 0)
+            CALL_METHOD(ctap->fds[i], setsrcfilter);
+    }
+done:
+    *ctap->port = port - nfds;
+    if (ctap->rtcp_mux != 0) {
+        ctap->fds[1] = ctap->fds[0];
+        RTPP_OBJ_INCREF(ctap->fds[1]);
     }
-    *ctap->port = port - 2;
     return RTPP_PTU_OK;
 
 failure:
@@ -156,7 +199,7 @@ failure:
 
 int
 rtpp_create_listener(const struct rtpp_cfg *cfsp, const struct sockaddr *ia, int *port,
-  struct rtpp_socket **fds)
+  struct rtpp_socket **fds, int rtcp_mux)
 {
     struct create_twinlistener_args cta;
     int i;
@@ -167,6 +210,7 @@ rtpp_create_listener(const struct rtpp_cfg *cfsp, const struct sockaddr *ia, int
     cta.fds = fds;
     cta.ia = ia;
     cta.port = port;
+    cta.rtcp_mux = rtcp_mux;
 
     for (i = 0; i < 2; i++)
         fds[i] = NULL;
@@ -441,7 +485,7 @@ etoomany:
 int
 handle_command(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd)
 {
-    int i, verbose, rval;
+    int i, verbose, rval, shard;
     char *cp;
     char *recording_name;
     struct rtpp_session *spa;
@@ -639,6 +683,9 @@ handle_command(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd)
 
     case PLAY:
         rtpp_command_play_handle(spa->rtp->stream[i], cmd);
+        /* Played by the worker that owns the session, get it to pick this up */
+        shard = CALL_METHOD(cfsp->sessinfo, get_shard, spa->seuid);
+        CALL_METHOD(cfsp->sessinfo, wakeup, shard);
 	break;
 
     case COPY:
@@ -45,6 +45,18 @@
 #include "rtpp_util.h"
 #include "rtpp_command_copy.h"
 
+/*
+ * Packets that are relayed in-kernel would bypass the recorder, make sure
+ * they come through us from now on.
+ */
+static void
+handle_copy_offload_reset(struct rtpp_session *spa, int idx)
+{
+
+    CALL_SMETHOD(spa->rtp->stream[idx], offload_reset);
+    CALL_SMETHOD(spa->rtcp->stream[idx], offload_reset);
+}
+
 int
 handle_copy(const struct rtpp_cfg *cfsp, struct rtpp_session *spa, int idx, char *rname,
   int record_single_file)
@@ -74,6 +86,7 @@ handle_copy(const struct rtpp_cfg *cfsp, struct rtpp_session *spa, int idx, char
             RTPP_LOG(spa->log, RTPP_LOG_INFO,
               "starting recording RTCP session on port %d", spa->rtcp->stream[idx]->port);
         }
+        handle_copy_offload_reset(spa, idx);
         return (0);
     }
 
@@ -88,10 +101,12 @@ handle_copy(const struct rtpp_cfg *cfsp, struct rtpp_session *spa, int idx, char
     if (spa->rtcp->stream[idx]->rrc == NULL && cfsp->rrtcp != 0) {
         spa->rtcp->stream[idx]->rrc = rtpp_record_open(cfsp, spa, rname, idx, RECORD_RTCP);
         if (spa->rtcp->stream[idx]->rrc == NULL) {
+            handle_copy_offload_reset(spa, idx);
             return (-1);
         }
         RTPP_LOG(spa->log, RTPP_LOG_INFO,
           "starting recording RTCP session on port %d", spa->rtcp->stream[idx]->port);
     }
+    handle_copy_offload_reset(spa, idx);
     return (0);
 }
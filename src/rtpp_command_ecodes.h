@@ -50,6 +50,7 @@
 #define ECODE_PARSE_6     17
 #define ECODE_PARSE_7     18
 #define ECODE_PARSE_8     19
+#define ECODE_PARSE_17    20
 
 #define ECODE_RTOOBIG_1   25
 #define ECODE_RTOOBIG_2   26
@@ -160,6 +160,18 @@ handle_query(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd,
               pst[1].npkts_in);
             continue;
         }
+        if (strcmp(cmd->args.v[i], "nkdropped_ina") == 0) {
+            PULL_PCNT_STRM();
+            len += snprintf(cmd->buf_t + len, sizeof(cmd->buf_t) - len, "%lu",
+              pst[0].nkdropped);
+            continue;
+        }
+        if (strcmp(cmd->args.v[i], "nkdropped_ino") == 0) {
+            PULL_PCNT_STRM();
+            len += snprintf(cmd->buf_t + len, sizeof(cmd->buf_t) - len, "%lu",
+              pst[1].nkdropped);
+            continue;
+        }
         if (strcmp(cmd->args.v[i], "nrelayed") == 0) {
             PULL_PCNT();
             len += snprintf(cmd->buf_t + len, sizeof(cmd->buf_t) - len, "%lu",
@@ -172,6 +184,12 @@ handle_query(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd,
               pcnts.ndropped);
             continue;
         }
+        if (strcmp(cmd->args.v[i], "npoliced") == 0) {
+            PULL_PCNT();
+            len += snprintf(cmd->buf_t + len, sizeof(cmd->buf_t) - len, "%lu",
+              pcnts.npoliced);
+            continue;
+        }
         if (strcmp(cmd->args.v[i], "rtpa_nsent") == 0) {
             PULL_RST();
             len += snprintf(cmd->buf_t + len, sizeof(cmd->buf_t) - len, "%lu",
@@ -60,6 +60,7 @@
 #include "rtpp_session.h"
 #include "rtpp_sessinfo.h"
 #include "rtpp_socket.h"
+#include "rtpp_stats.h"
 #include "rtp_resizer.h"
 #include "rtpp_mallocs.h"
 #include "rtpp_network.h"
@@ -95,6 +96,9 @@ struct ul_opts {
     const char *notify_tag;
     int pf;
     int new_port;
+    int rtcp_mux;
+    int police_pps;
+    int police_kbps;
 
     int onhold;
 };
@@ -128,6 +132,7 @@ ul_opts_init(const struct rtpp_cfg *cfsp, struct ul_opts *ulop)
 
     ulop->asymmetric = (cfsp->aforce != 0) ? 1 : 0;
     ulop->requested_ptime = -1;
+    ulop->police_pps = ulop->police_kbps = -1;
     ulop->lia[0] = ulop->lia[1] = ulop->reply.ia = cfsp->bindaddr[0];
     ulop->lidx = 1;
     ulop->pf = AF_INET;
@@ -156,6 +161,7 @@ struct ul_opts *
 rtpp_command_ul_opts_parse(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd)
 {
     int len, tpf, n, i;
+    long pps, kbps;
     char c;
     char *cp, *t, *notify_tag;
     const char *errmsg;
@@ -244,6 +250,26 @@ rtpp_command_ul_opts_parse(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd
             cp--;
             break;
 
+        case 'p':
+        case 'P':
+            /* p<pps>[,<kbps>], 0 - no limit */
+            pps = strtol(cp + 1, &t, 10);
+            kbps = 0;
+            if (t != cp + 1 && *t == ',') {
+                cp = t;
+                kbps = strtol(cp + 1, &t, 10);
+            }
+            if (t == cp + 1 || pps < 0 || pps > RTPP_POLICE_PPS_MAX ||
+              kbps < 0 || kbps > RTPP_POLICE_KBPS_MAX) {
+                RTPP_LOG(cmd->glog, RTPP_LOG_ERR, "command syntax error");
+                reply_error(cmd, ECODE_PARSE_17);
+                goto err_undo_1;
+            }
+            ulop->police_pps = pps;
+            ulop->police_kbps = kbps;
+            cp = t - 1;
+            break;
+
         case 'c':
         case 'C':
             cp += 1;
@@ -329,6 +355,11 @@ rtpp_command_ul_opts_parse(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd
             ulop->new_port = 1;
             break;
 
+        case 'm':
+        case 'M':
+            ulop->rtcp_mux = 1;
+            break;
+
         default:
             RTPP_LOG(cmd->glog, RTPP_LOG_ERR, "unknown command modifier `%c'",
               *cp);
@@ -397,7 +428,7 @@ handle_nomem(struct rtpp_command *cmd, int ecode, struct rtpp_session *spa)
 int
 rtpp_command_ul_handle(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd, int sidx)
 {
-    int pidx, lport, sessions_active;
+    int pidx, lport, sessions_active, rtcp_mux;
     struct rtpp_socket *fds[2];
     const char *actor;
     struct rtpp_session *spa, *spb;
@@ -426,15 +457,22 @@ rtpp_command_ul_handle(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd, in
             if (ulop->local_addr != NULL) {
                 spa->rtp->stream[sidx]->laddr = ulop->local_addr;
             }
-            if (rtpp_create_listener(cfsp, spa->rtp->stream[sidx]->laddr, &lport, fds) == -1) {
+            rtcp_mux = (spa->rtcp_mux != 0 || ulop->rtcp_mux != 0);
+            if (rtpp_create_listener(cfsp, spa->rtp->stream[sidx]->laddr, &lport,
+              fds, rtcp_mux) == -1) {
                 RTPP_LOG(spa->log, RTPP_LOG_ERR, "can't create listener");
                 reply_error(cmd, ECODE_LSTFAIL_1);
                 goto err_undo_0;
             }
+            if (rtcp_mux != 0 && spa->rtcp_mux == 0) {
+                RTPP_LOG(spa->log, RTPP_LOG_INFO, "enabling rtcp-mux");
+                spa->rtcp_mux = 1;
+            }
             if (fd != NULL && ulop->new_port != 0) {
                 RTPP_LOG(spa->log, RTPP_LOG_INFO,
                   "new port requested, releasing %d/%d, replacing with %d/%d",
-                  spa->rtp->stream[sidx]->port, spa->rtcp->stream[sidx]->port, lport, lport + 1);
+                  spa->rtp->stream[sidx]->port, spa->rtcp->stream[sidx]->port, lport,
+                  rtcp_mux ? lport : lport + 1);
                 CALL_METHOD(cfsp->sessinfo, update, spa, sidx, fds);
             } else {
                 CALL_METHOD(cfsp->sessinfo, append, spa, sidx, fds);
@@ -442,15 +480,27 @@ rtpp_command_ul_handle(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd, in
             RTPP_OBJ_DECREF(fds[0]);
             RTPP_OBJ_DECREF(fds[1]);
             spa->rtp->stream[sidx]->port = lport;
-            spa->rtcp->stream[sidx]->port = lport + 1;
+            spa->rtcp->stream[sidx]->port = rtcp_mux ? lport : lport + 1;
             if (spa->complete == 0) {
+                int ndrained;
+
                 cmd->csp->nsess_complete.cnt++;
                 CALL_METHOD(spa->rtp->stream[0]->ttl, reset_with,
                   cfsp->max_ttl);
                 CALL_METHOD(spa->rtp->stream[1]->ttl, reset_with,
                   cfsp->max_ttl);
+                spa->complete = 1;
+                ndrained = CALL_METHOD(cfsp->sessinfo, activate, spa);
+                if (ndrained > 0) {
+                    CALL_SMETHOD(cfsp->rtpp_stats, updatebyname,
+                      "npkts_discard", ndrained);
+                }
             }
-            spa->complete = 1;
+        } else if (ulop->rtcp_mux != 0 &&
+          spa->rtp->stream[sidx]->rtcp_mux == 0) {
+            /* Existing sockets stay as they are */
+            RTPP_LOG(spa->log, RTPP_LOG_WARN, "rtcp-mux can't be enabled on "
+              "the established stream without a new port, ignored");
         }
         if (fd != NULL) {
             RTPP_OBJ_DECREF(fd);
@@ -497,7 +547,8 @@ rtpp_command_ul_handle(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd, in
             reply_error(cmd, cfsp->overload_prot.ecode);
             goto err_undo_0;
         }
-        if (rtpp_create_listener(cfsp, ulop->lia[0], &lport, fds) == -1) {
+        if (rtpp_create_listener(cfsp, ulop->lia[0], &lport, fds,
+          ulop->rtcp_mux) == -1) {
             RTPP_LOG(cmd->glog, RTPP_LOG_ERR, "can't create listener");
             reply_error(cmd, ECODE_LSTFAIL_2);
             goto err_undo_0;
@@ -586,6 +637,14 @@ rtpp_command_ul_handle(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd, in
     }
 
     if (ulop->ia[0] != NULL && ulop->ia[1] != NULL) {
+        /*
+         * Peer expects RTCP on its RTP port if the socket it talks to is
+         * muxed, or, before that socket is there, if it has asked for it.
+         */
+        if ((spa->rtp->stream[pidx]->port != 0) ?
+          (spa->rtp->stream[pidx]->rtcp_mux != 0) : (ulop->rtcp_mux != 0)) {
+            setport(ulop->ia[1], getport(ulop->ia[0]));
+        }
         CALL_SMETHOD(spa->rtp->stream[pidx], prefill_addr, &(ulop->ia[0]),
           cmd->dtime->mono);
         CALL_SMETHOD(spa->rtcp->stream[pidx], prefill_addr, &(ulop->ia[1]),
@@ -600,6 +659,10 @@ rtpp_command_ul_handle(const struct rtpp_cfg *cfsp, struct rtpp_command *cmd, in
         CALL_SMETHOD(spa->rtp->stream[pidx], locklatch);
         CALL_SMETHOD(spa->rtcp->stream[pidx], locklatch);
     }
+    if (ulop->police_pps >= 0) {
+        CALL_SMETHOD(spa->rtp->stream[pidx], set_police, ulop->police_pps,
+          ulop->police_kbps);
+    }
     if (spa->rtp->stream[pidx]->codecs != NULL) {
         free(spa->rtp->stream[pidx]->codecs);
         spa->rtp->stream[pidx]->codecs = NULL;
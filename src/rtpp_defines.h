@@ -41,6 +41,9 @@
 #define	SESSION_TIMEOUT	60	/* in ticks */
 #define	TOS		0xb8
 #define	LBR_THRS	128	/* low-bitrate threshold */
+#define	MEDIA_RBUF_SIZE	(64 * 1024)	/* initial SO_RCVBUF of the RTP sockets */
+#define	MEDIA_RBUF_RTCP	(8 * 1024)	/* initial SO_RCVBUF of the RTCP sockets */
+#define	MEDIA_RBUF_MAX	(2 * 1024 * 1024) /* upper limit for the SO_RCVBUF */
 #define	CPORT		"22222"
 #define	MAX_RTP_RATE	100
 #define	POLL_RATE	(MAX_RTP_RATE * 2)	/* target number of poll(2) calls per second */
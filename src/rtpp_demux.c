@@ -0,0 +1,878 @@
+/*
+ * Copyright (c) 2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#if HAVE_LINUX_BPF_H
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/udp.h>
+#include <pthread.h>
+#include <linux/bpf.h>
+#include <unistd.h>
+#endif
+
+#include "rtpp_types.h"
+#include "rtpp_refcnt.h"
+#include "rtpp_mallocs.h"
+#include "rtpp_cfg.h"
+#include "rtpp_demux.h"
+
+#if HAVE_LINUX_BPF_H && defined(__NR_bpf)
+#include "rtpp_socket.h"
+#include "rtpp_socket_fin.h"
+#include "rtpp_netio_async.h"
+#include "rtpp_network.h"
+#include "rtpp_netaddr.h"
+#include "rtpp_ip_chksum.h"
+#include "rtp.h"
+#include "rtpp_time.h"
+#include "rtp_packet.h"
+#include "rtpp_debug.h"
+
+#define RTPP_DEMUX_NFAM         2
+#define RTPP_DEMUX_NPORTS       65536
+/* Receive buffer of the shared sockets, they take traffic of many streams */
+#define RTPP_DEMUX_RBUF         (8 * 1024 * 1024)
+/* Port is taken by a socket that is not attached to any stream (yet) */
+#define RTPP_DEMUX_CLAIMED      (~(uint64_t)0)
+
+static const int rtpp_demux_fams[RTPP_DEMUX_NFAM] = {AF_INET, AF_INET6};
+
+#define RTPP_DEMUX_FIDX(af)     ((af) == AF_INET6 ? 1 : 0)
+
+/*
+ * Single-port demultiplexing mode. Instead of one bound socket per port
+ * allocated from the rtpp_port_table, each forwarding worker gets one
+ * socket per address family bound to an ephemeral port, and an sk_lookup
+ * BPF program steers datagrams addressed to the ports that we have handed
+ * out into the socket of the worker that owns the session. Port is then
+ * mapped back into the stream via the ptab[] table, the original
+ * destination address and port are reported by the kernel along with
+ * each datagram (IP_ORIGDSTADDR).
+ *
+ * Streams get a lightweight stand-in rtpp_socket that holds the port and
+ * sends from it by building UDP/IP headers in front of the payload and
+ * passing the result to the per-family IPPROTO_RAW socket.
+ */
+struct rtpp_demux_priv {
+    struct rtpp_demux pub;
+    int nshards;
+    /* Shared receive sockets, [fidx * nshards + shard], NULL if n/a */
+    struct rtpp_socket **rskts;
+    /* IPPROTO_RAW sockets to send from, -1 if the family is n/a */
+    int sfds[RTPP_DEMUX_NFAM];
+    /* Stream UID by port, RTPP_DEMUX_CLAIMED or RTPP_UID_NONE */
+    _Atomic(uint64_t) *ptab[RTPP_DEMUX_NFAM];
+    /* Port -> rskts[] index + 1, 0 if the port is not to be steered */
+    int portmap_fd;
+    int sockmap_fd;
+    int prog_fd;
+    int link_fd;
+};
+
+struct rtpp_demux_skt {
+    struct rtpp_socket pub;
+    struct rtpp_demux_priv *demux;
+    struct sockaddr_storage laddr;
+    int fidx;
+    int port;
+    int tos;
+    struct rtpp_anetio_sstate sstate;
+    /*
+     * IPv6 raw sockets take protocol number in place of the port, so the
+     * destination has to be re-written before it's handed to the sender.
+     */
+    pthread_mutex_t raw6_lock;
+    struct rtpp_netaddr *raw6_dst;
+};
+
+static int
+sys_bpf(int cmd, union bpf_attr *attr)
+{
+
+    return (syscall(__NR_bpf, cmd, attr, sizeof(*attr)));
+}
+
+#define EI(c, d, s, o, i) ((struct bpf_insn){.code = (c), .dst_reg = (d), \
+  .src_reg = (s), .off = (o), .imm = (i)})
+#define E(insn) (code[n++] = (insn))
+#define MOV_R(d, s)     E(EI(BPF_ALU64 | BPF_MOV | BPF_X, d, s, 0, 0))
+#define MOV_K(d, k)     E(EI(BPF_ALU64 | BPF_MOV | BPF_K, d, 0, 0, k))
+#define ADD_K(d, k)     E(EI(BPF_ALU64 | BPF_ADD | BPF_K, d, 0, 0, k))
+#define LDX(sz, d, s, o) E(EI(BPF_LDX | BPF_MEM | (sz), d, s, o, 0))
+#define STX(sz, d, s, o) E(EI(BPF_STX | BPF_MEM | (sz), d, s, o, 0))
+#define CALL(f)         E(EI(BPF_JMP | BPF_CALL, 0, 0, 0, f))
+#define EXIT()          E(EI(BPF_JMP | BPF_EXIT, 0, 0, 0, 0))
+#define JMP_K(op, d, k, o) E(EI(BPF_JMP | (op) | BPF_K, d, 0, o, k))
+#define LD_MAP(d, fd) \
+    do { \
+        E(EI(BPF_LD | BPF_DW | BPF_IMM, d, BPF_PSEUDO_MAP_FD, 0, fd)); \
+        E(EI(0, 0, 0, 0, 0)); \
+    } while (0)
+/* Conditional jump to the "pass" exit, offset is fixed up at the end */
+#define JPASS(op, d, k) \
+    do { \
+        fixup[nfix++] = n; \
+        E(EI(BPF_JMP | (op) | BPF_K, d, 0, 0, k)); \
+    } while (0)
+
+#define R0      BPF_REG_0
+#define R1      BPF_REG_1
+#define R2      BPF_REG_2
+#define R3      BPF_REG_3
+#define R6      BPF_REG_6
+#define R7      BPF_REG_7
+#define FP      BPF_REG_10
+
+/* Stack layout */
+#define FP_PKEY         (-4)
+#define FP_SKEY         (-8)
+
+#define SKL_OFF(f)      ((int)offsetof(struct bpf_sk_lookup, f))
+
+static int
+rtpp_demux_mkprog(int portmap_fd, int sockmap_fd, struct bpf_insn *code)
+{
+    int n, i, nfix;
+    int fixup[8];
+
+    n = nfix = 0;
+    MOV_R(R6, R1);
+    LDX(BPF_W, R2, R6, SKL_OFF(protocol));
+    JPASS(BPF_JNE, R2, IPPROTO_UDP);
+
+    /* Port map key: local port, offset by the family */
+    LDX(BPF_W, R3, R6, SKL_OFF(local_port));
+    LDX(BPF_W, R2, R6, SKL_OFF(family));
+    JMP_K(BPF_JNE, R2, AF_INET6, 1);
+    ADD_K(R3, RTPP_DEMUX_NPORTS);
+    STX(BPF_W, FP, R3, FP_PKEY);
+    LD_MAP(R1, portmap_fd);
+    MOV_R(R2, FP);
+    ADD_K(R2, FP_PKEY);
+    CALL(BPF_FUNC_map_lookup_elem);
+    JPASS(BPF_JEQ, R0, 0);
+    LDX(BPF_W, R3, R0, 0);
+    JPASS(BPF_JEQ, R3, 0);
+
+    /* Hand it over to the owner's socket */
+    ADD_K(R3, -1);
+    STX(BPF_W, FP, R3, FP_SKEY);
+    LD_MAP(R1, sockmap_fd);
+    MOV_R(R2, FP);
+    ADD_K(R2, FP_SKEY);
+    CALL(BPF_FUNC_map_lookup_elem);
+    JPASS(BPF_JEQ, R0, 0);
+    MOV_R(R7, R0);
+    MOV_R(R1, R6);
+    MOV_R(R2, R7);
+    MOV_K(R3, 0);
+    CALL(BPF_FUNC_sk_assign);
+    MOV_R(R1, R7);
+    CALL(BPF_FUNC_sk_release);
+
+    /* Pass */
+    for (i = 0; i < nfix; i++)
+        code[fixup[i]].off = n - fixup[i] - 1;
+    MOV_K(R0, SK_PASS);
+    EXIT();
+    return (n);
+}
+
+#undef EI
+#undef E
+#undef MOV_R
+#undef MOV_K
+#undef ADD_K
+#undef LDX
+#undef STX
+#undef CALL
+#undef EXIT
+#undef JMP_K
+#undef LD_MAP
+#undef JPASS
+
+static int
+rtpp_demux_map_update(int map_fd, uint32_t key, uint32_t value)
+{
+    union bpf_attr attr;
+
+    memset(&attr, '\0', sizeof(attr));
+    attr.map_fd = map_fd;
+    attr.key = (uintptr_t)&key;
+    attr.value = (uintptr_t)&value;
+    attr.flags = BPF_ANY;
+    return (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr));
+}
+
+static int
+rtpp_demux_map_create(int map_type, int max_entries)
+{
+    union bpf_attr attr;
+
+    memset(&attr, '\0', sizeof(attr));
+    attr.map_type = map_type;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = max_entries;
+    return (sys_bpf(BPF_MAP_CREATE, &attr));
+}
+
+static struct rtpp_socket *
+rtpp_demux_rskt_ctor(int af)
+{
+    struct rtpp_socket *skt;
+    struct sockaddr_storage ss;
+    int fd, sval;
+
+    skt = rtpp_socket_ctor(af, SOCK_DGRAM);
+    if (skt == NULL)
+        return (NULL);
+    memset(&ss, '\0', sizeof(ss));
+    ss.ss_family = af;
+    if (CALL_METHOD(skt, bind2, sstosa(&ss), SA_LEN(sstosa(&ss))) != 0)
+        goto e0;
+    fd = CALL_METHOD(skt, getfd);
+    sval = 1;
+    if (setsockopt(fd, (af == AF_INET) ? IPPROTO_IP : IPPROTO_IPV6,
+      (af == AF_INET) ? IP_RECVORIGDSTADDR : IPV6_RECVORIGDSTADDR, &sval,
+      sizeof(sval)) != 0)
+        goto e0;
+    sval = RTPP_DEMUX_RBUF;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &sval, sizeof(sval)) != 0)
+        CALL_METHOD(skt, setrbuf, sval);
+    if (CALL_METHOD(skt, setnonblock) < 0)
+        goto e0;
+    CALL_METHOD(skt, settimestamp);
+    return (skt);
+e0:
+    RTPP_OBJ_DECREF(skt);
+    return (NULL);
+}
+
+static void
+rtpp_demux_dtor(struct rtpp_demux_priv *pvt)
+{
+    int i;
+
+    if (pvt->link_fd >= 0)
+        close(pvt->link_fd);
+    if (pvt->prog_fd >= 0)
+        close(pvt->prog_fd);
+    if (pvt->sockmap_fd >= 0)
+        close(pvt->sockmap_fd);
+    if (pvt->portmap_fd >= 0)
+        close(pvt->portmap_fd);
+    for (i = 0; i < RTPP_DEMUX_NFAM; i++) {
+        if (pvt->sfds[i] >= 0)
+            close(pvt->sfds[i]);
+        free(pvt->ptab[i]);
+    }
+    if (pvt->rskts != NULL) {
+        for (i = 0; i < RTPP_DEMUX_NFAM * pvt->nshards; i++) {
+            if (pvt->rskts[i] != NULL)
+                RTPP_OBJ_DECREF(pvt->rskts[i]);
+        }
+        free(pvt->rskts);
+    }
+    free(pvt);
+}
+
+struct rtpp_demux *
+rtpp_demux_ctor(const struct rtpp_cfg *cfsp, char *ebuf, size_t elen)
+{
+    struct rtpp_demux_priv *pvt;
+    struct bpf_insn code[64];
+    union bpf_attr attr;
+    int i, j, k, af, nsfds, nsfd;
+
+    pvt = rtpp_rzmalloc(sizeof(*pvt), PVT_RCOFFS(pvt));
+    if (pvt == NULL) {
+        snprintf(ebuf, elen, "out of memory");
+        goto e0;
+    }
+    pvt->portmap_fd = pvt->sockmap_fd = pvt->prog_fd = pvt->link_fd = -1;
+    for (i = 0; i < RTPP_DEMUX_NFAM; i++)
+        pvt->sfds[i] = -1;
+    CALL_SMETHOD(pvt->pub.rcnt, attach, (rtpp_refcnt_dtor_t)&rtpp_demux_dtor,
+      pvt);
+    pvt->nshards = (cfsp->nworkers > 0) ? cfsp->nworkers : 1;
+    pvt->rskts = rtpp_zmalloc(sizeof(pvt->rskts[0]) * RTPP_DEMUX_NFAM *
+      pvt->nshards);
+    if (pvt->rskts == NULL) {
+        snprintf(ebuf, elen, "out of memory");
+        goto e1;
+    }
+
+    pvt->portmap_fd = rtpp_demux_map_create(BPF_MAP_TYPE_ARRAY,
+      RTPP_DEMUX_NFAM * RTPP_DEMUX_NPORTS);
+    if (pvt->portmap_fd < 0) {
+        snprintf(ebuf, elen, "can't create BPF port map: %s",
+          strerror(errno));
+        goto e1;
+    }
+    pvt->sockmap_fd = rtpp_demux_map_create(BPF_MAP_TYPE_SOCKMAP,
+      RTPP_DEMUX_NFAM * pvt->nshards);
+    if (pvt->sockmap_fd < 0) {
+        snprintf(ebuf, elen, "can't create BPF socket map: %s",
+          strerror(errno));
+        goto e1;
+    }
+
+    nsfds = 0;
+    for (i = 0; i < RTPP_DEMUX_NFAM; i++) {
+        af = rtpp_demux_fams[i];
+        nsfd = socket(af, SOCK_RAW, IPPROTO_RAW);
+        if (nsfd < 0) {
+            if (errno == EAFNOSUPPORT)
+                continue;
+            snprintf(ebuf, elen, "can't create %s raw socket: %s",
+              AF2STR(af), strerror(errno));
+            goto e1;
+        }
+        pvt->sfds[i] = nsfd;
+        nsfds++;
+        pvt->ptab[i] = rtpp_zmalloc(sizeof(pvt->ptab[i][0]) *
+          RTPP_DEMUX_NPORTS);
+        if (pvt->ptab[i] == NULL) {
+            snprintf(ebuf, elen, "out of memory");
+            goto e1;
+        }
+        for (j = 0; j < pvt->nshards; j++) {
+            k = i * pvt->nshards + j;
+            pvt->rskts[k] = rtpp_demux_rskt_ctor(af);
+            if (pvt->rskts[k] == NULL) {
+                snprintf(ebuf, elen, "can't create %s socket: %s",
+                  AF2STR(af), strerror(errno));
+                goto e1;
+            }
+            if (rtpp_demux_map_update(pvt->sockmap_fd, k,
+              CALL_METHOD(pvt->rskts[k], getfd)) != 0) {
+                snprintf(ebuf, elen, "can't add socket into the BPF map: %s",
+                  strerror(errno));
+                goto e1;
+            }
+        }
+    }
+    if (nsfds == 0) {
+        snprintf(ebuf, elen, "no address family is available");
+        goto e1;
+    }
+
+    memset(&attr, '\0', sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_SK_LOOKUP;
+    attr.expected_attach_type = BPF_SK_LOOKUP;
+    attr.insns = (uintptr_t)code;
+    attr.insn_cnt = rtpp_demux_mkprog(pvt->portmap_fd, pvt->sockmap_fd, code);
+    attr.license = (uintptr_t)"Dual BSD/GPL";
+    pvt->prog_fd = sys_bpf(BPF_PROG_LOAD, &attr);
+    if (pvt->prog_fd < 0) {
+        snprintf(ebuf, elen, "can't load BPF program: %s", strerror(errno));
+        goto e1;
+    }
+    nsfd = open("/proc/self/ns/net", O_RDONLY | O_CLOEXEC);
+    if (nsfd < 0) {
+        snprintf(ebuf, elen, "can't open network namespace: %s",
+          strerror(errno));
+        goto e1;
+    }
+    memset(&attr, '\0', sizeof(attr));
+    attr.link_create.prog_fd = pvt->prog_fd;
+    attr.link_create.target_fd = nsfd;
+    attr.link_create.attach_type = BPF_SK_LOOKUP;
+    pvt->link_fd = sys_bpf(BPF_LINK_CREATE, &attr);
+    close(nsfd);
+    if (pvt->link_fd < 0) {
+        snprintf(ebuf, elen, "can't attach BPF program: %s", strerror(errno));
+        goto e1;
+    }
+    return (&pvt->pub);
+
+e1:
+    RTPP_OBJ_DECREF(&(pvt->pub));
+e0:
+    return (NULL);
+}
+
+/*
+ * Return idx'th shared socket that the forwarding worker shard has to poll,
+ * NULL when there are no more.
+ */
+struct rtpp_socket *
+rtpp_demux_get_rskt(struct rtpp_demux *pub, int shard, int idx)
+{
+    struct rtpp_demux_priv *pvt;
+    struct rtpp_socket *skt;
+    int i;
+
+    PUB2PVT(pub, pvt);
+    RTPP_DBG_ASSERT(shard >= 0 && shard < pvt->nshards);
+    for (i = 0; i < RTPP_DEMUX_NFAM; i++) {
+        skt = pvt->rskts[i * pvt->nshards + shard];
+        if (skt == NULL)
+            continue;
+        if (idx-- == 0)
+            return (skt);
+    }
+    return (NULL);
+}
+
+static void
+rtpp_demux_setport(struct rtpp_demux_priv *pvt, int fidx, int port,
+  uint32_t value)
+{
+
+    rtpp_demux_map_update(pvt->portmap_fd, fidx * RTPP_DEMUX_NPORTS + port,
+      value);
+}
+
+/*
+ * Attach the port held by the skt to the stream and have its datagrams
+ * steered to the given worker, or detach it if stuid is RTPP_UID_NONE.
+ */
+void
+rtpp_demux_reg(struct rtpp_demux *pub, struct rtpp_socket *skt, int shard,
+  uint64_t stuid)
+{
+    struct rtpp_demux_priv *pvt;
+    struct rtpp_demux_skt *spvt;
+
+    PUB2PVT(pub, pvt);
+    PUB2PVT(skt, spvt);
+    RTPP_DBG_ASSERT(spvt->demux == pvt);
+    if (stuid == RTPP_UID_NONE) {
+        rtpp_demux_setport(pvt, spvt->fidx, spvt->port, 0);
+        atomic_store(&pvt->ptab[spvt->fidx][spvt->port], RTPP_DEMUX_CLAIMED);
+        return;
+    }
+    atomic_store(&pvt->ptab[spvt->fidx][spvt->port], stuid);
+    rtpp_demux_setport(pvt, spvt->fidx, spvt->port,
+      spvt->fidx * pvt->nshards + shard + 1);
+}
+
+/*
+ * Map local address and port that the datagram has been received on into
+ * the UID of the stream, RTPP_UID_NONE if there is none.
+ */
+uint64_t
+rtpp_demux_lookup(struct rtpp_demux *pub, const struct sockaddr *laddr)
+{
+    struct rtpp_demux_priv *pvt;
+    uint64_t stuid;
+    int fidx;
+
+    PUB2PVT(pub, pvt);
+    if (laddr == NULL ||
+      (laddr->sa_family != AF_INET && laddr->sa_family != AF_INET6))
+        return (RTPP_UID_NONE);
+    fidx = RTPP_DEMUX_FIDX(laddr->sa_family);
+    if (pvt->ptab[fidx] == NULL)
+        return (RTPP_UID_NONE);
+    stuid = atomic_load(&pvt->ptab[fidx][getport(laddr)]);
+    return ((stuid == RTPP_DEMUX_CLAIMED) ? RTPP_UID_NONE : stuid);
+}
+
+/*
+ * Put UDP and IP headers in front of the dlen bytes of payload that
+ * follow. Without the source address the kernel picks one and the UDP
+ * checksum is left out, which is only valid for the IPv4.
+ */
+static size_t
+rtpp_demux_mkhdr(unsigned char *bp, const struct sockaddr *src,
+  const struct sockaddr *dst, int sport, size_t dlen, int tos)
+{
+    union {
+        struct ip *v4;
+        struct ip6_hdr *v6;
+    } ipp;
+    struct udphdr *udp;
+    size_t hlen;
+
+    ipp.v4 = (struct ip *)bp;
+    if (dst->sa_family == AF_INET) {
+        memset(ipp.v4, '\0', sizeof(*ipp.v4));
+        ipp.v4->ip_v = 4;
+        ipp.v4->ip_hl = sizeof(*ipp.v4) >> 2;
+        ipp.v4->ip_tos = tos;
+        ipp.v4->ip_len = htons(sizeof(*ipp.v4) + sizeof(*udp) + dlen);
+        ipp.v4->ip_ttl = IPDEFTTL;
+        ipp.v4->ip_p = IPPROTO_UDP;
+        if (src != NULL)
+            ipp.v4->ip_src = satosin(src)->sin_addr;
+        ipp.v4->ip_dst = satosin(dst)->sin_addr;
+        hlen = sizeof(*ipp.v4);
+    } else {
+        memset(ipp.v6, '\0', sizeof(*ipp.v6));
+        ipp.v6->ip6_flow = htonl((6 << 28) | (tos << 20));
+        ipp.v6->ip6_plen = htons(sizeof(*udp) + dlen);
+        ipp.v6->ip6_nxt = IPPROTO_UDP;
+        ipp.v6->ip6_hlim = 64;
+        ipp.v6->ip6_src = satosin6(src)->sin6_addr;
+        ipp.v6->ip6_dst = satosin6(dst)->sin6_addr;
+        hlen = sizeof(*ipp.v6);
+    }
+    udp = (struct udphdr *)(bp + hlen);
+    udp->uh_sport = htons(sport);
+    udp->uh_dport = getnport(dst);
+    udp->uh_ulen = htons(sizeof(*udp) + dlen);
+    udp->uh_sum = 0;
+    hlen += sizeof(*udp);
+    if (src == NULL)
+        return (hlen);
+
+    rtpp_ip_chksum_start();
+    if (dst->sa_family == AF_INET) {
+        rtpp_ip_chksum_update(&ipp.v4->ip_src, sizeof(ipp.v4->ip_src));
+        rtpp_ip_chksum_update(&ipp.v4->ip_dst, sizeof(ipp.v4->ip_dst));
+        rtpp_ip_chksum_pad_v4();
+    } else {
+        rtpp_ip_chksum_update(&ipp.v6->ip6_src, sizeof(ipp.v6->ip6_src));
+        rtpp_ip_chksum_update(&ipp.v6->ip6_dst, sizeof(ipp.v6->ip6_dst));
+        rtpp_ip_chksum_pad_v6();
+    }
+    /* Upper half of the 32-bit IPv6 length is always zero */
+    rtpp_ip_chksum_update(&(udp->uh_ulen), sizeof(udp->uh_ulen));
+    rtpp_ip_chksum_update(&(udp->uh_sport), sizeof(udp->uh_sport));
+    rtpp_ip_chksum_update(&(udp->uh_dport), sizeof(udp->uh_dport));
+    rtpp_ip_chksum_update(&(udp->uh_ulen), sizeof(udp->uh_ulen));
+    rtpp_ip_chksum_update_data(bp + hlen, dlen);
+    rtpp_ip_chksum_fin(udp->uh_sum);
+    if (udp->uh_sum == 0)
+        udp->uh_sum = 0xffff;
+    return (hlen);
+}
+
+static int
+rtpp_demux_skt_send_pkt_na(struct rtpp_socket *self, struct sthread_args *str,
+  struct rtpp_netaddr *daddr, struct rtp_packet *pkt, struct rtpp_log *log)
+{
+    struct rtpp_demux_skt *spvt;
+    struct sockaddr_storage to, from;
+    const struct sockaddr *src;
+    size_t hlen;
+
+    PUB2PVT(self, spvt);
+    if (CALL_SMETHOD(daddr, get, sstosa(&to), sizeof(to)) == 0 ||
+      to.ss_family != spvt->laddr.ss_family)
+        goto drop;
+    hlen = (to.ss_family == AF_INET) ? sizeof(struct ip) :
+      sizeof(struct ip6_hdr);
+    hlen += sizeof(struct udphdr);
+    if (pkt->size + hlen > sizeof(pkt->data.buf))
+        goto drop;
+    src = sstosa(&spvt->laddr);
+    if (ishostnull(src)) {
+        if (to.ss_family == AF_INET) {
+            src = NULL;
+        } else {
+            if (local4remote(sstosa(&to), &from) != 0)
+                goto drop;
+            src = sstosa(&from);
+        }
+    }
+    memmove(pkt->data.buf + hlen, pkt->data.buf, pkt->size);
+    rtpp_demux_mkhdr(pkt->data.buf, src, sstosa(&to), spvt->port, pkt->size,
+      spvt->tos);
+    pkt->size += hlen;
+    if (spvt->raw6_dst != NULL) {
+        int rval;
+
+        satosin6(&to)->sin6_port = 0;
+        pthread_mutex_lock(&spvt->raw6_lock);
+        CALL_SMETHOD(spvt->raw6_dst, set, sstosa(&to),
+          sizeof(struct sockaddr_in6));
+        rval = rtpp_anetio_send_pkt_na(str, spvt->demux->sfds[spvt->fidx],
+          spvt->raw6_dst, pkt, self->rcnt, log, &spvt->sstate);
+        pthread_mutex_unlock(&spvt->raw6_lock);
+        return (rval);
+    }
+    return (rtpp_anetio_send_pkt_na(str, spvt->demux->sfds[spvt->fidx], daddr,
+      pkt, self->rcnt, log, &spvt->sstate));
+drop:
+    RTPP_OBJ_DECREF(pkt);
+    return (-1);
+}
+
+static int
+rtpp_demux_skt_settos(struct rtpp_socket *self, int tos)
+{
+    struct rtpp_demux_skt *spvt;
+
+    PUB2PVT(self, spvt);
+    spvt->tos = tos;
+    return (0);
+}
+
+/*
+ * Rest of the rtpp_socket methods either do not apply, since receiving is
+ * done via the shared sockets, or are not supported.
+ */
+static int
+rtpp_demux_skt_bind(struct rtpp_socket *self, const struct sockaddr *addr,
+  int addrlen)
+{
+
+    errno = EOPNOTSUPP;
+    return (-1);
+}
+
+static int
+rtpp_demux_skt_nop(struct rtpp_socket *self)
+{
+
+    return (0);
+}
+
+static int
+rtpp_demux_skt_nop_i(struct rtpp_socket *self, int arg)
+{
+
+    return (0);
+}
+
+static uint64_t
+rtpp_demux_skt_kdrops(struct rtpp_socket *self, uint64_t *novflw)
+{
+
+    *novflw = 0;
+    return (0);
+}
+
+static int
+rtpp_demux_skt_nosup(struct rtpp_socket *self)
+{
+
+    errno = EOPNOTSUPP;
+    return (-1);
+}
+
+static int
+rtpp_demux_skt_nosup_i(struct rtpp_socket *self, int arg)
+{
+
+    errno = EOPNOTSUPP;
+    return (-1);
+}
+
+static int
+rtpp_demux_skt_seturing(struct rtpp_socket *self, struct rtpp_uring_rxq *rxq)
+{
+
+    errno = EOPNOTSUPP;
+    return (-1);
+}
+
+static int
+rtpp_demux_skt_setpeer(struct rtpp_socket *self, struct rtpp_netaddr *peer,
+  int hostonly)
+{
+
+    return (0);
+}
+
+static struct rtp_packet *
+rtpp_demux_skt_rtp_recv(struct rtpp_socket *self,
+  const struct rtpp_timestamp *dtime, const struct sockaddr *laddr, int port)
+{
+
+    return (NULL);
+}
+
+static int
+rtpp_demux_skt_rtp_recvm(struct rtpp_socket *self,
+  const struct rtpp_timestamp *dtime, const struct sockaddr *laddr, int port,
+  struct rtp_packet **pkts, int npkts)
+{
+
+    return (0);
+}
+
+static int
+rtpp_demux_skt_drain(struct rtpp_socket *self, const char *ptype,
+  struct rtpp_log *log)
+{
+
+    return (0);
+}
+
+static void
+rtpp_demux_skt_dtor(struct rtpp_demux_skt *spvt)
+{
+    struct rtpp_demux_priv *pvt;
+
+    rtpp_socket_fin(&spvt->pub);
+    pvt = spvt->demux;
+    rtpp_demux_setport(pvt, spvt->fidx, spvt->port, 0);
+    atomic_store(&pvt->ptab[spvt->fidx][spvt->port], RTPP_UID_NONE);
+    if (spvt->raw6_dst != NULL) {
+        pthread_mutex_destroy(&spvt->raw6_lock);
+        RTPP_OBJ_DECREF(spvt->raw6_dst);
+    }
+    RTPP_OBJ_DECREF(&pvt->pub);
+    free(spvt);
+}
+
+/*
+ * Take the port on the local address laddr, fails with EADDRINUSE if it
+ * is already taken in the same address family.
+ */
+struct rtpp_socket *
+rtpp_demux_skt_ctor(struct rtpp_demux *pub, const struct sockaddr *laddr,
+  int port)
+{
+    struct rtpp_demux_priv *pvt;
+    struct rtpp_demux_skt *spvt;
+    uint64_t expected;
+    int fidx;
+
+    PUB2PVT(pub, pvt);
+    fidx = RTPP_DEMUX_FIDX(laddr->sa_family);
+    if ((laddr->sa_family != AF_INET && laddr->sa_family != AF_INET6) ||
+      pvt->ptab[fidx] == NULL) {
+        errno = EAFNOSUPPORT;
+        goto e0;
+    }
+    if (!IS_VALID_PORT(port)) {
+        errno = EINVAL;
+        goto e0;
+    }
+    expected = RTPP_UID_NONE;
+    if (!atomic_compare_exchange_strong(&pvt->ptab[fidx][port], &expected,
+      RTPP_DEMUX_CLAIMED)) {
+        errno = EADDRINUSE;
+        goto e0;
+    }
+    spvt = rtpp_rzmalloc(sizeof(*spvt), PVT_RCOFFS(spvt));
+    if (spvt == NULL) {
+        errno = ENOMEM;
+        goto e1;
+    }
+    if (fidx == RTPP_DEMUX_FIDX(AF_INET6)) {
+        spvt->raw6_dst = rtpp_netaddr_ctor();
+        if (spvt->raw6_dst == NULL) {
+            errno = ENOMEM;
+            goto e2;
+        }
+        if (pthread_mutex_init(&spvt->raw6_lock, NULL) != 0) {
+            errno = ENOMEM;
+            goto e3;
+        }
+    }
+    spvt->demux = pvt;
+    memcpy(&spvt->laddr, laddr, SA_LEN(laddr));
+    spvt->fidx = fidx;
+    spvt->port = port;
+    spvt->pub.bind2 = &rtpp_demux_skt_bind;
+    spvt->pub.settos = &rtpp_demux_skt_settos;
+    spvt->pub.setrbuf = &rtpp_demux_skt_nop_i;
+    spvt->pub.getrbuf = &rtpp_demux_skt_nosup;
+    spvt->pub.setnonblock = &rtpp_demux_skt_nop;
+    spvt->pub.settimestamp = &rtpp_demux_skt_nop;
+    spvt->pub.setgro = &rtpp_demux_skt_nosup;
+    spvt->pub.setbusypoll = &rtpp_demux_skt_nosup_i;
+    spvt->pub.settxtime = &rtpp_demux_skt_nosup;
+    spvt->pub.setconnect = &rtpp_demux_skt_nosup;
+    spvt->pub.setsrcfilter = &rtpp_demux_skt_nosup;
+    spvt->pub.setpeer = &rtpp_demux_skt_setpeer;
+    spvt->pub.kdrops = &rtpp_demux_skt_kdrops;
+    spvt->pub.seturing = &rtpp_demux_skt_seturing;
+    spvt->pub.send_pkt_na = &rtpp_demux_skt_send_pkt_na;
+    spvt->pub.rtp_recv = &rtpp_demux_skt_rtp_recv;
+    spvt->pub.rtp_recvm = &rtpp_demux_skt_rtp_recvm;
+    spvt->pub.rx_pending = &rtpp_demux_skt_nop;
+    spvt->pub.rx_backlog = &rtpp_demux_skt_nop;
+    spvt->pub.getfd = &rtpp_demux_skt_nosup;
+    spvt->pub.drain = &rtpp_demux_skt_drain;
+    RTPP_OBJ_INCREF(&pvt->pub);
+    CALL_SMETHOD(spvt->pub.rcnt, attach,
+      (rtpp_refcnt_dtor_t)&rtpp_demux_skt_dtor, spvt);
+    return (&spvt->pub);
+
+e3:
+    RTPP_OBJ_DECREF(spvt->raw6_dst);
+e2:
+    RTPP_OBJ_DECREF(&spvt->pub);
+    free(spvt);
+e1:
+    atomic_store(&pvt->ptab[fidx][port], RTPP_UID_NONE);
+e0:
+    return (NULL);
+}
+#else
+struct rtpp_demux *
+rtpp_demux_ctor(const struct rtpp_cfg *cfsp, char *ebuf, size_t elen)
+{
+
+    snprintf(ebuf, elen, "demultiplexing is not supported on this platform");
+    errno = ENOSYS;
+    return (NULL);
+}
+
+struct rtpp_socket *
+rtpp_demux_get_rskt(struct rtpp_demux *pub, int shard, int idx)
+{
+
+    abort();
+}
+
+struct rtpp_socket *
+rtpp_demux_skt_ctor(struct rtpp_demux *pub, const struct sockaddr *laddr,
+  int port)
+{
+
+    abort();
+}
+
+void
+rtpp_demux_reg(struct rtpp_demux *pub, struct rtpp_socket *skt, int shard,
+  uint64_t stuid)
+{
+
+    abort();
+}
+
+uint64_t
+rtpp_demux_lookup(struct rtpp_demux *pub, const struct sockaddr *laddr)
+{
+
+    abort();
+}
+#endif
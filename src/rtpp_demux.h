@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef _RTPP_DEMUX_H_
+#define _RTPP_DEMUX_H_
+
+struct rtpp_demux;
+struct rtpp_refcnt;
+struct rtpp_socket;
+struct rtpp_cfg;
+struct sockaddr;
+
+struct rtpp_demux {
+    struct rtpp_refcnt *rcnt;
+};
+
+struct rtpp_demux *rtpp_demux_ctor(const struct rtpp_cfg *, char *, size_t);
+struct rtpp_socket *rtpp_demux_get_rskt(struct rtpp_demux *, int, int);
+struct rtpp_socket *rtpp_demux_skt_ctor(struct rtpp_demux *,
+  const struct sockaddr *, int);
+void rtpp_demux_reg(struct rtpp_demux *, struct rtpp_socket *, int,
+  uint64_t);
+uint64_t rtpp_demux_lookup(struct rtpp_demux *, const struct sockaddr *);
+
+#endif
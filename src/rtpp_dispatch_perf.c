@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2018-2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rtpp_types.h"
+#include "rtpp_refcnt.h"
+#include "rtpp_netaddr.h"
+#include "rtpp_pcount.h"
+#include "rtpp_ttl.h"
+
+#define NITER 10000000
+
+#if defined(RTPP_STATIC_DISPATCH)
+#define DISPATCH_MODE "static"
+#else
+#define DISPATCH_MODE "dynamic"
+#endif
+
+static double
+getdtime(void)
+{
+    struct timespec tp;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &tp) == -1)
+        return (-1);
+    return ((double)tp.tv_sec + (double)tp.tv_nsec / 1000000000.0);
+}
+
+/*
+ * Method calls that rtpproxy makes for every relayed packet: source check
+ * against the latched address on the receiving stream, bump of the
+ * stats and of the TTL, sendable check and fetching the destination on
+ * the sending stream, plus a reference taken and dropped as for the packet.
+ */
+static double
+bench_packet(struct rtpp_pcount *pcnt, struct rtpp_ttl *ttl)
+{
+    struct rtpp_netaddr *raddr, *daddr;
+    struct sockaddr_in sin, dst;
+    double stime, etime;
+    long long i, nok;
+
+    raddr = rtpp_netaddr_ctor();
+    daddr = rtpp_netaddr_ctor();
+    if (raddr == NULL || daddr == NULL)
+        return (-1);
+    memset(&sin, '\0', sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sin.sin_port = htons(5000);
+    CALL_SMETHOD(raddr, set, (struct sockaddr *)&sin, sizeof(sin));
+    sin.sin_port = htons(6000);
+    CALL_SMETHOD(daddr, set, (struct sockaddr *)&sin, sizeof(sin));
+    sin.sin_port = htons(5000);
+
+    nok = 0;
+    stime = getdtime();
+    for (i = 0; i < NITER; i++) {
+        RTPP_OBJ_INCREF(raddr);
+        if (!CALL_SMETHOD(raddr, isempty) &&
+          CALL_SMETHOD(raddr, cmp, (struct sockaddr *)&sin, sizeof(sin)) == 0) {
+            CALL_METHOD(pcnt, reg_reld);
+            CALL_METHOD(ttl, reset);
+            if (!CALL_SMETHOD(daddr, isempty) && CALL_SMETHOD(daddr, get,
+              (struct sockaddr *)&dst, sizeof(dst)) == sizeof(dst))
+                nok++;
+        }
+        RTPP_OBJ_DECREF(raddr);
+    }
+    etime = getdtime();
+
+    RTPP_OBJ_DECREF(daddr);
+    RTPP_OBJ_DECREF(raddr);
+    if (nok != NITER)
+        return (-1);
+    return ((etime - stime) * 1000000000.0 / NITER);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct rtpp_pcount *pcnt;
+    struct rtpp_ttl *ttl;
+    struct rtpps_pcount stats;
+    double stime, etime, ppkt;
+    long long i, rem;
+
+    pcnt = rtpp_pcount_ctor();
+    ttl = rtpp_ttl_ctor(NITER);
+    if (pcnt == NULL || ttl == NULL)
+        return (1);
+
+    rem = 0;
+    stime = getdtime();
+    for (i = 0; i < NITER; i++) {
+        RTPP_OBJ_INCREF(pcnt);
+        CALL_METHOD(pcnt, reg_reld);
+        CALL_METHOD(ttl, reset);
+        rem += CALL_METHOD(ttl, get_remaining);
+        RTPP_OBJ_DECREF(pcnt);
+    }
+    etime = getdtime();
+
+    ppkt = bench_packet(pcnt, ttl);
+
+    CALL_METHOD(pcnt, get_stats, &stats);
+    RTPP_OBJ_DECREF(ttl);
+    RTPP_OBJ_DECREF(pcnt);
+    if (ppkt < 0 || stats.nrelayed != 2 * NITER ||
+      rem != (long long)NITER * NITER)
+        return (1);
+    printf("%s dispatch: %.2f ns per iteration (5 calls)\n", DISPATCH_MODE,
+      (etime - stime) * 1000000000.0 / NITER);
+    printf("%s dispatch: %.2f ns per packet (8 calls)\n", DISPATCH_MODE,
+      ppkt);
+    return (0);
+}
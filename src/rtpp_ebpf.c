@@ -0,0 +1,578 @@
+/*
+ * Copyright (c) 2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#if HAVE_LINUX_BPF_H
+#include <sys/syscall.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/netlink.h>
+#include <linux/pkt_cls.h>
+#include <linux/pkt_sched.h>
+#include <linux/rtnetlink.h>
+#include <unistd.h>
+#endif
+
+#include "rtpp_mallocs.h"
+#include "rtpp_ebpf.h"
+
+#if HAVE_LINUX_BPF_H && defined(__NR_bpf)
+#define RTPP_EBPF_MAXIFS        16
+#define RTPP_EBPF_MAXENTS       65536
+#define RTPP_EBPF_TC_PRIO       0xc0de
+#define RTPP_EBPF_TC_HANDLE     1
+
+/*
+ * Offload of the plain relaying to the TC ingress hook. The map is keyed by
+ * the inbound leg of each flow, the program looks up every IPv4 UDP packet
+ * received on the interface(s) and if there is a matching entry that can
+ * be forwarded via FIB rewrites addresses and ports into those of the
+ * outbound leg, decrements the TTL and redirects the packet to the egress
+ * interface. Anything else, including packets for local destinations,
+ * packets for which the route or neighbour is not known yet and packets
+ * whose TTL would expire, is passed to us unmodified.
+ */
+struct rtpp_ebpf {
+    int map_fd;
+    int prog_fd;
+    int nifs;
+    int ifindex[RTPP_EBPF_MAXIFS];
+};
+
+static int
+sys_bpf(int cmd, union bpf_attr *attr)
+{
+
+    return (syscall(__NR_bpf, cmd, attr, sizeof(*attr)));
+}
+
+#define EI(c, d, s, o, i) ((struct bpf_insn){.code = (c), .dst_reg = (d), \
+  .src_reg = (s), .off = (o), .imm = (i)})
+#define E(insn) (code[n++] = (insn))
+#define MOV_R(d, s)     E(EI(BPF_ALU64 | BPF_MOV | BPF_X, d, s, 0, 0))
+#define MOV_K(d, k)     E(EI(BPF_ALU64 | BPF_MOV | BPF_K, d, 0, 0, k))
+#define ADD_K(d, k)     E(EI(BPF_ALU64 | BPF_ADD | BPF_K, d, 0, 0, k))
+#define AND_K(d, k)     E(EI(BPF_ALU64 | BPF_AND | BPF_K, d, 0, 0, k))
+#define LDX(sz, d, s, o) E(EI(BPF_LDX | BPF_MEM | (sz), d, s, o, 0))
+#define STX(sz, d, s, o) E(EI(BPF_STX | BPF_MEM | (sz), d, s, o, 0))
+#define ST_K(sz, d, o, k) E(EI(BPF_ST | BPF_MEM | (sz), d, 0, o, k))
+#define XADD(d, s, o)   E(EI(BPF_STX | BPF_ATOMIC | BPF_DW, d, s, o, BPF_ADD))
+#define CALL(f)         E(EI(BPF_JMP | BPF_CALL, 0, 0, 0, f))
+#define EXIT()          E(EI(BPF_JMP | BPF_EXIT, 0, 0, 0, 0))
+#define LD_MAP(d, fd) \
+    do { \
+        E(EI(BPF_LD | BPF_DW | BPF_IMM, d, BPF_PSEUDO_MAP_FD, 0, fd)); \
+        E(EI(0, 0, 0, 0, 0)); \
+    } while (0)
+/* Conditional jump to the "pass" exit, offset is fixed up at the end */
+#define JPASS(op, d, s, k) \
+    do { \
+        fixup[nfix++] = n; \
+        E(EI(BPF_JMP | (op) | ((s) != 0 ? BPF_X : BPF_K), d, s, 0, k)); \
+    } while (0)
+
+#define R0      BPF_REG_0
+#define R1      BPF_REG_1
+#define R2      BPF_REG_2
+#define R3      BPF_REG_3
+#define R4      BPF_REG_4
+#define R5      BPF_REG_5
+#define R6      BPF_REG_6
+#define R7      BPF_REG_7
+#define FP      BPF_REG_10
+
+/* Packet layout, no VLAN tags and no IP options */
+#define OFF_IP          ETH_HLEN
+#define OFF_UDP         (OFF_IP + 20)
+#define HDRS_LEN        (OFF_UDP + 8)
+/* Stack layout */
+#define FP_KEY          (-16)
+#define FP_TTL          (FP_KEY - 8)
+#define FP_FIB          (FP_TTL - (int)sizeof(struct bpf_fib_lookup))
+
+#define FIB_OFF(f)      (FP_FIB + (int)offsetof(struct bpf_fib_lookup, f))
+#define SKB_OFF(f)      ((int)offsetof(struct __sk_buff, f))
+#define ENT_OFF(f)      ((int)offsetof(struct rtpp_ebpf_ent, f))
+#define FLOW_OFF(f)     ((int)offsetof(struct rtpp_ebpf_flow, f))
+
+static int
+rtpp_ebpf_mkprog(int map_fd, struct bpf_insn *code)
+{
+    int n, i, nfix;
+    int fixup[16];
+
+    n = nfix = 0;
+    MOV_R(R6, R1);
+    LDX(BPF_W, R2, R6, SKB_OFF(data));
+    LDX(BPF_W, R3, R6, SKB_OFF(data_end));
+    MOV_R(R4, R2);
+    ADD_K(R4, HDRS_LEN);
+    JPASS(BPF_JGT, R4, R3, 0);
+    LDX(BPF_H, R4, R2, 12);
+    JPASS(BPF_JNE, R4, 0, htons(ETH_P_IP));
+    LDX(BPF_B, R4, R2, OFF_IP);
+    JPASS(BPF_JNE, R4, 0, 0x45);
+    LDX(BPF_B, R4, R2, OFF_IP + 9);
+    JPASS(BPF_JNE, R4, 0, IPPROTO_UDP);
+    LDX(BPF_H, R4, R2, OFF_IP + 6);
+    AND_K(R4, htons(0x3fff));
+    JPASS(BPF_JNE, R4, 0, 0);
+    LDX(BPF_B, R4, R2, OFF_IP + 8);
+    JPASS(BPF_JLE, R4, 0, 1);
+    /* TTL and protocol, as a 16-bit word for the checksum update */
+    LDX(BPF_H, R4, R2, OFF_IP + 8);
+    STX(BPF_H, FP, R4, FP_TTL);
+    ADD_K(R4, -(int)htons(0x0100));
+    STX(BPF_H, FP, R4, FP_TTL + 2);
+
+    /* Key: source and destination addresses and ports, in this order */
+    LDX(BPF_W, R4, R2, OFF_IP + 12);
+    STX(BPF_W, FP, R4, FP_KEY + FLOW_OFF(saddr));
+    LDX(BPF_W, R4, R2, OFF_IP + 16);
+    STX(BPF_W, FP, R4, FP_KEY + FLOW_OFF(daddr));
+    LDX(BPF_W, R4, R2, OFF_UDP);
+    STX(BPF_W, FP, R4, FP_KEY + FLOW_OFF(sport));
+    LD_MAP(R1, map_fd);
+    MOV_R(R2, FP);
+    ADD_K(R2, FP_KEY);
+    CALL(BPF_FUNC_map_lookup_elem);
+    JPASS(BPF_JEQ, R0, 0, 0);
+    MOV_R(R7, R0);
+    LDX(BPF_W, R1, R7, ENT_OFF(flags));
+    JPASS(BPF_JNE, R1, 0, 0);
+
+    /* Route the rewritten packet */
+    MOV_K(R1, 0);
+    for (i = 0; i < (int)sizeof(struct bpf_fib_lookup); i += 8)
+        STX(BPF_DW, FP, R1, FP_FIB + i);
+    ST_K(BPF_B, FP, FIB_OFF(family), AF_INET);
+    ST_K(BPF_B, FP, FIB_OFF(l4_protocol), IPPROTO_UDP);
+    LDX(BPF_H, R1, R7, ENT_OFF(out.sport));
+    STX(BPF_H, FP, R1, FIB_OFF(sport));
+    LDX(BPF_H, R1, R7, ENT_OFF(out.dport));
+    STX(BPF_H, FP, R1, FIB_OFF(dport));
+    LDX(BPF_W, R1, R6, SKB_OFF(len));
+    ADD_K(R1, -ETH_HLEN);
+    STX(BPF_H, FP, R1, FIB_OFF(tot_len));
+    LDX(BPF_W, R1, R6, SKB_OFF(ingress_ifindex));
+    STX(BPF_W, FP, R1, FIB_OFF(ifindex));
+    LDX(BPF_W, R1, R7, ENT_OFF(out.saddr));
+    STX(BPF_W, FP, R1, FIB_OFF(ipv4_src));
+    LDX(BPF_W, R1, R7, ENT_OFF(out.daddr));
+    STX(BPF_W, FP, R1, FIB_OFF(ipv4_dst));
+    MOV_R(R1, R6);
+    MOV_R(R2, FP);
+    ADD_K(R2, FP_FIB);
+    MOV_K(R3, sizeof(struct bpf_fib_lookup));
+    MOV_K(R4, 0);
+    CALL(BPF_FUNC_fib_lookup);
+    JPASS(BPF_JNE, R0, 0, BPF_FIB_LKUP_RET_SUCCESS);
+
+    /* Rewrite addresses and ports, fixing up the checksums on the way */
+#define CSUM(fn, off, sz, kf, ef, flags) \
+    do { \
+        MOV_R(R1, R6); \
+        MOV_K(R2, off); \
+        LDX(sz, R3, FP, FP_KEY + FLOW_OFF(kf)); \
+        LDX(sz, R4, R7, ENT_OFF(out.ef)); \
+        MOV_K(R5, flags); \
+        CALL(fn); \
+    } while (0)
+    CSUM(BPF_FUNC_l3_csum_replace, OFF_IP + 10, BPF_W, saddr, saddr, 4);
+    CSUM(BPF_FUNC_l3_csum_replace, OFF_IP + 10, BPF_W, daddr, daddr, 4);
+    MOV_R(R1, R6);
+    MOV_K(R2, OFF_IP + 10);
+    LDX(BPF_H, R3, FP, FP_TTL);
+    LDX(BPF_H, R4, FP, FP_TTL + 2);
+    MOV_K(R5, 2);
+    CALL(BPF_FUNC_l3_csum_replace);
+    CSUM(BPF_FUNC_l4_csum_replace, OFF_UDP + 6, BPF_W, saddr, saddr,
+      BPF_F_PSEUDO_HDR | BPF_F_MARK_MANGLED_0 | 4);
+    CSUM(BPF_FUNC_l4_csum_replace, OFF_UDP + 6, BPF_W, daddr, daddr,
+      BPF_F_PSEUDO_HDR | BPF_F_MARK_MANGLED_0 | 4);
+    CSUM(BPF_FUNC_l4_csum_replace, OFF_UDP + 6, BPF_H, sport, sport,
+      BPF_F_MARK_MANGLED_0 | 2);
+    CSUM(BPF_FUNC_l4_csum_replace, OFF_UDP + 6, BPF_H, dport, dport,
+      BPF_F_MARK_MANGLED_0 | 2);
+#undef CSUM
+#define STORE(off, base, boff, len) \
+    do { \
+        MOV_R(R1, R6); \
+        MOV_K(R2, off); \
+        MOV_R(R3, base); \
+        ADD_K(R3, boff); \
+        MOV_K(R4, len); \
+        MOV_K(R5, 0); \
+        CALL(BPF_FUNC_skb_store_bytes); \
+    } while (0)
+    STORE(OFF_IP + 12, R7, ENT_OFF(out.saddr), 8);
+    STORE(OFF_UDP, R7, ENT_OFF(out.sport), 4);
+    STORE(OFF_IP + 8, FP, FP_TTL + 2, 1);
+
+    MOV_K(R1, 1);
+    XADD(R7, R1, ENT_OFF(npkts));
+    LDX(BPF_W, R1, R6, SKB_OFF(len));
+    ADD_K(R1, -HDRS_LEN);
+    XADD(R7, R1, ENT_OFF(nbytes));
+
+    STORE(0, FP, FIB_OFF(dmac), ETH_ALEN);
+    STORE(ETH_ALEN, FP, FIB_OFF(smac), ETH_ALEN);
+#undef STORE
+    LDX(BPF_W, R1, FP, FIB_OFF(ifindex));
+    MOV_K(R2, 0);
+    CALL(BPF_FUNC_redirect);
+    EXIT();
+
+    /* Pass */
+    for (i = 0; i < nfix; i++)
+        code[fixup[i]].off = n - fixup[i] - 1;
+    MOV_K(R0, TC_ACT_OK);
+    EXIT();
+    return (n);
+}
+
+#undef EI
+#undef E
+#undef MOV_R
+#undef MOV_K
+#undef ADD_K
+#undef AND_K
+#undef LDX
+#undef STX
+#undef ST_K
+#undef XADD
+#undef CALL
+#undef EXIT
+#undef LD_MAP
+#undef JPASS
+
+static int
+rtpp_ebpf_nlattr(struct nlmsghdr *nlh, size_t maxlen, int type,
+  const void *data, size_t alen)
+{
+    struct rtattr *rta;
+    size_t len;
+
+    len = RTA_LENGTH(alen);
+    if (NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(len) > maxlen)
+        return (-1);
+    rta = (struct rtattr *)((char *)nlh + NLMSG_ALIGN(nlh->nlmsg_len));
+    rta->rta_type = type;
+    rta->rta_len = len;
+    if (alen > 0)
+        memcpy(RTA_DATA(rta), data, alen);
+    nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(len);
+    return (0);
+}
+
+/*
+ * Send a single rtnetlink request and wait for the acknowledgement, returns
+ * 0 or -1 with errno set from the kernel reply.
+ */
+static int
+rtpp_ebpf_nlreq(struct nlmsghdr *nlh)
+{
+    struct sockaddr_nl sa;
+    union {
+        struct nlmsghdr h;
+        char buf[512];
+    } rep;
+    struct nlmsgerr *nle;
+    int fd, rval;
+    ssize_t len;
+
+    fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0)
+        return (-1);
+    memset(&sa, '\0', sizeof(sa));
+    sa.nl_family = AF_NETLINK;
+    rval = -1;
+    if (sendto(fd, nlh, nlh->nlmsg_len, 0, (struct sockaddr *)&sa,
+      sizeof(sa)) < 0)
+        goto out;
+    len = recv(fd, &rep, sizeof(rep), 0);
+    if (len < 0)
+        goto out;
+    if (!NLMSG_OK(&rep.h, len) || rep.h.nlmsg_type != NLMSG_ERROR) {
+        errno = EPROTO;
+        goto out;
+    }
+    nle = NLMSG_DATA(&rep.h);
+    if (nle->error != 0) {
+        errno = -nle->error;
+        goto out;
+    }
+    rval = 0;
+out:
+    close(fd);
+    return (rval);
+}
+
+static int
+rtpp_ebpf_tc(int ifindex, int prog_fd, int attach)
+{
+    union {
+        struct nlmsghdr h;
+        char buf[256];
+    } req;
+    struct tcmsg *tcm;
+    struct rtattr *opts;
+    uint32_t fd, flags;
+
+#define NLREQ_INIT(type, fl) \
+    do { \
+        memset(&req, '\0', sizeof(req)); \
+        req.h.nlmsg_len = NLMSG_LENGTH(sizeof(*tcm)); \
+        req.h.nlmsg_type = (type); \
+        req.h.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | (fl); \
+        tcm = NLMSG_DATA(&req.h); \
+        tcm->tcm_family = AF_UNSPEC; \
+        tcm->tcm_ifindex = ifindex; \
+    } while (0)
+
+    if (attach) {
+        /* Make sure the clsact qdisc is there, it may be shared */
+        NLREQ_INIT(RTM_NEWQDISC, NLM_F_CREATE);
+        tcm->tcm_handle = TC_H_MAKE(TC_H_CLSACT, 0);
+        tcm->tcm_parent = TC_H_CLSACT;
+        rtpp_ebpf_nlattr(&req.h, sizeof(req), TCA_KIND, "clsact",
+          sizeof("clsact"));
+        if (rtpp_ebpf_nlreq(&req.h) != 0 && errno != EEXIST)
+            return (-1);
+    }
+    NLREQ_INIT(attach ? RTM_NEWTFILTER : RTM_DELTFILTER,
+      attach ? (NLM_F_CREATE | NLM_F_REPLACE) : 0);
+#undef NLREQ_INIT
+    tcm->tcm_parent = TC_H_MAKE(TC_H_CLSACT, TC_H_MIN_INGRESS);
+    tcm->tcm_handle = RTPP_EBPF_TC_HANDLE;
+    tcm->tcm_info = TC_H_MAKE(RTPP_EBPF_TC_PRIO << 16, htons(ETH_P_IP));
+    rtpp_ebpf_nlattr(&req.h, sizeof(req), TCA_KIND, "bpf", sizeof("bpf"));
+    if (attach) {
+        opts = (struct rtattr *)((char *)&req + NLMSG_ALIGN(req.h.nlmsg_len));
+        rtpp_ebpf_nlattr(&req.h, sizeof(req), TCA_OPTIONS, NULL, 0);
+        fd = prog_fd;
+        flags = TCA_BPF_FLAG_ACT_DIRECT;
+        rtpp_ebpf_nlattr(&req.h, sizeof(req), TCA_BPF_FD, &fd, sizeof(fd));
+        rtpp_ebpf_nlattr(&req.h, sizeof(req), TCA_BPF_NAME, "rtpproxy",
+          sizeof("rtpproxy"));
+        rtpp_ebpf_nlattr(&req.h, sizeof(req), TCA_BPF_FLAGS, &flags,
+          sizeof(flags));
+        opts->rta_len = (char *)&req + req.h.nlmsg_len - (char *)opts;
+    }
+    return (rtpp_ebpf_nlreq(&req.h));
+}
+
+struct rtpp_ebpf *
+rtpp_ebpf_ctor(const char *ifnames, char *ebuf, size_t elen)
+{
+    struct rtpp_ebpf *rp;
+    struct bpf_insn code[256];
+    union bpf_attr attr;
+    char *iflist, *ifname, *lasts;
+    int i;
+
+    rp = rtpp_zmalloc(sizeof(*rp));
+    if (rp == NULL) {
+        snprintf(ebuf, elen, "out of memory");
+        goto e0;
+    }
+    iflist = strdup(ifnames);
+    if (iflist == NULL) {
+        snprintf(ebuf, elen, "out of memory");
+        goto e1;
+    }
+    for (ifname = strtok_r(iflist, ",", &lasts); ifname != NULL;
+      ifname = strtok_r(NULL, ",", &lasts)) {
+        if (rp->nifs == RTPP_EBPF_MAXIFS) {
+            snprintf(ebuf, elen, "too many interfaces, %d max",
+              RTPP_EBPF_MAXIFS);
+            goto e2;
+        }
+        rp->ifindex[rp->nifs] = if_nametoindex(ifname);
+        if (rp->ifindex[rp->nifs] == 0) {
+            snprintf(ebuf, elen, "%s: %s", ifname, strerror(errno));
+            goto e2;
+        }
+        rp->nifs++;
+    }
+    free(iflist);
+    if (rp->nifs == 0) {
+        snprintf(ebuf, elen, "no interfaces specified");
+        goto e1;
+    }
+
+    memset(&attr, '\0', sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_HASH;
+    attr.key_size = sizeof(struct rtpp_ebpf_flow);
+    attr.value_size = sizeof(struct rtpp_ebpf_ent);
+    attr.max_entries = RTPP_EBPF_MAXENTS;
+    rp->map_fd = sys_bpf(BPF_MAP_CREATE, &attr);
+    if (rp->map_fd < 0) {
+        snprintf(ebuf, elen, "can't create BPF map: %s", strerror(errno));
+        goto e1;
+    }
+
+    memset(&attr, '\0', sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_SCHED_CLS;
+    attr.insns = (uintptr_t)code;
+    attr.insn_cnt = rtpp_ebpf_mkprog(rp->map_fd, code);
+    attr.license = (uintptr_t)"Dual BSD/GPL";
+    rp->prog_fd = sys_bpf(BPF_PROG_LOAD, &attr);
+    if (rp->prog_fd < 0) {
+        snprintf(ebuf, elen, "can't load BPF program: %s", strerror(errno));
+        goto e3;
+    }
+
+    for (i = 0; i < rp->nifs; i++) {
+        if (rtpp_ebpf_tc(rp->ifindex[i], rp->prog_fd, 1) != 0) {
+            snprintf(ebuf, elen, "can't attach BPF program to ifindex %d: "
+              "%s", rp->ifindex[i], strerror(errno));
+            goto e4;
+        }
+    }
+    return (rp);
+
+e4:
+    while (i-- > 0)
+        rtpp_ebpf_tc(rp->ifindex[i], rp->prog_fd, 0);
+    close(rp->prog_fd);
+e3:
+    close(rp->map_fd);
+    goto e1;
+e2:
+    free(iflist);
+e1:
+    free(rp);
+e0:
+    return (NULL);
+}
+
+void
+rtpp_ebpf_dtor(struct rtpp_ebpf *rp)
+{
+    int i;
+
+    for (i = 0; i < rp->nifs; i++)
+        rtpp_ebpf_tc(rp->ifindex[i], rp->prog_fd, 0);
+    close(rp->prog_fd);
+    close(rp->map_fd);
+    free(rp);
+}
+
+int
+rtpp_ebpf_lookup(struct rtpp_ebpf *rp, const struct rtpp_ebpf_flow *kp,
+  struct rtpp_ebpf_ent *ep)
+{
+    union bpf_attr attr;
+
+    memset(&attr, '\0', sizeof(attr));
+    attr.map_fd = rp->map_fd;
+    attr.key = (uintptr_t)kp;
+    attr.value = (uintptr_t)ep;
+    return (sys_bpf(BPF_MAP_LOOKUP_ELEM, &attr));
+}
+
+int
+rtpp_ebpf_update(struct rtpp_ebpf *rp, const struct rtpp_ebpf_flow *kp,
+  const struct rtpp_ebpf_ent *ep)
+{
+    union bpf_attr attr;
+
+    memset(&attr, '\0', sizeof(attr));
+    attr.map_fd = rp->map_fd;
+    attr.key = (uintptr_t)kp;
+    attr.value = (uintptr_t)ep;
+    attr.flags = BPF_ANY;
+    return (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr));
+}
+
+int
+rtpp_ebpf_delete(struct rtpp_ebpf *rp, const struct rtpp_ebpf_flow *kp)
+{
+    union bpf_attr attr;
+
+    memset(&attr, '\0', sizeof(attr));
+    attr.map_fd = rp->map_fd;
+    attr.key = (uintptr_t)kp;
+    return (sys_bpf(BPF_MAP_DELETE_ELEM, &attr));
+}
+#else
+struct rtpp_ebpf *
+rtpp_ebpf_ctor(const char *ifnames, char *ebuf, size_t elen)
+{
+
+    snprintf(ebuf, elen, "eBPF is not supported on this platform");
+    errno = ENOSYS;
+    return (NULL);
+}
+
+void
+rtpp_ebpf_dtor(struct rtpp_ebpf *rp)
+{
+
+    abort();
+}
+
+int
+rtpp_ebpf_lookup(struct rtpp_ebpf *rp, const struct rtpp_ebpf_flow *kp,
+  struct rtpp_ebpf_ent *ep)
+{
+
+    errno = ENOSYS;
+    return (-1);
+}
+
+int
+rtpp_ebpf_update(struct rtpp_ebpf *rp, const struct rtpp_ebpf_flow *kp,
+  const struct rtpp_ebpf_ent *ep)
+{
+
+    errno = ENOSYS;
+    return (-1);
+}
+
+int
+rtpp_ebpf_delete(struct rtpp_ebpf *rp, const struct rtpp_ebpf_flow *kp)
+{
+
+    errno = ENOSYS;
+    return (-1);
+}
+#endif /* HAVE_LINUX_BPF_H */
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef _RTPP_EBPF_H_
+#define _RTPP_EBPF_H_
+
+struct rtpp_ebpf;
+
+/*
+ * IPv4 UDP flow, addresses and ports in network byte order. Used both as
+ * the lookup key (inbound leg as received by us) and as the rewrite target
+ * (outbound leg as it would have been sent by us).
+ */
+struct rtpp_ebpf_flow {
+    uint32_t saddr;
+    uint32_t daddr;
+    uint16_t sport;
+    uint16_t dport;
+};
+
+#define RTPP_EBPF_F_DISABLED    0x1     /* pass to the userland, keep counters */
+
+struct rtpp_ebpf_ent {
+    struct rtpp_ebpf_flow out;
+    uint32_t flags;
+    /* Maintained by the kernel side */
+    uint64_t npkts;
+    uint64_t nbytes;
+};
+
+struct rtpp_ebpf *rtpp_ebpf_ctor(const char *, char *, size_t);
+void rtpp_ebpf_dtor(struct rtpp_ebpf *);
+int rtpp_ebpf_lookup(struct rtpp_ebpf *, const struct rtpp_ebpf_flow *,
+  struct rtpp_ebpf_ent *);
+int rtpp_ebpf_update(struct rtpp_ebpf *, const struct rtpp_ebpf_flow *,
+  const struct rtpp_ebpf_ent *);
+int rtpp_ebpf_delete(struct rtpp_ebpf *, const struct rtpp_ebpf_flow *);
+
+#endif
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+#if defined(LINUX_XXX) && !defined(_GNU_SOURCE)
+/* Apparently needed for recvmmsg(2) / sendmmsg(2) */
+#define _GNU_SOURCE
+#endif
+
+/*
+ * Loopback benchmark of the UDP GSO/GRO paths: RTP-sized datagrams are
+ * sent from one socket to another in batches, either one datagram per
+ * sendmmsg(2) entry, or NSEGS of them glued together with UDP_SEGMENT
+ * the way the sender thread does it with --udp_gso, and read back with
+ * recvmmsgfromto(), with and without UDP_GRO (--udp_gro). Reports CPU
+ * time per packet, both sides run in this process so the kernel work
+ * on either end is accounted for.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config_pp.h"
+
+#include "rtpp_network_io.h"
+
+#define NPKTS   (1 << 19)
+#define PKT_LEN 172
+#define NSEGS   16
+#define BATCH   256
+
+#if HAVE_RECVMMSG && HAVE_SENDMMSG && defined(UDP_SEGMENT) && defined(UDP_GRO)
+struct bench_socks {
+    int tx;
+    int rx;
+    struct sockaddr_in dst;
+};
+
+static unsigned char rxbufs[RTPP_RXMSG_MAX][65536];
+
+static double
+getcputime(void)
+{
+    struct timespec tp;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &tp) == -1)
+        return (-1);
+    return ((double)tp.tv_sec + (double)tp.tv_nsec / 1000000000.0);
+}
+
+static int
+bench_open(struct bench_socks *bsp, int gro)
+{
+    socklen_t alen;
+    int rcvbuf, on;
+
+    memset(bsp, '\0', sizeof(*bsp));
+    bsp->tx = socket(AF_INET, SOCK_DGRAM, 0);
+    bsp->rx = socket(AF_INET, SOCK_DGRAM, 0);
+    if (bsp->tx == -1 || bsp->rx == -1)
+        return (-1);
+    bsp->dst.sin_family = AF_INET;
+    bsp->dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(bsp->rx, (struct sockaddr *)&bsp->dst, sizeof(bsp->dst)) == -1)
+        return (-1);
+    alen = sizeof(bsp->dst);
+    if (getsockname(bsp->rx, (struct sockaddr *)&bsp->dst, &alen) == -1)
+        return (-1);
+    rcvbuf = 4 * 1024 * 1024;
+    setsockopt(bsp->rx, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    on = 1;
+    if (gro && setsockopt(bsp->rx, SOL_UDP, UDP_GRO, &on, sizeof(on)) == -1)
+        return (-1);
+    return (0);
+}
+
+static void
+bench_close(struct bench_socks *bsp)
+{
+
+    if (bsp->tx != -1)
+        close(bsp->tx);
+    if (bsp->rx != -1)
+        close(bsp->rx);
+}
+
+/* Send npkts datagrams, nsegs to each sendmmsg(2) entry */
+static int
+bench_send(struct bench_socks *bsp, const unsigned char *pkt, int npkts,
+  int nsegs)
+{
+    struct mmsghdr mmsg[BATCH];
+    struct iovec iov[BATCH];
+    union {
+        struct cmsghdr hdr;
+        unsigned char buf[CMSG_SPACE(sizeof(uint16_t))];
+    } cmsgbufs[BATCH];
+    struct cmsghdr *cmsg;
+    struct msghdr *msg;
+    uint16_t segsize;
+    int i, nmsg, off, n;
+
+    for (i = 0; i < npkts; i++) {
+        iov[i].iov_base = (void *)pkt;
+        iov[i].iov_len = PKT_LEN;
+    }
+    segsize = PKT_LEN;
+    memset(mmsg, '\0', sizeof(mmsg));
+    for (nmsg = 0; nmsg * nsegs < npkts; nmsg++) {
+        msg = &mmsg[nmsg].msg_hdr;
+        msg->msg_name = &bsp->dst;
+        msg->msg_namelen = sizeof(bsp->dst);
+        msg->msg_iov = &iov[nmsg * nsegs];
+        msg->msg_iovlen = nsegs;
+        if (nsegs > 1) {
+            msg->msg_control = cmsgbufs[nmsg].buf;
+            msg->msg_controllen = sizeof(cmsgbufs[nmsg].buf);
+            cmsg = CMSG_FIRSTHDR(msg);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(segsize));
+            memcpy(CMSG_DATA(cmsg), &segsize, sizeof(segsize));
+        }
+    }
+    for (off = 0; off < nmsg; off += n) {
+        n = sendmmsg(bsp->tx, mmsg + off, nmsg - off, 0);
+        if (n <= 0)
+            return (-1);
+    }
+    return (0);
+}
+
+/* Read until npkts datagrams are in, coalesced ones count for each segment */
+static int
+bench_recv(struct bench_socks *bsp, int npkts)
+{
+    struct rtpp_rxmsg rmsg[RTPP_RXMSG_MAX];
+    struct sockaddr_storage from[RTPP_RXMSG_MAX], to[RTPP_RXMSG_MAX];
+    struct pollfd pfd;
+    int i, n, nrcvd;
+
+    for (nrcvd = 0; nrcvd < npkts;) {
+        for (i = 0; i < RTPP_RXMSG_MAX; i++) {
+            rmsg[i].buf = rxbufs[i];
+            rmsg[i].len = sizeof(rxbufs[i]);
+            rmsg[i].from = (struct sockaddr *)&from[i];
+            rmsg[i].fromlen = sizeof(from[i]);
+            rmsg[i].to = (struct sockaddr *)&to[i];
+        }
+        n = recvmmsgfromto(bsp->rx, rmsg, RTPP_RXMSG_MAX, SCM_TIMESTAMP);
+        if (n <= 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return (-1);
+            pfd.fd = bsp->rx;
+            pfd.events = POLLIN;
+            if (poll(&pfd, 1, 1000) <= 0)
+                return (-1);
+            continue;
+        }
+        for (i = 0; i < n; i++) {
+            if (rmsg[i].segsize == 0) {
+                if (rmsg[i].size != PKT_LEN)
+                    return (-1);
+                nrcvd++;
+                continue;
+            }
+            if (rmsg[i].segsize != PKT_LEN || rmsg[i].size % PKT_LEN != 0)
+                return (-1);
+            nrcvd += rmsg[i].size / PKT_LEN;
+        }
+    }
+    return (nrcvd == npkts ? 0 : -1);
+}
+
+/*
+ * Returns CPU time per packet in ns, 0 if the kernel does not support
+ * it or -1 on failure.
+ */
+static double
+bench_run(const char *name, int nsegs, int gro)
+{
+    struct bench_socks bs;
+    unsigned char pkt[PKT_LEN];
+    double stime, etime;
+    int i;
+
+    memset(pkt, 0x55, sizeof(pkt));
+    pkt[0] = 0x80;
+    if (bench_open(&bs, gro) == -1) {
+        if (gro && errno == ENOPROTOOPT)
+            goto unsup;
+        goto fail;
+    }
+    stime = getcputime();
+    for (i = 0; i < NPKTS; i += BATCH) {
+        if (bench_send(&bs, pkt, BATCH, nsegs) == -1) {
+            if (i == 0 && nsegs > 1 && (errno == EINVAL ||
+              errno == EOPNOTSUPP || errno == EIO))
+                goto unsup;
+            goto fail;
+        }
+        if (bench_recv(&bs, BATCH) == -1)
+            goto fail;
+    }
+    etime = getcputime();
+    bench_close(&bs);
+    printf("%s, %d packets per datagram: %.2f ns per packet\n", name,
+      nsegs, (etime - stime) * 1000000000.0 / NPKTS);
+    return ((etime - stime) * 1000000000.0 / NPKTS);
+unsup:
+    bench_close(&bs);
+    printf("%s: not supported by the kernel, skipped\n", name);
+    return (0);
+fail:
+    fprintf(stderr, "%s: %s\n", name, strerror(errno));
+    bench_close(&bs);
+    return (-1);
+}
+
+int
+main(int argc, char **argv)
+{
+
+    if (bench_run("sendmmsg/recvmmsg", 1, 0) < 0)
+        return (1);
+    if (bench_run("UDP_SEGMENT sendmmsg/recvmmsg", NSEGS, 0) < 0)
+        return (1);
+    if (bench_run("UDP_SEGMENT sendmmsg/UDP_GRO recvmmsg", NSEGS, 1) < 0)
+        return (1);
+    return (0);
+}
+#else
+int
+main(int argc, char **argv)
+{
+
+    printf("no UDP GSO/GRO support, skipped\n");
+    return (0);
+}
+#endif
@@ -64,19 +64,11 @@ struct alig_help {
 
 #define PpP(p1, p2, type) (type)(((char *)p1) + ((size_t)p2))
 
-void *
-#if !defined(RTPP_CHECK_LEAKS)
-rtpp_rzmalloc(size_t msize, size_t rcntp_offs)
-#else
-rtpp_rzmalloc_memdeb(const struct rtpp_codeptr *mlp, size_t msize, size_t rcntp_offs)
-#endif
+static size_t
+rtpp_rzmalloc_pad(size_t msize)
 {
-    void *rval;
-    struct rtpp_refcnt *rcnt;
-    size_t pad_size, asize;
-    void *rco;
+    size_t pad_size;
 
-    RTPP_DBG_ASSERT(msize >= rcntp_offs + sizeof(struct rtpp_refcnt *));
     if (offsetof(struct alig_help, b) > 1) {
         pad_size = msize % offsetof(struct alig_help, b);
         if (pad_size != 0) {
@@ -85,17 +77,17 @@ rtpp_rzmalloc_memdeb(const struct rtpp_codeptr *mlp, size_t msize, size_t rcntp_
     } else {
         pad_size = 0;
     }
-    asize = msize + pad_size + rtpp_refcnt_osize();
-#if !defined(RTPP_CHECK_LEAKS)
-    rval = malloc(asize);
-#else
-    rval = rtpp_memdeb_malloc(asize, MEMDEB_SYM, mlp);
-#endif
-    if (rval == NULL) {
-        return (NULL);
-    }
+    return (pad_size);
+}
+
+static void *
+rtpp_rzmalloc_fill(void *rval, size_t asize, size_t rcoffs, size_t rcntp_offs)
+{
+    struct rtpp_refcnt *rcnt;
+    void *rco;
+
     memset(rval, '\0', asize);
-    rco = (char *)rval + msize + pad_size;
+    rco = (char *)rval + rcoffs;
     rcnt = rtpp_refcnt_ctor_pa(rco);
     if (rcnt == NULL) {
         goto e1;
@@ -107,3 +99,49 @@ e1:
     free(rval);
     return (NULL);
 }
+
+void *
+#if !defined(RTPP_CHECK_LEAKS)
+rtpp_rzmalloc(size_t msize, size_t rcntp_offs)
+#else
+rtpp_rzmalloc_memdeb(const struct rtpp_codeptr *mlp, size_t msize, size_t rcntp_offs)
+#endif
+{
+    void *rval;
+    size_t pad_size, asize;
+
+    RTPP_DBG_ASSERT(msize >= rcntp_offs + sizeof(struct rtpp_refcnt *));
+    pad_size = rtpp_rzmalloc_pad(msize);
+    asize = msize + pad_size + rtpp_refcnt_osize();
+#if !defined(RTPP_CHECK_LEAKS)
+    rval = malloc(asize);
+#else
+    rval = rtpp_memdeb_malloc(asize, MEMDEB_SYM, mlp);
+#endif
+    if (rval == NULL) {
+        return (NULL);
+    }
+    return (rtpp_rzmalloc_fill(rval, asize, msize + pad_size, rcntp_offs));
+}
+
+#if !defined(RTPP_CHECK_LEAKS)
+/*
+ * Same as the rtpp_rzmalloc(), but the object is placed at the address
+ * that is multiple of the align, for objects that care about where their
+ * members fall with respect to the cache lines.
+ */
+void *
+rtpp_rzmalloc_aligned(size_t msize, size_t rcntp_offs, size_t align)
+{
+    void *rval;
+    size_t pad_size, asize;
+
+    RTPP_DBG_ASSERT(msize >= rcntp_offs + sizeof(struct rtpp_refcnt *));
+    pad_size = rtpp_rzmalloc_pad(msize);
+    asize = msize + pad_size + rtpp_refcnt_osize();
+    if (posix_memalign(&rval, align, asize) != 0) {
+        return (NULL);
+    }
+    return (rtpp_rzmalloc_fill(rval, asize, msize + pad_size, rcntp_offs));
+}
+#endif
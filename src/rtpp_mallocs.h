@@ -40,8 +40,12 @@ void *rtpp_zmalloc(size_t);
 #if defined(RTPP_CHECK_LEAKS)
 #define rtpp_rzmalloc(args...) rtpp_rzmalloc_memdeb(HEREVAL, ## args)
 void *rtpp_rzmalloc_memdeb(HERETYPE, size_t, size_t);
+/* Memory debugger has its own header in front of the block, so no alignment */
+#define rtpp_rzmalloc_aligned(msize, rcntp_offs, align) \
+  rtpp_rzmalloc_memdeb(HEREVAL, (msize), (rcntp_offs))
 #else
 void *rtpp_rzmalloc(size_t, size_t);
+void *rtpp_rzmalloc_aligned(size_t, size_t, size_t);
 #endif
 
 #endif
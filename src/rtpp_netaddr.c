@@ -28,6 +28,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -41,13 +42,24 @@
 #include "rtpp_network.h"
 #include "rtpp_debug.h"
 
+/*
+ * Address is read on the packet path for each packet and changes only
+ * when the stream is (re-)latched or updated, so readers go lock-free
+ * using the sequence counter: it is odd while the update is in progress
+ * and readers retry if it has changed under them. Lock serializes the
+ * writers.
+ */
 struct rtpp_netaddr_priv {
     struct rtpp_netaddr pub;
-    struct sockaddr_storage sas;
+    atomic_uint seq;
     socklen_t rlen;
+    struct sockaddr_storage sas;
     pthread_mutex_t lock;
 };
 
+/* Address itself has to start within the same cache line as the counter */
+RTPP_LAYOUT_FITS(struct rtpp_netaddr_priv, rlen, 1);
+
 static void rtpp_netaddr_set(struct rtpp_netaddr *, const struct sockaddr *, size_t);
 static void rtpp_netaddr_dtor(struct rtpp_netaddr_priv *);
 static void rtpp_netaddr_set(struct rtpp_netaddr *, const struct sockaddr *, size_t);
@@ -60,7 +72,7 @@ static size_t rtpp_netaddr_get(struct rtpp_netaddr *, struct sockaddr *, size_t)
 static size_t rtpp_netaddr_sip_print(struct rtpp_netaddr *, char *, size_t,
   char);
 
-static const struct rtpp_netaddr_smethods rtpp_netaddr_smethods = {
+const struct rtpp_netaddr_smethods rtpp_netaddr_smethods = {
     .set = &rtpp_netaddr_set,
     .isempty = &rtpp_netaddr_isempty,
     .cmp = &rtpp_netaddr_cmp,
@@ -99,16 +111,51 @@ static void
 rtpp_netaddr_set(struct rtpp_netaddr *self, const struct sockaddr *addr, size_t alen)
 {
     struct rtpp_netaddr_priv *pvt;
+    unsigned int seq;
 
     PUB2PVT(self, pvt);
     RTPP_DBG_ASSERT(alen <= sizeof(pvt->sas));
 
     pthread_mutex_lock(&pvt->lock);
+    seq = atomic_load_explicit(&pvt->seq, memory_order_relaxed);
+    atomic_store_explicit(&pvt->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
     memcpy(&pvt->sas, addr, alen);
     pvt->rlen = alen;
+    atomic_store_explicit(&pvt->seq, seq + 2, memory_order_release);
     pthread_mutex_unlock(&pvt->lock);
 }
 
+/*
+ * Take consistent copy of the address, only first salen bytes of it are
+ * copied out, returns its full length. Empty address is copied out as
+ * AF_UNSPEC. Never blocks.
+ */
+static socklen_t
+rtpp_netaddr_snap(struct rtpp_netaddr_priv *pvt, struct sockaddr_storage *sas,
+  size_t salen)
+{
+    unsigned int seq;
+    socklen_t rlen;
+    size_t clen;
+
+    for (;;) {
+        seq = atomic_load_explicit(&pvt->seq, memory_order_acquire);
+        if ((seq & 1) != 0)
+            continue;
+        rlen = pvt->rlen;
+        clen = (rlen < salen) ? rlen : salen;
+        if (clen > 0)
+            memcpy(sas, &pvt->sas, clen);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&pvt->seq, memory_order_relaxed) == seq)
+            break;
+    }
+    if (rlen == 0 && sas != NULL)
+        sas->ss_family = AF_UNSPEC;
+    return (rlen);
+}
+
 static void
 rtpp_netaddr_dtor(struct rtpp_netaddr_priv *pvt)
 {
@@ -125,9 +172,7 @@ rtpp_netaddr_isempty(struct rtpp_netaddr *self)
     int rval;
 
     PUB2PVT(self, pvt);
-    pthread_mutex_lock(&pvt->lock);
-    rval = (pvt->rlen == 0);
-    pthread_mutex_unlock(&pvt->lock);
+    rval = (rtpp_netaddr_snap(pvt, NULL, 0) == 0);
     return (rval);
 }
 
@@ -135,47 +180,37 @@ static int
 rtpp_netaddr_cmp(struct rtpp_netaddr *self, const struct sockaddr *sap, size_t salen)
 {
     struct rtpp_netaddr_priv *pvt;
-    int rval;
+    struct sockaddr_storage sas;
 
     PUB2PVT(self, pvt);
     RTPP_DBG_ASSERT(salen <= sizeof(pvt->sas));
-    pthread_mutex_lock(&pvt->lock);
-    if (salen != pvt->rlen) {
-        rval = -1;
-        goto unlock_and_return;
-    }
-    rval = memcmp(&pvt->sas, sap, salen);
-unlock_and_return:
-    pthread_mutex_unlock(&pvt->lock);
-    return (rval);
+    if (rtpp_netaddr_snap(pvt, &sas, salen) != salen)
+        return (-1);
+    return (memcmp(&sas, sap, salen));
 }
 
 static int
 rtpp_netaddr_isaddrseq(struct rtpp_netaddr *self, const struct sockaddr *sap)
 {
     struct rtpp_netaddr_priv *pvt;
-    int rval;
+    struct sockaddr_storage sas;
 
     PUB2PVT(self, pvt);
-    pthread_mutex_lock(&pvt->lock);
-    RTPP_DBG_ASSERT(pvt->rlen > 0);
-    rval = isaddrseq(sstosa(&pvt->sas), sap);
-    pthread_mutex_unlock(&pvt->lock);
-    return (rval);
+    rtpp_netaddr_snap(pvt, &sas, sizeof(sas));
+    RTPP_DBG_ASSERT(sas.ss_family != AF_UNSPEC);
+    return (isaddrseq(sstosa(&sas), sap));
 }
 
 static int
 rtpp_netaddr_cmphost(struct rtpp_netaddr *self, const struct sockaddr *sap)
 {
     struct rtpp_netaddr_priv *pvt;
-    int rval;
+    struct sockaddr_storage sas;
 
     PUB2PVT(self, pvt);
-    pthread_mutex_lock(&pvt->lock);
-    RTPP_DBG_ASSERT(pvt->rlen > 0);
-    rval = ishostseq(sstosa(&pvt->sas), sap);
-    pthread_mutex_unlock(&pvt->lock);
-    return (rval);
+    rtpp_netaddr_snap(pvt, &sas, sizeof(sas));
+    RTPP_DBG_ASSERT(sas.ss_family != AF_UNSPEC);
+    return (ishostseq(sstosa(&sas), sap));
 }
 
 static void
@@ -192,13 +227,14 @@ static size_t
 rtpp_netaddr_get(struct rtpp_netaddr *self, struct sockaddr *sap, size_t salen)
 {
     struct rtpp_netaddr_priv *pvt;
+    struct sockaddr_storage sas;
+    socklen_t rlen;
 
     PUB2PVT(self, pvt);
-    pthread_mutex_lock(&pvt->lock);
-    RTPP_DBG_ASSERT((salen >= pvt->rlen) && (pvt->rlen > 0));
-    memcpy(sap, &pvt->sas, pvt->rlen);
-    pthread_mutex_unlock(&pvt->lock);
-    return (pvt->rlen);
+    rlen = rtpp_netaddr_snap(pvt, &sas, sizeof(sas));
+    RTPP_DBG_ASSERT((salen >= rlen) && (rlen > 0));
+    memcpy(sap, &sas, rlen);
+    return (rlen);
 }
 
 static size_t
@@ -207,12 +243,12 @@ rtpp_netaddr_sip_print(struct rtpp_netaddr *self, char *buf, size_t blen,
 {
     char *rval;
     struct rtpp_netaddr_priv *pvt;
+    struct sockaddr_storage sas;
 
     PUB2PVT(self, pvt);
-    pthread_mutex_lock(&pvt->lock);
-    RTPP_DBG_ASSERT(pvt->rlen > 0);
-    rval = addrport2char_r(sstosa(&pvt->sas), buf, blen, portsep);
-    pthread_mutex_unlock(&pvt->lock);
+    rtpp_netaddr_snap(pvt, &sas, sizeof(sas));
+    RTPP_DBG_ASSERT(sas.ss_family != AF_UNSPEC);
+    rval = addrport2char_r(sstosa(&sas), buf, blen, portsep);
     RTPP_DBG_ASSERT(rval != NULL);
     return (strlen(rval));
 }
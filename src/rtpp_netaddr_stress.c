@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2018-2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+
+/*
+ * Stress test of the lock-free readers of the rtpp_netaddr: one thread
+ * keeps re-latching the address between an IPv4 and an IPv6 one while
+ * others are comparing and copying it out the way the packet path does.
+ * Any read that sees a mix of the two is a failure.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtpp_types.h"
+#include "rtpp_refcnt.h"
+#include "rtpp_netaddr.h"
+#include "rtpp_network.h"
+
+#define NRELATCH 10000000
+#define NREADERS 3
+
+struct stress_args {
+    struct rtpp_netaddr *na;
+    const struct sockaddr *addrs[2];
+    socklen_t alens[2];
+    atomic_int done;
+    unsigned long nreads;
+    unsigned long nbad;
+};
+
+static void *
+stress_relatch(void *arg)
+{
+    struct stress_args *sap;
+    int i;
+
+    sap = (struct stress_args *)arg;
+    for (i = 0; i < NRELATCH; i++) {
+        CALL_SMETHOD(sap->na, set, sap->addrs[i % 2], sap->alens[i % 2]);
+    }
+    atomic_store(&sap->done, 1);
+    return (NULL);
+}
+
+static void *
+stress_traffic(void *arg)
+{
+    struct stress_args *sap;
+    struct sockaddr_storage tmp;
+    unsigned long nreads, nbad;
+    size_t rlen;
+    int i;
+
+    sap = (struct stress_args *)arg;
+    nreads = nbad = 0;
+    while (atomic_load(&sap->done) == 0) {
+        /*
+         * The address may legitimately flip between any two calls, so
+         * only a mix of the two within the single call counts.
+         */
+        for (i = 0; i < 2; i++) {
+            CALL_SMETHOD(sap->na, cmp, sap->addrs[i], sap->alens[i]);
+        }
+        rlen = CALL_SMETHOD(sap->na, get, sstosa(&tmp), sizeof(tmp));
+        for (i = 0; i < 2; i++) {
+            if (rlen == sap->alens[i] && memcmp(&tmp, sap->addrs[i], rlen) == 0)
+                break;
+        }
+        if (i == 2)
+            nbad++;
+        if (CALL_SMETHOD(sap->na, isempty))
+            nbad++;
+        nreads++;
+    }
+    __atomic_add_fetch(&sap->nreads, nreads, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sap->nbad, nbad, __ATOMIC_RELAXED);
+    return (NULL);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct stress_args sa;
+    struct sockaddr_in a4;
+    struct sockaddr_in6 a6;
+    pthread_t wthr, rthrs[NREADERS];
+    int i;
+
+    memset(&sa, '\0', sizeof(sa));
+    memset(&a4, '\0', sizeof(a4));
+    a4.sin_family = AF_INET;
+    a4.sin_port = htons(12000);
+    inet_pton(AF_INET, "192.0.2.1", &a4.sin_addr);
+    memset(&a6, '\0', sizeof(a6));
+    a6.sin6_family = AF_INET6;
+    a6.sin6_port = htons(34000);
+    inet_pton(AF_INET6, "2001:db8::1", &a6.sin6_addr);
+    sa.addrs[0] = sstosa(&a4);
+    sa.alens[0] = sizeof(a4);
+    sa.addrs[1] = sstosa(&a6);
+    sa.alens[1] = sizeof(a6);
+
+    sa.na = rtpp_netaddr_ctor();
+    if (sa.na == NULL)
+        return (1);
+    CALL_SMETHOD(sa.na, set, sa.addrs[0], sa.alens[0]);
+
+    for (i = 0; i < NREADERS; i++) {
+        if (pthread_create(&rthrs[i], NULL, stress_traffic, &sa) != 0)
+            return (1);
+    }
+    if (pthread_create(&wthr, NULL, stress_relatch, &sa) != 0)
+        return (1);
+    pthread_join(wthr, NULL);
+    for (i = 0; i < NREADERS; i++) {
+        pthread_join(rthrs[i], NULL);
+    }
+    RTPP_OBJ_DECREF(sa.na);
+
+    printf("%d relatches, %lu reads, %lu inconsistent\n", NRELATCH,
+      sa.nreads, sa.nbad);
+    return (sa.nbad == 0 ? 0 : 1);
+}
@@ -25,16 +25,25 @@
  *
  */
 
+#if defined(LINUX_XXX) && !defined(_GNU_SOURCE)
+/* Apparently needed for sendmmsg(2) */
+#define _GNU_SOURCE
+#endif
+
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
 #include <errno.h>
 #include <pthread.h>
 #include <sched.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "config.h"
 
@@ -54,6 +63,7 @@
 #include "rtpp_queue.h"
 #include "rtpp_network.h"
 #include "rtpp_netio_async.h"
+#include "rtpp_uring.h"
 #include "rtpp_mallocs.h"
 #include "rtpp_debug.h"
 #ifdef RTPP_DEBUG_timers
@@ -62,31 +72,477 @@
 #endif
 
 struct sthread_args {
+    struct rtpp_anetio_cf *netio_cf;
     struct rtpp_queue *out_q;
     struct rtpp_log *glog;
     int dmode;
+    /* Glue same-sized datagrams together using UDP_SEGMENT */
+    int gso;
+    /* Submission ring, NULL if sendmmsg(2) / sendto(2) are used instead */
+    struct rtpp_uring *uring;
 #if RTPP_DEBUG_timers
     struct recfilter average_load;
 #endif
     struct rtpp_wi *sigterm;
 };
 
-#define SEND_THREADS 1
-
 struct rtpp_anetio_cf {
-    pthread_t thread_id[SEND_THREADS];
-    struct sthread_args args[SEND_THREADS];
+    int nsenders;
+    /*
+     * Senders are split into that many groups by their index modulo it,
+     * one per forwarding worker, or fewer if there are not enough of them
+     * to go around. A worker and sockets of its shard only use their own
+     * group.
+     */
+    int ngroups;
+    pthread_t *thread_id;
+    struct sthread_args *args;
+    /* Transmit directly from the caller's thread when idle */
+    int inline_send;
+    /* Number of the forwarding threads reporting high load */
+    atomic_int nbusy;
 };
 
 #define RTPP_ANETIO_MAX_RETRY 3
 #define RTPP_ANETIO_BATCH_LEN (RTPQ_LARGE_CB_LEN / 8)
 
+_Static_assert(RTPP_MAX_SENDERS <= RTPP_ANETIO_SIDX_MASK + 1,
+  "sender # does not fit into the rtpp_anetio_sstate");
+
+#if defined(SCM_TXTIME)
+#define RTPP_ANETIO_TXTIME 1
+
+/* Control message buffer for either of UDP_SEGMENT or SCM_TXTIME */
+union rtpp_anetio_cmsgbuf {
+    struct cmsghdr hdr;
+    unsigned char buf[CMSG_SPACE(sizeof(uint64_t))];
+};
+
 static void
-rtpp_anetio_sthread(struct sthread_args *args)
+rtpp_anetio_set_txtime(struct msghdr *msg, union rtpp_anetio_cmsgbuf *cbp,
+  uint64_t txtime)
+{
+    struct cmsghdr *cmsg;
+
+    msg->msg_control = cbp->buf;
+    msg->msg_controllen = CMSG_SPACE(sizeof(txtime));
+    cmsg = CMSG_FIRSTHDR(msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_TXTIME;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(txtime));
+    memcpy(CMSG_DATA(cmsg), &txtime, sizeof(txtime));
+}
+
+/*
+ * Convert departure time from our monotonic clock (which might not be
+ * the CLOCK_MONOTONIC) into what SO_TXTIME expects, 0 if it is due
+ * already.
+ */
+static uint64_t
+rtpp_anetio_txtime(double txtime)
+{
+    struct timespec tp;
+    double delta;
+
+    delta = txtime - getdtime();
+    if (delta <= 0)
+        return (0);
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return ((uint64_t)SEC(&tp) * NSEC_MAX + NSEC(&tp) +
+      (uint64_t)(delta * NSEC_MAX));
+}
+#endif
+
+/*
+ * Compact form of the destination to compare against the peer that the
+ * socket is connect()ed to, 0 if it does not fit (anything but IPv4).
+ */
+static uint64_t
+rtpp_anetio_peerkey(const struct sockaddr *sa, socklen_t salen)
+{
+    const struct sockaddr_in *sin;
+
+    if (sa == NULL || sa->sa_family != AF_INET || salen < sizeof(*sin))
+        return (0);
+    sin = (const struct sockaddr_in *)sa;
+    return (((uint64_t)1 << 48) | ((uint64_t)sin->sin_port << 32) |
+      sin->sin_addr.s_addr);
+}
+
+/*
+ * Non-zero if the destination can be left out and the kernel allowed to
+ * use the cached route, i.e. the socket is still connected to the very
+ * peer that the packet is for. The socket might have been re-connected
+ * or disconnected by the relatch since the packet has been queued.
+ */
+static int
+rtpp_anetio_isconnected(const struct rtpp_wi_pvt *wipp)
+{
+    uint64_t pkey;
+
+    if (wipp->cpeer == NULL)
+        return (0);
+    pkey = rtpp_anetio_peerkey(wipp->sendto, wipp->tolen);
+    return (pkey != 0 && pkey == atomic_load(wipp->cpeer));
+}
+
+#if RTPP_DEBUG_netio >= 1
+static void
+rtpp_anetio_dbg_sendto(struct rtpp_wi_pvt *wipp, int n)
+{
+    char daddr[MAX_AP_STRBUF];
+
+    if (wipp->debug == 0)
+        return;
+    if (wipp->sendto != NULL) {
+        addrport2char_r(wipp->sendto, daddr, sizeof(daddr), ':');
+    } else {
+        strcpy(daddr, "connected");
+    }
+    if (n < 0) {
+        RTPP_ELOG(wipp->log, RTPP_LOG_DBUG,
+          "sendto(%d, %p, %lld, %d, %p (%s), %d) = %d",
+          wipp->sock, wipp->msg, (long long)wipp->msg_len, wipp->flags,
+          wipp->sendto, daddr, wipp->tolen, n);
+    } else if (n < wipp->msg_len) {
+        RTPP_LOG(wipp->log, RTPP_LOG_DBUG,
+          "sendto(%d, %p, %lld, %d, %p (%s), %d) = %d: short write",
+          wipp->sock, wipp->msg, (long long)wipp->msg_len, wipp->flags,
+          wipp->sendto, daddr, wipp->tolen, n);
+#if RTPP_DEBUG_netio >= 2
+    } else {
+        RTPP_LOG(wipp->log, RTPP_LOG_DBUG,
+          "sendto(%d, %p, %d, %d, %p (%s), %d) = %d",
+          wipp->sock, wipp->msg, wipp->msg_len, wipp->flags, wipp->sendto, daddr,
+          wipp->tolen, n);
+#endif
+    }
+}
+#endif
+
+#if HAVE_SENDMMSG
+#if defined(UDP_SEGMENT)
+/* Limits imposed by the kernel on a single UDP_SEGMENT send */
+#define RTPP_ANETIO_GSO_MAXSEGS 64
+#define RTPP_ANETIO_GSO_MAXLEN  65000
+
+/*
+ * Number of messages starting at wipps[0] that can be glued into one
+ * UDP_SEGMENT send: same destination and the same size.
+ */
+static int
+rtpp_anetio_gso_span(struct rtpp_wi_pvt **wipps, int nmsg)
+{
+    size_t tlen;
+    int n;
+
+    tlen = wipps[0]->msg_len;
+    for (n = 1; n < nmsg && n < RTPP_ANETIO_GSO_MAXSEGS; n++) {
+        if (wipps[n]->msg_len != wipps[0]->msg_len ||
+          tlen + wipps[n]->msg_len > RTPP_ANETIO_GSO_MAXLEN)
+            break;
+        if (wipps[0]->txtime != 0 || wipps[n]->txtime != 0)
+            break;
+        if (wipps[n] != wipps[0] && (wipps[n]->tolen != wipps[0]->tolen ||
+          (wipps[0]->tolen != 0 && memcmp(wipps[n]->sendto,
+          wipps[0]->sendto, wipps[0]->tolen) != 0)))
+            break;
+        tlen += wipps[n]->msg_len;
+    }
+    return (n);
+}
+#endif
+
+/*
+ * Send out a run of work items that all share the same socket and flags
+ * using as few sendmmsg(2) calls as possible. Each item is expanded into
+ * wipp->nsend messages. A message that fails with EPERM/ENOBUFS is
+ * retried up to RTPP_ANETIO_MAX_RETRY times, on any other error (or once
+ * retries are exhausted) remaining copies of that item are dropped and
+ * we move on to the next one.
+ *
+ * With UDP GSO enabled back-to-back messages of the same size going to
+ * the same destination are handed to the kernel as a single datagram
+ * with UDP_SEGMENT set, which is then split back on the way out. Should
+ * the kernel refuse it as unsupported (EINVAL, EOPNOTSUPP or EIO), GSO is
+ * turned off for this thread and the run is re-sent message by message.
+ * Other errors drop the glued datagram like any other failed item.
+ */
+static void
+rtpp_anetio_send_run(struct sthread_args *args, struct rtpp_wi **wis, int nwis)
 {
-    int n, nsend, i, send_errno, nretry;
-    struct rtpp_wi *wi, *wis[RTPQ_LARGE_CB_LEN / 8];
+    struct mmsghdr mmsg[RTPP_ANETIO_BATCH_LEN * 2];
+    struct iovec iov[RTPP_ANETIO_BATCH_LEN * 2];
+    struct rtpp_wi_pvt *wipps[RTPP_ANETIO_BATCH_LEN * 2];
+    /* Index of the first message in wipps[] for each of mmsg[] entries */
+    int mfirst[RTPP_ANETIO_BATCH_LEN * 2];
+#if defined(UDP_SEGMENT)
+    union {
+        struct cmsghdr hdr;
+        unsigned char buf[CMSG_SPACE(sizeof(uint16_t))];
+    } cmsgbufs[RTPP_ANETIO_BATCH_LEN];
+    struct cmsghdr *cmsg;
+    uint16_t segsize;
+    int ngso;
+#endif
+#if RTPP_ANETIO_TXTIME
+    union rtpp_anetio_cmsgbuf txbufs[RTPP_ANETIO_BATCH_LEN * 2];
+#endif
     struct rtpp_wi_pvt *wipp;
+    struct msghdr *msg;
+    int i, j, nwipps, nmsg, nseg, off, n, send_errno, nretry;
+
+    nwipps = 0;
+    for (i = 0; i < nwis; i++) {
+        PUB2PVT(wis[i], wipp);
+        for (j = 0; j < wipp->nsend && nwipps < RTPP_ANETIO_BATCH_LEN * 2; j++) {
+            iov[nwipps].iov_base = wipp->msg;
+            iov[nwipps].iov_len = wipp->msg_len;
+            wipps[nwipps] = wipp;
+            nwipps++;
+        }
+    }
+#if defined(UDP_SEGMENT)
+again:
+    ngso = 0;
+#endif
+    nmsg = 0;
+    for (i = 0; i < nwipps; i += nseg) {
+        wipp = wipps[i];
+        msg = &mmsg[nmsg].msg_hdr;
+        memset(msg, '\0', sizeof(*msg));
+        if (!rtpp_anetio_isconnected(wipp)) {
+            msg->msg_name = wipp->sendto;
+            msg->msg_namelen = wipp->tolen;
+        }
+        msg->msg_iov = &iov[i];
+        nseg = 1;
+#if defined(UDP_SEGMENT)
+        if (args->gso != 0)
+            nseg = rtpp_anetio_gso_span(&wipps[i], nwipps - i);
+        if (nseg > 1) {
+            msg->msg_control = cmsgbufs[ngso].buf;
+            msg->msg_controllen = sizeof(cmsgbufs[ngso].buf);
+            cmsg = CMSG_FIRSTHDR(msg);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(segsize));
+            segsize = wipp->msg_len;
+            memcpy(CMSG_DATA(cmsg), &segsize, sizeof(segsize));
+            ngso++;
+        }
+#endif
+#if RTPP_ANETIO_TXTIME
+        if (wipp->txtime != 0)
+            rtpp_anetio_set_txtime(msg, &txbufs[nmsg], wipp->txtime);
+#endif
+        msg->msg_iovlen = nseg;
+        mfirst[nmsg] = i;
+        nmsg++;
+    }
+    PUB2PVT(wis[0], wipp);
+    off = 0;
+    nretry = 0;
+    while (off < nmsg) {
+        n = sendmmsg(wipp->sock, mmsg + off, nmsg - off, wipp->flags);
+        send_errno = (n < 0) ? errno : 0;
+#if RTPP_DEBUG_netio >= 1
+        for (i = 0; i < n; i++)
+            rtpp_anetio_dbg_sendto(wipps[mfirst[off + i]], mmsg[off + i].msg_len);
+        if (n < 0)
+            rtpp_anetio_dbg_sendto(wipps[mfirst[off]], n);
+#endif
+        if (n > 0) {
+            off += n;
+            nretry = 0;
+            continue;
+        }
+        /* "EPERM" is Linux thing, yield and retry */
+        if ((send_errno == EPERM || send_errno == ENOBUFS)
+          && nretry < RTPP_ANETIO_MAX_RETRY) {
+            sched_yield();
+            nretry++;
+            continue;
+        }
+        /* Got disconnected after the check, put the destination back */
+        msg = &mmsg[off].msg_hdr;
+        if (send_errno == EDESTADDRREQ && msg->msg_name == NULL &&
+          wipps[mfirst[off]]->sendto != NULL) {
+            msg->msg_name = wipps[mfirst[off]]->sendto;
+            msg->msg_namelen = wipps[mfirst[off]]->tolen;
+            continue;
+        }
+#if defined(UDP_SEGMENT)
+        /*
+         * Only these mean that the kernel or the device can't do it,
+         * anything else is about this particular datagram.
+         */
+        if (mmsg[off].msg_hdr.msg_iovlen > 1 && (send_errno == EINVAL ||
+          send_errno == EOPNOTSUPP || send_errno == EIO)) {
+            RTPP_ELOG(args->glog, RTPP_LOG_ERR, "sendmmsg() with UDP_SEGMENT "
+              "has failed, disabling UDP GSO");
+            args->gso = 0;
+            /* Re-do whatever is left without GSO */
+            for (i = 0; i < nwipps - mfirst[off]; i++) {
+                wipps[i] = wipps[mfirst[off] + i];
+                iov[i] = iov[mfirst[off] + i];
+            }
+            nwipps = i;
+            goto again;
+        }
+#endif
+        /* Give up on the failing item, including any remaining copies */
+        for (i = off; off < nmsg && wipps[mfirst[off]] == wipps[mfirst[i]]; off++)
+            continue;
+        nretry = 0;
+    }
+}
+#else
+static void
+rtpp_anetio_send_run(struct sthread_args *args, struct rtpp_wi **wis, int nwis)
+{
+    int n, i, send_errno, nretry, conn;
+    struct rtpp_wi_pvt *wipp;
+
+    for (i = 0; i < nwis; i++) {
+        PUB2PVT(wis[i], wipp);
+        nretry = 0;
+        conn = rtpp_anetio_isconnected(wipp);
+        do {
+            n = sendto(wipp->sock, wipp->msg, wipp->msg_len, wipp->flags,
+              conn ? NULL : wipp->sendto, conn ? 0 : wipp->tolen);
+            send_errno = (n < 0) ? errno : 0;
+#if RTPP_DEBUG_netio >= 1
+            rtpp_anetio_dbg_sendto(wipp, n);
+#endif
+            if (n >= 0) {
+                wipp->nsend--;
+            } else {
+                /* "EPERM" is Linux thing, yield and retry */
+                if ((send_errno == EPERM || send_errno == ENOBUFS)
+                  && nretry < RTPP_ANETIO_MAX_RETRY) {
+                    sched_yield();
+                    nretry++;
+                } else if (send_errno == EDESTADDRREQ && conn) {
+                    conn = 0;
+                } else {
+                    break;
+                }
+            }
+        } while (wipp->nsend > 0);
+    }
+}
+#endif /* HAVE_SENDMMSG */
+
+/*
+ * Send out a run of work items through the io_uring, unlike the functions
+ * above the run can span any number of sockets. Each item is expanded
+ * into wipp->nsend messages, messages that fail with a transient error
+ * are re-submitted up to RTPP_ANETIO_MAX_RETRY times. Messages that
+ * follow the failed one on the same socket are cancelled and re-submitted
+ * along with it, so the order on each socket is preserved.
+ */
+static void
+rtpp_anetio_send_uring(struct rtpp_uring *uring, struct rtpp_wi **wis,
+  int nwis)
+{
+    struct rtpp_uring_msg umsg[RTPP_ANETIO_BATCH_LEN * 2];
+    /* Work item that each of umsg[] entries comes from */
+    struct rtpp_wi_pvt *uwipps[RTPP_ANETIO_BATCH_LEN * 2];
+    struct iovec iov[RTPP_ANETIO_BATCH_LEN];
+#if RTPP_ANETIO_TXTIME
+    union rtpp_anetio_cmsgbuf txbufs[RTPP_ANETIO_BATCH_LEN * 2];
+#endif
+    struct rtpp_wi_pvt *wipp, *wipp_k;
+    struct msghdr *msg;
+    char done[RTPP_ANETIO_BATCH_LEN];
+    int i, j, k, nmsg, nretry, nleft;
+
+    for (i = 0; i < nwis; i++) {
+        PUB2PVT(wis[i], wipp);
+        iov[i].iov_base = wipp->msg;
+        iov[i].iov_len = wipp->msg_len;
+        done[i] = 0;
+    }
+    /*
+     * Messages are grouped by socket, keeping the original order within
+     * each group, so that rtpp_uring_sendmsgs() can chain them.
+     */
+    nmsg = 0;
+    for (k = 0; k < nwis; k++) {
+        if (done[k])
+            continue;
+        PUB2PVT(wis[k], wipp_k);
+        for (i = k; i < nwis; i++) {
+            PUB2PVT(wis[i], wipp);
+            if (done[i] || wipp->sock != wipp_k->sock)
+                continue;
+            done[i] = 1;
+            for (j = 0; j < wipp->nsend &&
+              nmsg < RTPP_ANETIO_BATCH_LEN * 2; j++) {
+                umsg[nmsg].sock = wipp->sock;
+                umsg[nmsg].flags = wipp->flags;
+                msg = &umsg[nmsg].msg;
+                memset(msg, '\0', sizeof(*msg));
+                if (!rtpp_anetio_isconnected(wipp)) {
+                    msg->msg_name = wipp->sendto;
+                    msg->msg_namelen = wipp->tolen;
+                }
+                msg->msg_iov = &iov[i];
+                msg->msg_iovlen = 1;
+                uwipps[nmsg] = wipp;
+#if RTPP_ANETIO_TXTIME
+                if (wipp->txtime != 0)
+                    rtpp_anetio_set_txtime(msg, &txbufs[nmsg],
+                      wipp->txtime);
+#endif
+                nmsg++;
+            }
+        }
+    }
+    for (nretry = 0; nmsg > 0; nretry++) {
+        if (rtpp_uring_sendmsgs(uring, umsg, nmsg) < 0)
+            break;
+        if (nretry == RTPP_ANETIO_MAX_RETRY)
+            break;
+        for (i = nleft = 0; i < nmsg; i++) {
+            msg = &umsg[i].msg;
+            switch (-umsg[i].res) {
+            /* Got disconnected after the check */
+            case EDESTADDRREQ:
+                if (msg->msg_name != NULL || uwipps[i]->sendto == NULL)
+                    break;
+                msg->msg_name = uwipps[i]->sendto;
+                msg->msg_namelen = uwipps[i]->tolen;
+                /* Fall through */
+            case EPERM:
+            case ENOBUFS:
+            case EAGAIN:
+            /* Chained behind the one that has failed */
+            case ECANCELED:
+                if (nleft != i) {
+                    umsg[nleft] = umsg[i];
+                    uwipps[nleft] = uwipps[i];
+                }
+                nleft++;
+                break;
+
+            default:
+                break;
+            }
+        }
+        if (nleft > 0)
+            sched_yield();
+        nmsg = nleft;
+    }
+}
+
+static void
+rtpp_anetio_sthread(struct sthread_args *args)
+{
+    int nsend, i, j;
+    struct rtpp_wi *wi, *wis[RTPP_ANETIO_BATCH_LEN];
+    struct rtpp_wi_pvt *wipp, *wipp_j;
 #if RTPP_DEBUG_timers
     double tp[3], runtime, sleeptime;
     long run_n;
@@ -101,57 +557,38 @@ rtpp_anetio_sthread(struct sthread_args *args)
         tp[1] = getdtime();
 #endif
 
-        for (i = 0; i < nsend; i++) {
+        for (i = 0; i < nsend; i = j) {
 	    wi = wis[i];
-            PUB2PVT(wi, wipp);
             if (wi->wi_type == RTPP_WI_TYPE_SGNL) {
                 CALL_METHOD(wi, dtor);
                 goto out;
             }
-            nretry = 0;
-            do {
-                n = sendto(wipp->sock, wipp->msg, wipp->msg_len, wipp->flags,
-                  wipp->sendto, wipp->tolen);
-                send_errno = (n < 0) ? errno : 0;
-#if RTPP_DEBUG_netio >= 1
-                if (wipp->debug != 0) {
-                    char daddr[MAX_AP_STRBUF];
-
-                    addrport2char_r(wipp->sendto, daddr, sizeof(daddr), ':');
-                    if (n < 0) {
-                        RTPP_ELOG(wipp->log, RTPP_LOG_DBUG,
-                          "sendto(%d, %p, %lld, %d, %p (%s), %d) = %d",
-                          wipp->sock, wipp->msg, (long long)wipp->msg_len, wipp->flags,
-                          wipp->sendto, daddr, wipp->tolen, n);
-                    } else if (n < wipp->msg_len) {
-                        RTPP_LOG(wipp->log, RTPP_LOG_DBUG,
-                          "sendto(%d, %p, %lld, %d, %p (%s), %d) = %d: short write",
-                          wipp->sock, wipp->msg, (long long)wipp->msg_len, wipp->flags,
-                          wipp->sendto, daddr, wipp->tolen, n);
-#if RTPP_DEBUG_netio >= 2
-                    } else {
-                        RTPP_LOG(wipp->log, RTPP_LOG_DBUG,
-                          "sendto(%d, %p, %d, %d, %p (%s), %d) = %d",
-                          wipp->sock, wipp->msg, wipp->msg_len, wipp->flags, wipp->sendto, daddr,
-                          wipp->tolen, n);
-#endif
-                    }
-                }
-#endif
-                if (n >= 0) {
-                    wipp->nsend--;
-                } else {
-                    /* "EPERM" is Linux thing, yield and retry */
-                    if ((send_errno == EPERM || send_errno == ENOBUFS)
-                      && nretry < RTPP_ANETIO_MAX_RETRY) {
-                        sched_yield();
-                        nretry++;
-                    } else {
-                        break;
-                    }
+            PUB2PVT(wi, wipp);
+            /*
+             * Group consecutive items going out of the same socket, with
+             * io_uring the whole lot can go in one go.
+             */
+            for (j = i + 1; j < nsend; j++) {
+                if (wis[j]->wi_type == RTPP_WI_TYPE_SGNL)
+                    break;
+                if (args->uring != NULL)
+                    continue;
+                PUB2PVT(wis[j], wipp_j);
+                if (wipp_j->sock != wipp->sock || wipp_j->flags != wipp->flags)
+                    break;
+            }
+            if (args->uring != NULL) {
+                rtpp_anetio_send_uring(args->uring, &wis[i], j - i);
+            } else {
+                rtpp_anetio_send_run(args, &wis[i], j - i);
+            }
+            for (; i < j; i++) {
+                PUB2PVT(wis[i], wipp_j);
+                if (wipp_j->inflight != NULL) {
+                    atomic_fetch_sub(wipp_j->inflight, RTPP_ANETIO_QONE);
                 }
-            } while (wipp->nsend > 0);
-            CALL_METHOD(wi, dtor);
+                CALL_METHOD(wis[i], dtor);
+            }
         }
 #if RTPP_DEBUG_timers
         sleeptime += tp[1] - tp[0];
@@ -202,8 +639,11 @@ rtpp_anetio_sendto(struct rtpp_anetio_cf *netio_cf, int sock, const void *msg, \
 void
 rtpp_anetio_pump(struct rtpp_anetio_cf *netio_cf)
 {
+    int i;
 
-    rtpp_queue_pump(netio_cf->args[0].out_q);
+    for (i = 0; i < netio_cf->nsenders; i++) {
+        rtpp_queue_pump(netio_cf->args[i].out_q);
+    }
 }
 
 void
@@ -213,12 +653,140 @@ rtpp_anetio_pump_q(struct sthread_args *sender)
     rtpp_queue_pump(sender->out_q);
 }
 
+/* Least loaded sender in the group of the sidx, starting from the sidx */
+static int
+rtpp_anetio_pick_idx(struct rtpp_anetio_cf *netio_cf, int sidx)
+{
+    int min_len, l, ri, gstart;
+
+    gstart = sidx % netio_cf->ngroups;
+    min_len = rtpp_queue_get_length(netio_cf->args[sidx].out_q);
+    for (ri = sidx; min_len > 0;) {
+        ri += netio_cf->ngroups;
+        if (ri >= netio_cf->nsenders)
+            ri = gstart;
+        if (ri == sidx)
+            break;
+        l = rtpp_queue_get_length(netio_cf->args[ri].out_q);
+        if (l < min_len) {
+            sidx = ri;
+            min_len = l;
+        }
+    }
+    return (sidx);
+}
+
+/*
+ * Account for one more packet of the socket queued and return the sender
+ * to queue it with. That is whichever the socket has packets in flight
+ * with, or the least loaded one starting from the sidx if there are none.
+ */
+static int
+rtpp_anetio_sock_reserve(struct rtpp_anetio_cf *netio_cf, int sidx,
+  struct rtpp_anetio_sstate *ssp)
+{
+    unsigned int ost, nst;
+
+    ost = atomic_load(&ssp->qstate);
+    do {
+        if (ost < RTPP_ANETIO_QONE) {
+            nst = RTPP_ANETIO_QONE | rtpp_anetio_pick_idx(netio_cf, sidx);
+        } else {
+            nst = ost + RTPP_ANETIO_QONE;
+        }
+    } while (!atomic_compare_exchange_weak(&ssp->qstate, &ost, nst));
+    return (nst & RTPP_ANETIO_SIDX_MASK);
+}
+
+/*
+ * Packets leaving the same socket have to go through the same sender
+ * thread, or they might be re-ordered on the wire. Socket is hashed onto
+ * one of the senders in the group of the calling worker, queue depth is
+ * only taken into account when the socket has nothing in flight (see
+ * rtpp_anetio_sock_reserve()), so that switching to a different sender
+ * cannot overtake packets that are still queued.
+ */
+static struct sthread_args *
+rtpp_anetio_sock_home(struct sthread_args *sender, int sock)
+{
+    struct rtpp_anetio_cf *netio_cf;
+    int gstart, gsize;
+
+    netio_cf = sender->netio_cf;
+    if (netio_cf->nsenders == 1) {
+        return (sender);
+    }
+    gstart = (sender - netio_cf->args) % netio_cf->ngroups;
+    gsize = (netio_cf->nsenders - gstart + netio_cf->ngroups - 1) /
+      netio_cf->ngroups;
+    return (&netio_cf->args[gstart + (sock % gsize) * netio_cf->ngroups]);
+}
+
+/*
+ * Try sending the packet from the calling thread. Only a single attempt
+ * is made for each copy, anything that needs a retry is left to the
+ * sender thread. Returns 0 if all copies have been sent out.
+ */
+static int
+rtpp_anetio_send_inline(struct rtpp_wi_pvt *wipp)
+{
+    int n, conn;
+
+    conn = rtpp_anetio_isconnected(wipp);
+    while (wipp->nsend > 0) {
+        n = sendto(wipp->sock, wipp->msg, wipp->msg_len, wipp->flags,
+          conn ? NULL : wipp->sendto, conn ? 0 : wipp->tolen);
+#if RTPP_DEBUG_netio >= 1
+        rtpp_anetio_dbg_sendto(wipp, n);
+#endif
+        if (n < 0) {
+            if (errno == EPERM || errno == ENOBUFS || errno == EAGAIN)
+                return (-1);
+            /* Got disconnected after the check */
+            if (errno == EDESTADDRREQ && conn) {
+                conn = 0;
+                continue;
+            }
+            /* Not recoverable, sender thread would have dropped it too */
+            return (0);
+        }
+        wipp->nsend--;
+    }
+    return (0);
+}
+
+/*
+ * Record the peer that the socket has been connect()ed to, NULL if it
+ * is about to be re-connected or disconnected. Until then the senders
+ * keep passing the destination along with each packet.
+ */
+void
+rtpp_anetio_setpeer(struct rtpp_anetio_sstate *ssp, const struct sockaddr *sa,
+  socklen_t salen)
+{
+
+    atomic_store(&ssp->cpeer, rtpp_anetio_peerkey(sa, salen));
+}
+
+void
+rtpp_anetio_setbusy(struct rtpp_anetio_cf *netio_cf, int busy)
+{
+
+    if (busy) {
+        atomic_fetch_add(&netio_cf->nbusy, 1);
+    } else {
+        atomic_fetch_sub(&netio_cf->nbusy, 1);
+    }
+}
+
 int
 rtpp_anetio_send_pkt_na(struct sthread_args *sender, int sock, \
   struct rtpp_netaddr *sendto, struct rtp_packet *pkt,
-  struct rtpp_refcnt *sock_rcnt, struct rtpp_log *plog)
+  struct rtpp_refcnt *sock_rcnt, struct rtpp_log *plog,
+  struct rtpp_anetio_sstate *ssp)
 {
     struct rtpp_wi *wi;
+    struct rtpp_wi_pvt *wipp;
     int nsend;
 
     if (sender->dmode != 0 && pkt->size < LBR_THRS) {
@@ -236,9 +804,35 @@ rtpp_anetio_send_pkt_na(struct sthread_args *sender, int sock, \
      * rtpp_wi_malloc_pkt() consumes pkt and returns wi, so no need to
      * call rtp_packet_free() here.
      */
-#if RTPP_DEBUG_netio >= 2
-    struct rtpp_wi_pvt *wipp;
     PUB2PVT(wi, wipp);
+    if (ssp != NULL)
+        wipp->cpeer = &ssp->cpeer;
+#if RTPP_ANETIO_TXTIME
+    if (pkt->txtime != 0 && ssp != NULL && ssp->txtime != 0)
+        wipp->txtime = rtpp_anetio_txtime(pkt->txtime);
+#endif
+    sender = rtpp_anetio_sock_home(sender, sock);
+    /*
+     * Fast path: nothing of ours is in flight, the sender is idle and
+     * none of the forwarding threads is loaded, no point in handing the
+     * packet over to another thread. Paced packets need sendmsg(2) with
+     * the control data, leave them to the sender too.
+     */
+    if (sender->netio_cf->inline_send != 0 && wipp->txtime == 0 &&
+      atomic_load(&sender->netio_cf->nbusy) == 0 &&
+      (ssp == NULL || atomic_load(&ssp->qstate) < RTPP_ANETIO_QONE) &&
+      rtpp_queue_get_length(sender->out_q) == 0) {
+        if (rtpp_anetio_send_inline(wipp) == 0) {
+            CALL_METHOD(wi, dtor);
+            return (0);
+        }
+    }
+    if (ssp != NULL) {
+        sender = &sender->netio_cf->args[rtpp_anetio_sock_reserve(
+          sender->netio_cf, sender - sender->netio_cf->args, ssp)];
+        wipp->inflight = &ssp->qstate;
+    }
+#if RTPP_DEBUG_netio >= 2
     wipp->debug = 1;
     if (plog == NULL) {
         plog = sender->glog;
@@ -253,24 +847,11 @@ rtpp_anetio_send_pkt_na(struct sthread_args *sender, int sock, \
 }
 
 struct sthread_args *
-rtpp_anetio_pick_sender(struct rtpp_anetio_cf *netio_cf)
+rtpp_anetio_pick_sender(struct rtpp_anetio_cf *netio_cf, int wid)
 {
-    int min_len, i, l;
-    struct sthread_args *sender;
 
-    sender = &netio_cf->args[0];
-    min_len = rtpp_queue_get_length(sender->out_q);
-    if (min_len == 0) {
-        return (sender);
-    }
-    for (i = 1; i < SEND_THREADS; i++) {
-        l = rtpp_queue_get_length(netio_cf->args[i].out_q);
-        if (l < min_len) {
-            sender = &netio_cf->args[i];
-            min_len = l;
-        }
-    }
-    return (sender);
+    return (&netio_cf->args[rtpp_anetio_pick_idx(netio_cf,
+      wid % netio_cf->ngroups)]);
 }
 
 struct rtpp_anetio_cf *
@@ -282,8 +863,22 @@ rtpp_netio_async_init(const struct rtpp_cfg *cfsp, int qlen)
     netio_cf = rtpp_zmalloc(sizeof(*netio_cf));
     if (netio_cf == NULL)
         return (NULL);
+    netio_cf->nsenders = (cfsp->nsend_threads > 0) ? cfsp->nsend_threads : 1;
+    netio_cf->ngroups = (cfsp->nworkers > 0) ? cfsp->nworkers : 1;
+    if (netio_cf->ngroups > netio_cf->nsenders)
+        netio_cf->ngroups = netio_cf->nsenders;
+    netio_cf->inline_send = cfsp->inline_send;
+    netio_cf->thread_id = rtpp_zmalloc(sizeof(netio_cf->thread_id[0]) *
+      netio_cf->nsenders);
+    if (netio_cf->thread_id == NULL)
+        goto e0;
+    netio_cf->args = rtpp_zmalloc(sizeof(netio_cf->args[0]) *
+      netio_cf->nsenders);
+    if (netio_cf->args == NULL)
+        goto e0;
 
-    for (i = 0; i < SEND_THREADS; i++) {
+    for (i = 0; i < netio_cf->nsenders; i++) {
+        netio_cf->args[i].netio_cf = netio_cf;
         netio_cf->args[i].out_q = rtpp_queue_init(RTPQ_LARGE_CB_LEN, "RTPP->NET%.2d", i);
         if (netio_cf->args[i].out_q == NULL) {
             for (ri = i - 1; ri >= 0; ri--) {
@@ -296,12 +891,24 @@ rtpp_netio_async_init(const struct rtpp_cfg *cfsp, int qlen)
         RTPP_OBJ_INCREF(cfsp->glog);
         netio_cf->args[i].glog = cfsp->glog;
         netio_cf->args[i].dmode = cfsp->dmode;
+        netio_cf->args[i].gso = cfsp->udp_gso;
 #if RTPP_DEBUG_timers
         recfilter_init(&netio_cf->args[i].average_load, 0.9, 0.0, 0);
 #endif
     }
 
-    for (i = 0; i < SEND_THREADS; i++) {
+    if (cfsp->send_engine == RTPP_SEND_URING) {
+        for (i = 0; i < netio_cf->nsenders; i++) {
+            netio_cf->args[i].uring = rtpp_uring_ctor(RTPP_ANETIO_BATCH_LEN * 2);
+            if (netio_cf->args[i].uring == NULL) {
+                RTPP_ELOG(cfsp->glog, RTPP_LOG_ERR, "can't set up io_uring "
+                  "for the sender thread #%d, falling back to the "
+                  "synchronous I/O", i);
+            }
+        }
+    }
+
+    for (i = 0; i < netio_cf->nsenders; i++) {
         netio_cf->args[i].sigterm = rtpp_wi_malloc_sgnl(SIGTERM, NULL, 0);
         if (netio_cf->args[i].sigterm == NULL) {
             for (ri = i - 1; ri >= 0; ri--) {
@@ -311,13 +918,13 @@ rtpp_netio_async_init(const struct rtpp_cfg *cfsp, int qlen)
         }
     }
 
-    for (i = 0; i < SEND_THREADS; i++) {
+    for (i = 0; i < netio_cf->nsenders; i++) {
         if (pthread_create(&(netio_cf->thread_id[i]), NULL, (void *(*)(void *))&rtpp_anetio_sthread, &netio_cf->args[i]) != 0) {
              for (ri = i - 1; ri >= 0; ri--) {
                  rtpp_queue_put_item(netio_cf->args[ri].sigterm, netio_cf->args[ri].out_q);
                  pthread_join(netio_cf->thread_id[ri], NULL);
              }
-             for (ri = i; ri < SEND_THREADS; ri++) {
+             for (ri = i; ri < netio_cf->nsenders; ri++) {
                  CALL_METHOD(netio_cf->args[ri].sigterm, dtor);
              }
              goto e1;
@@ -328,16 +935,20 @@ rtpp_netio_async_init(const struct rtpp_cfg *cfsp, int qlen)
 
 #if 0
 e2:
-    for (i = 0; i < SEND_THREADS; i++) {
+    for (i = 0; i < netio_cf->nsenders; i++) {
         CALL_METHOD(netio_cf->args[i].sigterm, dtor);
     }
 #endif
 e1:
-    for (i = 0; i < SEND_THREADS; i++) {
+    for (i = 0; i < netio_cf->nsenders; i++) {
+        if (netio_cf->args[i].uring != NULL)
+            rtpp_uring_dtor(netio_cf->args[i].uring);
         rtpp_queue_destroy(netio_cf->args[i].out_q);
         RTPP_OBJ_DECREF(netio_cf->args[i].glog);
     }
 e0:
+    free(netio_cf->args);
+    free(netio_cf->thread_id);
     free(netio_cf);
     return (NULL);
 }
@@ -347,13 +958,17 @@ rtpp_netio_async_destroy(struct rtpp_anetio_cf *netio_cf)
 {
     int i;
 
-    for (i = 0; i < SEND_THREADS; i++) {
+    for (i = 0; i < netio_cf->nsenders; i++) {
         rtpp_queue_put_item(netio_cf->args[i].sigterm, netio_cf->args[i].out_q);
     }
-    for (i = 0; i < SEND_THREADS; i++) {
+    for (i = 0; i < netio_cf->nsenders; i++) {
         pthread_join(netio_cf->thread_id[i], NULL);
+        if (netio_cf->args[i].uring != NULL)
+            rtpp_uring_dtor(netio_cf->args[i].uring);
         rtpp_queue_destroy(netio_cf->args[i].out_q);
         RTPP_OBJ_DECREF(netio_cf->args[i].glog);
     }
+    free(netio_cf->args);
+    free(netio_cf->thread_id);
     free(netio_cf);
 }
@@ -36,6 +36,25 @@ struct rtpp_log;
 struct rtpp_netaddr;
 struct rtpp_cfg;
 
+/*
+ * Per-socket egress state, tracks number of packets queued but not sent
+ * yet and the sender thread that they are queued with. Both are kept in
+ * the single word, so that producers racing on the same socket agree on
+ * the sender: the count is in the upper bits, the sender # in the lower
+ * RTPP_ANETIO_SIDX_BITS.
+ */
+#define RTPP_ANETIO_SIDX_BITS 8
+#define RTPP_ANETIO_SIDX_MASK ((1U << RTPP_ANETIO_SIDX_BITS) - 1)
+#define RTPP_ANETIO_QONE (1U << RTPP_ANETIO_SIDX_BITS)
+
+struct rtpp_anetio_sstate {
+    _Atomic unsigned int qstate;
+    /* SO_TXTIME is on, packets can carry their departure time */
+    int txtime;
+    /* Peer the socket is connect()ed to, see rtpp_anetio_setpeer() */
+    _Atomic(uint64_t) cpeer;
+};
+
 int rtpp_anetio_sendto(struct rtpp_anetio_cf *, int, const void *, \
   size_t, int, const struct sockaddr *, socklen_t);
 #if 0
@@ -45,10 +64,13 @@ int rtpp_anetio_send_pkt(struct sthread_args *, int, \
 #endif
 int rtpp_anetio_send_pkt_na(struct sthread_args *, int, \
   struct rtpp_netaddr *, struct rtp_packet *,
-  struct rtpp_refcnt *, struct rtpp_log *);
+  struct rtpp_refcnt *, struct rtpp_log *, struct rtpp_anetio_sstate *);
+void rtpp_anetio_setpeer(struct rtpp_anetio_sstate *, const struct sockaddr *,
+  socklen_t);
 void rtpp_anetio_pump(struct rtpp_anetio_cf *);
+void rtpp_anetio_setbusy(struct rtpp_anetio_cf *, int);
 void rtpp_anetio_pump_q(struct sthread_args *);
-struct sthread_args *rtpp_anetio_pick_sender(struct rtpp_anetio_cf *);
+struct sthread_args *rtpp_anetio_pick_sender(struct rtpp_anetio_cf *, int);
 
 struct rtpp_anetio_cf *rtpp_netio_async_init(const struct rtpp_cfg *, int);
 void rtpp_netio_async_destroy(struct rtpp_anetio_cf *);
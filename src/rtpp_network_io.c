@@ -26,51 +26,38 @@
  *
  */
 
+#if defined(LINUX_XXX) && !defined(_GNU_SOURCE)
+/* Apparently needed for recvmmsg(2) */
+#define _GNU_SOURCE
+#endif
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <string.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 
 #include "config_pp.h"
 
 #include "rtpp_network.h"
 #include "rtpp_network_io.h"
 
-static ssize_t
-_recvfromto(int s, void *buf, size_t len, struct sockaddr *from,
-  socklen_t *fromlen, struct sockaddr *to, socklen_t *tolen,
+static void
+_recvfromto_cmsgs(struct msghdr *msg, struct sockaddr *to, socklen_t *tolen,
   void *tp, size_t tplen, int mtype)
 {
-    /* We use a union to make sure hdr is aligned */
-    union {
-        struct cmsghdr hdr;
-        unsigned char buf[CMSG_SPACE(1024)];
-    } cmsgbuf;
 #if !defined(IP_RECVDSTADDR)
     struct in_pktinfo *pktinfo;
 #endif
     struct cmsghdr *cmsg;
-    struct msghdr msg;
-    struct iovec iov;
-    ssize_t rval;
-
-    memset(&msg, '\0', sizeof(msg));
-    iov.iov_base = buf;
-    iov.iov_len = len;
-    msg.msg_name = from;
-    msg.msg_namelen = *fromlen;
-    msg.msg_iov = &iov;
-    msg.msg_iovlen = 1;
-    msg.msg_control = cmsgbuf.buf;
-    msg.msg_controllen = sizeof(cmsgbuf.buf);
-
-    rval = recvmsg(s, &msg, 0);
-    if (rval < 0)
-        return (rval);
 
     *tolen = 0;
-    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
-      cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    /*
+     * Go through all of them, the timestamp and the UDP_GRO segment size
+     * can come after the destination address.
+     */
+    for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL;
+      cmsg = CMSG_NXTHDR(msg, cmsg)) {
 #if defined(IP_RECVDSTADDR)
         if (cmsg->cmsg_level == IPPROTO_IP &&
           cmsg->cmsg_type == IP_RECVDSTADDR) {
@@ -78,7 +65,7 @@ _recvfromto(int s, void *buf, size_t len, struct sockaddr *from,
               sizeof(struct in_addr));
             to->sa_family = AF_INET;
             *tolen = sizeof(struct sockaddr_in);
-            break;
+            continue;
         }
 #else
         if (cmsg->cmsg_level == SOL_IP &&
@@ -88,7 +75,24 @@ _recvfromto(int s, void *buf, size_t len, struct sockaddr *from,
               sizeof(struct in_addr));
             to->sa_family = AF_INET;
             *tolen = sizeof(struct sockaddr_in);
-            break;
+            continue;
+        }
+#endif
+#if defined(IP_ORIGDSTADDR)
+        /* Full destination address, port included (IP_RECVORIGDSTADDR) */
+        if (cmsg->cmsg_level == IPPROTO_IP &&
+          cmsg->cmsg_type == IP_ORIGDSTADDR) {
+            memcpy(to, CMSG_DATA(cmsg), sizeof(struct sockaddr_in));
+            *tolen = sizeof(struct sockaddr_in);
+            continue;
+        }
+#endif
+#if defined(IPV6_ORIGDSTADDR)
+        if (cmsg->cmsg_level == IPPROTO_IPV6 &&
+          cmsg->cmsg_type == IPV6_ORIGDSTADDR) {
+            memcpy(to, CMSG_DATA(cmsg), sizeof(struct sockaddr_in6));
+            *tolen = sizeof(struct sockaddr_in6);
+            continue;
         }
 #endif
         if ((cmsg->cmsg_level == SOL_SOCKET) &&
@@ -96,6 +100,55 @@ _recvfromto(int s, void *buf, size_t len, struct sockaddr *from,
             memcpy(tp, CMSG_DATA(cmsg), tplen);
         }
     }
+}
+
+#if HAVE_RECVMMSG && defined(UDP_GRO)
+static int
+_recvfromto_segsize(struct msghdr *msg)
+{
+    struct cmsghdr *cmsg;
+    int segsize;
+
+    for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL;
+      cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+            memcpy(&segsize, CMSG_DATA(cmsg), sizeof(segsize));
+            return (segsize);
+        }
+    }
+    return (0);
+}
+#endif
+
+static ssize_t
+_recvfromto(int s, void *buf, size_t len, struct sockaddr *from,
+  socklen_t *fromlen, struct sockaddr *to, socklen_t *tolen,
+  void *tp, size_t tplen, int mtype)
+{
+    /* We use a union to make sure hdr is aligned */
+    union {
+        struct cmsghdr hdr;
+        unsigned char buf[CMSG_SPACE(1024)];
+    } cmsgbuf;
+    struct msghdr msg;
+    struct iovec iov;
+    ssize_t rval;
+
+    memset(&msg, '\0', sizeof(msg));
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    msg.msg_name = from;
+    msg.msg_namelen = *fromlen;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsgbuf.buf;
+    msg.msg_controllen = sizeof(cmsgbuf.buf);
+
+    rval = recvmsg(s, &msg, 0);
+    if (rval < 0)
+        return (rval);
+
+    _recvfromto_cmsgs(&msg, to, tolen, tp, tplen, mtype);
     *fromlen = msg.msg_namelen;
     return (rval);
 }
@@ -121,3 +174,77 @@ recvfromto_mono(int s, void *buf, size_t len, struct sockaddr *from,
       sizeof(*timeptr), SCM_MONOTONIC));
 }
 #endif /* HAVE_SO_TS_CLOCK */
+
+#if HAVE_RECVMMSG
+/*
+ * Batched version of the recvfromto(), receives up to nmsg datagrams in
+ * a single recvmmsg(2) call. On input each entry has buf, len, from and
+ * fromlen filled, on output first N entries (return value) get their
+ * size, fromlen, to, tolen, time and segsize updated. Non-zero segsize
+ * indicates that the kernel has coalesced several datagrams of that size
+ * into a single buffer (UDP_GRO), the last one can be shorter. Returns -1
+ * and leaves errno set if no datagrams could be received.
+ */
+int
+recvmmsgfromto(int s, struct rtpp_rxmsg *rmp, int nmsg, int mtype)
+{
+    union {
+        struct cmsghdr hdr;
+        unsigned char buf[CMSG_SPACE(sizeof(struct in_pktinfo)) +
+          CMSG_SPACE(sizeof(struct sockaddr_in6)) +
+          CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(int))];
+    } cmsgbufs[RTPP_RXMSG_MAX];
+    struct mmsghdr mmsg[RTPP_RXMSG_MAX];
+    struct iovec iov[RTPP_RXMSG_MAX];
+    struct msghdr *msg;
+    int i, rval;
+
+    if (nmsg > RTPP_RXMSG_MAX)
+        nmsg = RTPP_RXMSG_MAX;
+    memset(mmsg, '\0', sizeof(mmsg[0]) * nmsg);
+    for (i = 0; i < nmsg; i++) {
+        iov[i].iov_base = rmp[i].buf;
+        iov[i].iov_len = rmp[i].len;
+        msg = &mmsg[i].msg_hdr;
+        msg->msg_name = rmp[i].from;
+        msg->msg_namelen = rmp[i].fromlen;
+        msg->msg_iov = &iov[i];
+        msg->msg_iovlen = 1;
+        msg->msg_control = cmsgbufs[i].buf;
+        msg->msg_controllen = sizeof(cmsgbufs[i].buf);
+    }
+
+    rval = recvmmsg(s, mmsg, nmsg, MSG_DONTWAIT, NULL);
+    if (rval <= 0)
+        return (rval < 0 ? rval : -1);
+
+    for (i = 0; i < rval; i++) {
+        msg = &mmsg[i].msg_hdr;
+        rmp[i].size = mmsg[i].msg_len;
+        _recvfromto_cmsgs(msg, rmp[i].to, &rmp[i].tolen, &rmp[i].time,
+          (mtype == SCM_TIMESTAMP) ? sizeof(rmp[i].time.tv) :
+          sizeof(rmp[i].time.ts), mtype);
+        rmp[i].fromlen = msg->msg_namelen;
+#if defined(UDP_GRO)
+        rmp[i].segsize = _recvfromto_segsize(msg);
+#else
+        rmp[i].segsize = 0;
+#endif
+    }
+    return (rval);
+}
+
+/*
+ * Fill in to, tolen and time of the entry from the control messages of
+ * a datagram that has been received by other means, i.e. io_uring(7).
+ */
+void
+rtpp_rxmsg_cmsgs(struct msghdr *msg, struct rtpp_rxmsg *rmp, int mtype)
+{
+
+    _recvfromto_cmsgs(msg, rmp->to, &rmp->tolen, &rmp->time,
+      (mtype == SCM_TIMESTAMP) ? sizeof(rmp->time.tv) :
+      sizeof(rmp->time.ts), mtype);
+    rmp->segsize = 0;
+}
+#endif /* HAVE_RECVMMSG */
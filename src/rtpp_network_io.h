@@ -31,6 +31,27 @@
 
 struct sockaddr;
 struct timeval;
+struct msghdr;
+
+#if HAVE_RECVMMSG
+/* Max number of datagrams received in one recvmmsgfromto() call */
+#define RTPP_RXMSG_MAX 32
+
+struct rtpp_rxmsg {
+    void *buf;
+    size_t len;
+    ssize_t size;
+    struct sockaddr *from;
+    socklen_t fromlen;
+    struct sockaddr *to;
+    socklen_t tolen;
+    int segsize;
+    union {
+        struct timeval tv;
+        struct timespec ts;
+    } time;
+};
+#endif
 
 /* Function prototypes */
 ssize_t recvfromto(int, void *, size_t, struct sockaddr *,
@@ -39,5 +60,9 @@ ssize_t recvfromto(int, void *, size_t, struct sockaddr *,
 ssize_t recvfromto_mono(int, void *, size_t, struct sockaddr *,
   socklen_t *, struct sockaddr *, socklen_t *, struct timespec *);
 #endif
+#if HAVE_RECVMMSG
+int recvmmsgfromto(int, struct rtpp_rxmsg *, int, int);
+void rtpp_rxmsg_cmsgs(struct msghdr *, struct rtpp_rxmsg *, int);
+#endif
 
 #endif
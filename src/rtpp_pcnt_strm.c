@@ -57,6 +57,11 @@ static void rtpp_pcnt_strm_get_stats(struct rtpp_pcnt_strm *,
   struct rtpp_pcnts_strm *);
 static void rtpp_pcnt_strm_reg_pktin(struct rtpp_pcnt_strm *,
   struct rtp_packet *);
+static void rtpp_pcnt_strm_reg_npktin(struct rtpp_pcnt_strm *,
+  unsigned long, const struct rtpp_timestamp *);
+static void rtpp_pcnt_strm_reg_throttled(struct rtpp_pcnt_strm *);
+static void rtpp_pcnt_strm_reg_kdropped(struct rtpp_pcnt_strm *,
+  unsigned long);
 
 struct rtpp_pcnt_strm *
 rtpp_pcnt_strm_ctor(void)
@@ -72,6 +77,9 @@ rtpp_pcnt_strm_ctor(void)
     }
     pvt->pub.get_stats = &rtpp_pcnt_strm_get_stats;
     pvt->pub.reg_pktin = &rtpp_pcnt_strm_reg_pktin;
+    pvt->pub.reg_npktin = &rtpp_pcnt_strm_reg_npktin;
+    pvt->pub.reg_throttled = &rtpp_pcnt_strm_reg_throttled;
+    pvt->pub.reg_kdropped = &rtpp_pcnt_strm_reg_kdropped;
     CALL_SMETHOD(pvt->pub.rcnt, attach,
       (rtpp_refcnt_dtor_t)&rtpp_pcnt_strm_dtor, pvt);
     return ((&pvt->pub));
@@ -129,3 +137,49 @@ rtpp_pcnt_strm_reg_pktin(struct rtpp_pcnt_strm *self,
     }
     pthread_mutex_unlock(&pvt->lock);
 }
+
+/*
+ * Account for a number of packets which have been received bypassing us
+ * (i.e. relayed in-kernel), dtime is when we have learned about them.
+ */
+static void
+rtpp_pcnt_strm_reg_npktin(struct rtpp_pcnt_strm *self, unsigned long npkts,
+  const struct rtpp_timestamp *dtime)
+{
+    struct rtpp_pcnt_strm_priv *pvt;
+
+    PUB2PVT(self, pvt);
+    pthread_mutex_lock(&pvt->lock);
+    pvt->cnt.npkts_in += npkts;
+    if (pvt->cnt.first_pkt_rcv.mono == 0.0) {
+        pvt->cnt.first_pkt_rcv.mono = dtime->mono;
+        pvt->cnt.first_pkt_rcv.wall = dtime->wall;
+    }
+    if (pvt->cnt.last_pkt_rcv.mono < dtime->mono) {
+        pvt->cnt.last_pkt_rcv.mono = dtime->mono;
+        pvt->cnt.last_pkt_rcv.wall = dtime->wall;
+    }
+    pthread_mutex_unlock(&pvt->lock);
+}
+
+static void
+rtpp_pcnt_strm_reg_throttled(struct rtpp_pcnt_strm *self)
+{
+    struct rtpp_pcnt_strm_priv *pvt;
+
+    PUB2PVT(self, pvt);
+    pthread_mutex_lock(&pvt->lock);
+    pvt->cnt.nthrottled++;
+    pthread_mutex_unlock(&pvt->lock);
+}
+
+static void
+rtpp_pcnt_strm_reg_kdropped(struct rtpp_pcnt_strm *self, unsigned long n)
+{
+    struct rtpp_pcnt_strm_priv *pvt;
+
+    PUB2PVT(self, pvt);
+    pthread_mutex_lock(&pvt->lock);
+    pvt->cnt.nkdropped += n;
+    pthread_mutex_unlock(&pvt->lock);
+}
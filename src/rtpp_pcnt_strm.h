@@ -33,16 +33,24 @@ struct rtpp_pcnt_strm;
 struct rtpp_refcnt;
 struct rtp_packet;
 struct rtpp_pcnts_strm;
+struct rtpp_timestamp;
 
 DEFINE_METHOD(rtpp_pcnt_strm, rtpp_pcnt_strm_get_stats, void,
   struct rtpp_pcnts_strm *);
 DEFINE_METHOD(rtpp_pcnt_strm, rtpp_pcnt_strm_reg_pktin, void,
   struct rtp_packet *);
+DEFINE_METHOD(rtpp_pcnt_strm, rtpp_pcnt_strm_reg_npktin, void,
+  unsigned long, const struct rtpp_timestamp *);
+DEFINE_METHOD(rtpp_pcnt_strm, rtpp_pcnt_strm_reg_throttled, void);
+DEFINE_METHOD(rtpp_pcnt_strm, rtpp_pcnt_strm_reg_kdropped, void, unsigned long);
 
 struct rtpp_pcnt_strm {
     struct rtpp_refcnt *rcnt;
     METHOD_ENTRY(rtpp_pcnt_strm_get_stats, get_stats);
     METHOD_ENTRY(rtpp_pcnt_strm_reg_pktin, reg_pktin);
+    METHOD_ENTRY(rtpp_pcnt_strm_reg_npktin, reg_npktin);
+    METHOD_ENTRY(rtpp_pcnt_strm_reg_throttled, reg_throttled);
+    METHOD_ENTRY(rtpp_pcnt_strm_reg_kdropped, reg_kdropped);
 };
 
 struct rtpp_pcnt_strm *rtpp_pcnt_strm_ctor(void);
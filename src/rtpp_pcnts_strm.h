@@ -38,6 +38,10 @@ struct rtpp_pcnts_strm {
     struct rtpp_timestamp last_pkt_rcv;
     /* Longest inter-packet interval */
     double longest_ipi;
+    /* Rounds that used the receive budget up with packets still queued */
+    unsigned long nthrottled;
+    /* Number of packets lost to the receive buffer overflow */
+    unsigned long nkdropped;
 };
 
 #endif
@@ -45,10 +45,23 @@ struct rtpp_pcount_priv {
 
 static void rtpp_pcount_dtor(struct rtpp_pcount_priv *);
 static void rtpp_pcount_reg_reld(struct rtpp_pcount *);
+static void rtpp_pcount_reg_nreld(struct rtpp_pcount *, unsigned long);
 static void rtpp_pcount_reg_drop(struct rtpp_pcount *);
 static void rtpp_pcount_reg_ignr(struct rtpp_pcount *);
+static void rtpp_pcount_reg_plcd(struct rtpp_pcount *);
 static void rtpp_pcount_get_stats(struct rtpp_pcount *, struct rtpps_pcount *);
 
+#if defined(RTPP_STATIC_DISPATCH)
+const struct rtpp_pcount rtpp_pcount_methods = {
+    .reg_reld = &rtpp_pcount_reg_reld,
+    .reg_nreld = &rtpp_pcount_reg_nreld,
+    .reg_drop = &rtpp_pcount_reg_drop,
+    .reg_ignr = &rtpp_pcount_reg_ignr,
+    .reg_plcd = &rtpp_pcount_reg_plcd,
+    .get_stats = &rtpp_pcount_get_stats
+};
+#endif
+
 struct rtpp_pcount *
 rtpp_pcount_ctor(void)
 {
@@ -62,8 +75,10 @@ rtpp_pcount_ctor(void)
         goto e1;
     }
     pvt->pub.reg_reld = &rtpp_pcount_reg_reld;
+    pvt->pub.reg_nreld = &rtpp_pcount_reg_nreld;
     pvt->pub.reg_drop = &rtpp_pcount_reg_drop;
     pvt->pub.reg_ignr = &rtpp_pcount_reg_ignr;
+    pvt->pub.reg_plcd = &rtpp_pcount_reg_plcd;
     pvt->pub.get_stats = &rtpp_pcount_get_stats;
     CALL_SMETHOD(pvt->pub.rcnt, attach, (rtpp_refcnt_dtor_t)&rtpp_pcount_dtor,
       pvt);
@@ -96,6 +111,17 @@ rtpp_pcount_reg_reld(struct rtpp_pcount *self)
     pthread_mutex_unlock(&pvt->lock);
 }
 
+static void
+rtpp_pcount_reg_nreld(struct rtpp_pcount *self, unsigned long n)
+{
+    struct rtpp_pcount_priv *pvt;
+
+    PUB2PVT(self, pvt);
+    pthread_mutex_lock(&pvt->lock);
+    pvt->cnt.nrelayed += n;
+    pthread_mutex_unlock(&pvt->lock);
+}
+
 static void
 rtpp_pcount_reg_drop(struct rtpp_pcount *self)
 {
@@ -118,6 +144,17 @@ rtpp_pcount_reg_ignr(struct rtpp_pcount *self)
     pthread_mutex_unlock(&pvt->lock);
 }
 
+static void
+rtpp_pcount_reg_plcd(struct rtpp_pcount *self)
+{
+    struct rtpp_pcount_priv *pvt;
+
+    PUB2PVT(self, pvt);
+    pthread_mutex_lock(&pvt->lock);
+    pvt->cnt.npoliced++;
+    pthread_mutex_unlock(&pvt->lock);
+}
+
 static void
 rtpp_pcount_get_stats(struct rtpp_pcount *self, struct rtpps_pcount *ocnt)
 {
@@ -34,8 +34,10 @@ struct rtpp_refcnt;
 struct rtpps_pcount;
 
 DEFINE_METHOD(rtpp_pcount, rtpp_pcount_reg_reld, void);
+DEFINE_METHOD(rtpp_pcount, rtpp_pcount_reg_nreld, void, unsigned long);
 DEFINE_METHOD(rtpp_pcount, rtpp_pcount_reg_drop, void);
 DEFINE_METHOD(rtpp_pcount, rtpp_pcount_reg_ignr, void);
+DEFINE_METHOD(rtpp_pcount, rtpp_pcount_reg_plcd, void);
 DEFINE_METHOD(rtpp_pcount, rtpp_pcount_get_stats, void,
   struct rtpps_pcount *);
 
@@ -43,13 +45,16 @@ struct rtpps_pcount {
     unsigned long nrelayed;
     unsigned long ndropped;
     unsigned long nignored;
+    unsigned long npoliced;
 };
 
 struct rtpp_pcount {
     struct rtpp_refcnt *rcnt;
     METHOD_ENTRY(rtpp_pcount_reg_reld, reg_reld);
+    METHOD_ENTRY(rtpp_pcount_reg_nreld, reg_nreld);
     METHOD_ENTRY(rtpp_pcount_reg_drop, reg_drop);
     METHOD_ENTRY(rtpp_pcount_reg_ignr, reg_ignr);
+    METHOD_ENTRY(rtpp_pcount_reg_plcd, reg_plcd);
     METHOD_ENTRY(rtpp_pcount_get_stats, get_stats);
 };
 
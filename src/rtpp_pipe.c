@@ -185,6 +185,21 @@ rtpp_pipe_get_stats(struct rtpp_pipe *self, struct rtpp_acct_pipe *rapp)
       PP_NAME(pvt->pipe_type), rapp->o.ps->npkts_in,
       rapp->a.ps->npkts_in, rapp->pcnts->nrelayed, rapp->pcnts->ndropped,
       rapp->pcnts->nignored);
+    if (rapp->pcnts->npoliced > 0) {
+        RTPP_LOG(self->log, RTPP_LOG_INFO, "%s rate limit exceeded: %lu "
+          "packets dropped", PP_NAME(pvt->pipe_type), rapp->pcnts->npoliced);
+    }
+    if (rapp->o.ps->nkdropped > 0 || rapp->a.ps->nkdropped > 0) {
+        RTPP_LOG(self->log, RTPP_LOG_INFO, "%s dropped by the kernel: "
+          "%lu from callee, %lu from caller", PP_NAME(pvt->pipe_type),
+          rapp->o.ps->nkdropped, rapp->a.ps->nkdropped);
+    }
+    if (rapp->o.ps->nthrottled > 0 || rapp->a.ps->nthrottled > 0) {
+        RTPP_LOG(self->log, RTPP_LOG_INFO, "%s receive budget used up: "
+          "%lu times from callee, %lu times from caller",
+          PP_NAME(pvt->pipe_type), rapp->o.ps->nthrottled,
+          rapp->a.ps->nthrottled);
+    }
     if (pvt->pipe_type != PIPE_RTP) {
         return;
     }
@@ -30,8 +30,15 @@
 #include <sys/socket.h>
 #include <poll.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "config.h"
+
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #include "rtpp_types.h"
 #include "rtpp_weakref.h"
 #include "rtp.h"
@@ -40,16 +47,20 @@
 #include "rtp_resizer.h"
 #include "rtpp_cfg.h"
 #include "rtpp_defines.h"
+#include "rtpp_math.h"
 #include "rtpp_proc.h"
 #include "rtpp_record.h"
 #include "rtpp_refcnt.h"
 #include "rtpp_sessinfo.h"
 #include "rtpp_stream.h"
 #include "rtpp_pcount.h"
+#include "rtpp_pcnt_strm.h"
 #include "rtpp_socket.h"
 #include "rtpp_session.h"
 #include "rtpp_ttl.h"
 #include "rtpp_pipe.h"
+#include "rtpp_network.h"
+#include "rtpp_demux.h"
 #include "advanced/po_manager.h"
 
 struct rtpp_proc_ready_lst {
@@ -58,43 +69,113 @@ struct rtpp_proc_ready_lst {
 };
 
 static void send_packet(const struct rtpp_cfg *, struct rtpp_stream *,
-  struct rtp_packet *, struct sthread_args *, struct rtpp_proc_rstats *);
+  struct rtpp_stream *, struct rtp_packet *, struct sthread_args *,
+  struct rtpp_proc_rstats *);
 
-static void
+/*
+ * Max number of packets taken from the shared socket of the rtpp_demux
+ * per wakeup, so that the other one (i.e. other address family) does not
+ * get starved. Whatever is left is picked up on the next poll.
+ */
+#define RTPP_PROC_DEMUX_MAXPKTS (RTPP_PROC_RXB_MAXLEN * 8)
+
+static int
+rtpp_proc_rxbatch_fill(struct rtpp_proc_rxbatch *rbp, int npkts)
+{
+    int i;
+
+    for (i = 0; i < npkts; i++) {
+        if (rbp->pkts[i] != NULL)
+            continue;
+        rbp->pkts[i] = rtp_packet_alloc();
+        if (rbp->pkts[i] == NULL)
+            break;
+    }
+    return (i);
+}
+
+void
+rtpp_proc_rxbatch_free(struct rtpp_proc_rxbatch *rbp)
+{
+    int i;
+
+    for (i = 0; i < RTPP_PROC_RXB_MAXLEN; i++) {
+        if (rbp->pkts[i] == NULL)
+            continue;
+        RTPP_OBJ_DECREF(rbp->pkts[i]);
+        rbp->pkts[i] = NULL;
+    }
+}
+
+static int
 rxmit_packets(const struct rtpp_cfg *cfsp, struct rtpp_stream *stp,
-  const struct rtpp_timestamp *dtime, int drain_repeat, struct sthread_args *sender,
-  struct rtpp_proc_rstats *rsp, const struct rtpp_session *sp)
+  struct rtpp_stream *stp_out, const struct rtpp_timestamp *dtime,
+  int drain_repeat, struct sthread_args *sender,
+  struct rtpp_proc_rstats *rsp, const struct rtpp_session *sp,
+  struct rtpp_socket *iskt, struct rtpp_proc_rxbatch *rbp)
 {
-    int ndrain;
-    struct rtp_packet *packet = NULL;
+    int ndrain, npend, nreq, nrcvd, i;
+    struct rtp_packet *packet;
     struct po_mgr_pkt_ctx pktx;
+    struct rtpp_stream *stp_in, *stp_rtcp, *stp_in_out;
 
     /* Repeat since we may have several packets queued on the same socket */
-    ndrain = -1;
+    ndrain = drain_repeat;
+    npend = 0;
+    stp_rtcp = NULL;
     do {
-        if (ndrain < 0) {
-            ndrain = drain_repeat - 1;
-        } else {
+        /*
+         * Packets that the socket has already pulled out of the kernel
+         * (i.e. leftovers of the UDP_GRO buffer) are not subject to the
+         * drain limit, as otherwise we won't see them until the next
+         * datagram arrives.
+         */
+        nreq = (ndrain > 0) ? ndrain : npend;
+        nreq = rtpp_proc_rxbatch_fill(rbp, MIN(nreq, RTPP_PROC_RXB_MAXLEN));
+        if (nreq == 0)
+            break;
+        nrcvd = CALL_SMETHOD(stp, rx_batch, cfsp->rtcp_streams_wrt, dtime,
+          rsp, rbp->pkts, nreq);
+        for (i = 0; i < nrcvd; i++) {
+            packet = rbp->pkts[i];
+            rbp->pkts[i] = NULL;
+            if (packet == RTPP_S_RX_DCONT) {
+                /* Discarded packets do not count against the drain limit */
+                continue;
+            }
             ndrain -= 1;
+            if (packet == NULL) {
+                /* Consumed by the resizer */
+                continue;
+            }
+            stp_in = stp;
+            stp_in_out = stp_out;
+            if (stp->rtcp_mux != 0 &&
+              RTP_IS_RTCP_MUX(packet->data.buf, packet->size)) {
+                /* Demultiplexed RTCP, relay it on behalf of the RTCP stream */
+                if (stp_rtcp == NULL) {
+                    stp_rtcp = CALL_METHOD(cfsp->rtcp_streams_wrt, get_by_idx,
+                      stp->stuid_rtcp);
+                    if (stp_rtcp == NULL) {
+                        RTPP_OBJ_DECREF(packet);
+                        rsp->npkts_discard.cnt++;
+                        continue;
+                    }
+                }
+                stp_in = stp_rtcp;
+                stp_in_out = NULL;
+            }
+            pktx.sessp = sp;
+            pktx.strmp = stp_in;
+            pktx.pktp = packet;
+            CALL_METHOD(cfsp->observers, observe, &pktx);
+            send_packet(cfsp, stp_in, stp_in_out, packet, sender, rsp);
         }
-
-	packet = CALL_SMETHOD(stp, rx, cfsp->rtcp_streams_wrt, dtime,
-          rsp);
-	if (packet == NULL) {
-            /* Move on to the next session */
-            return;
-        }
-        if (packet == RTPP_S_RX_DCONT) {
-            ndrain += 1;
-            continue;
-        }
-        pktx.sessp = sp;
-        pktx.strmp = stp;
-        pktx.pktp = packet;
-        CALL_METHOD(cfsp->observers, observe, &pktx);
-        send_packet(cfsp, stp, packet, sender, rsp);
-    } while (ndrain > 0);
-    return;
+    } while (nrcvd == nreq &&
+      (ndrain > 0 || (npend = CALL_METHOD(iskt, rx_pending)) > 0));
+    if (stp_rtcp != NULL)
+        RTPP_OBJ_DECREF(stp_rtcp);
+    return (drain_repeat - ndrain);
 }
 
 static struct rtpp_stream *
@@ -108,18 +189,25 @@ get_sender(const struct rtpp_cfg *cfsp, struct rtpp_stream *stp)
       stp->stuid_sendr));
 }
 
+/*
+ * Relay packet received by the stp_in to its peer. The stp_out is the peer
+ * if the caller has it at hand already, otherwise (NULL) it is looked up.
+ */
 static void
 send_packet(const struct rtpp_cfg *cfsp, struct rtpp_stream *stp_in,
-  struct rtp_packet *packet, struct sthread_args *sender,
-  struct rtpp_proc_rstats *rsp)
+  struct rtpp_stream *stp_out, struct rtp_packet *packet,
+  struct sthread_args *sender, struct rtpp_proc_rstats *rsp)
 {
-    struct rtpp_stream *stp_out;
+    struct rtpp_stream *stp_lkup;
 
     CALL_METHOD(stp_in->ttl, reset);
 
-    stp_out = get_sender(cfsp, stp_in);
+    stp_lkup = NULL;
     if (stp_out == NULL) {
-        goto e0;
+        stp_out = stp_lkup = get_sender(cfsp, stp_in);
+        if (stp_out == NULL) {
+            goto e0;
+        }
     }
 
     if (stp_in->rrc != NULL) {
@@ -139,61 +227,285 @@ send_packet(const struct rtpp_cfg *cfsp, struct rtpp_stream *stp_in,
         CALL_METHOD(stp_in->pcount, reg_reld);
         rsp->npkts_relayed.cnt++;
     }
-    RTPP_OBJ_DECREF(stp_out);
+    if (stp_lkup != NULL)
+        RTPP_OBJ_DECREF(stp_lkup);
     return;
 
 e1:
-    RTPP_OBJ_DECREF(stp_out);
+    if (stp_lkup != NULL)
+        RTPP_OBJ_DECREF(stp_lkup);
 e0:
     RTPP_OBJ_DECREF(packet);
     CALL_METHOD(stp_in->pcount, reg_drop);
     rsp->npkts_discard.cnt++;
 }
 
-void
-process_rtp_only(const struct rtpp_cfg *cfsp, struct rtpp_polltbl *ptbl,
-  const struct rtpp_timestamp *dtime, int drain_repeat, struct sthread_args *sender,
-  struct rtpp_proc_rstats *rsp)
+static void
+demux_packet(const struct rtpp_cfg *cfsp, const struct rtpp_timestamp *dtime,
+  struct sthread_args *sender, struct rtpp_proc_rstats *rsp,
+  struct rtp_packet *packet)
 {
-    int readyfd, ndrained;
+    uint64_t stuid;
     struct rtpp_session *sp;
-    struct rtpp_stream *stp;
+    struct rtpp_stream *stp, *stp_in;
+    struct rtp_packet *rpacket;
+    struct po_mgr_pkt_ctx pktx;
+
+    if (packet->laddr == NULL)
+        goto e0;
+    stuid = rtpp_demux_lookup(cfsp->rtpp_demux_cf, packet->laddr);
+    if (stuid == RTPP_UID_NONE)
+        goto e0;
+    stp = CALL_METHOD(cfsp->rtp_streams_wrt, get_by_idx, stuid);
+    if (stp == NULL) {
+        stp = CALL_METHOD(cfsp->rtcp_streams_wrt, get_by_idx, stuid);
+        if (stp == NULL)
+            goto e0;
+    }
+    sp = CALL_METHOD(cfsp->sessions_wrt, get_by_idx, stp->seuid);
+    if (sp == NULL)
+        goto e1;
+    if (sp->complete == 0)
+        goto e2;
+    packet->lport = getport(packet->laddr);
+    stp_in = stp;
+    if (stp->rtcp_mux != 0 &&
+      RTP_IS_RTCP_MUX(packet->data.buf, packet->size)) {
+        stp_in = CALL_METHOD(cfsp->rtcp_streams_wrt, get_by_idx,
+          stp->stuid_rtcp);
+        if (stp_in == NULL)
+            goto e2;
+        rpacket = CALL_SMETHOD(stp_in, rx_demux, NULL, dtime, rsp, packet);
+    } else {
+        RTPP_OBJ_INCREF(stp_in);
+        rpacket = CALL_SMETHOD(stp_in, rx_demux, cfsp->rtcp_streams_wrt,
+          dtime, rsp, packet);
+    }
+    if (rpacket == RTPP_S_RX_DCONT) {
+        /* Already accounted as received by the stream */
+        RTPP_OBJ_DECREF(stp_in);
+        RTPP_OBJ_DECREF(sp);
+        RTPP_OBJ_DECREF(stp);
+        RTPP_OBJ_DECREF(packet);
+        rsp->npkts_discard.cnt++;
+        return;
+    }
+    if (rpacket != NULL) {
+        pktx.sessp = sp;
+        pktx.strmp = stp_in;
+        pktx.pktp = rpacket;
+        CALL_METHOD(cfsp->observers, observe, &pktx);
+        send_packet(cfsp, stp_in, NULL, rpacket, sender, rsp);
+    }
+    RTPP_OBJ_DECREF(stp_in);
+    RTPP_OBJ_DECREF(sp);
+    if (stp->resizer != NULL) {
+        while ((rpacket = rtp_resizer_get(stp->resizer, dtime->mono)) != NULL) {
+            send_packet(cfsp, stp, NULL, rpacket, sender, rsp);
+            rsp->npkts_resizer_out.cnt++;
+        }
+    }
+    RTPP_OBJ_DECREF(stp);
+    return;
+
+e2:
+    RTPP_OBJ_DECREF(sp);
+e1:
+    RTPP_OBJ_DECREF(stp);
+e0:
+    RTPP_OBJ_DECREF(packet);
+    rsp->npkts_rcvd.cnt++;
+    rsp->npkts_discard.cnt++;
+}
+
+/*
+ * Shared socket of the rtpp_demux is ready, packets in there can belong
+ * to any of the streams in the shard, so they are routed one by one based
+ * on the destination port they have been sent to.
+ */
+static void
+process_demux_ready(const struct rtpp_cfg *cfsp, struct rtpp_socket *iskt,
+  const struct rtpp_timestamp *dtime, struct sthread_args *sender,
+  struct rtpp_proc_rstats *rsp, struct rtpp_proc_rxbatch *rbp)
+{
+    int ntotal, nreq, nrcvd, i;
+    struct rtp_packet *packet;
+
+    for (ntotal = 0; ntotal < RTPP_PROC_DEMUX_MAXPKTS; ntotal += nrcvd) {
+        nreq = rtpp_proc_rxbatch_fill(rbp, RTPP_PROC_RXB_MAXLEN);
+        if (nreq == 0)
+            break;
+        nrcvd = CALL_METHOD(iskt, rtp_recvm, dtime, NULL, 0, rbp->pkts, nreq);
+        for (i = 0; i < nrcvd; i++) {
+            packet = rbp->pkts[i];
+            rbp->pkts[i] = NULL;
+            demux_packet(cfsp, dtime, sender, rsp, packet);
+        }
+        if (nrcvd < nreq)
+            break;
+    }
+}
+
+/*
+ * Returns number of packets taken out of the socket, which is to be charged
+ * against the budget of drain_repeat packets.
+ */
+static int
+process_rtp_ready(const struct rtpp_cfg *cfsp, struct rtpp_polltbl *ptbl,
+  int readyfd, const struct rtpp_timestamp *dtime, int drain_repeat,
+  struct sthread_args *sender, struct rtpp_proc_rstats *rsp,
+  struct rtpp_proc_rxbatch *rbp)
+{
+    int ndrained, nused;
+    struct rtpp_session *sp;
+    struct rtpp_stream *stp, *stp_out;
     struct rtp_packet *packet;
     struct rtpp_socket *iskt;
 
+    if (ptbl->mds[readyfd].stuid == RTPP_UID_NONE) {
+        /* Shared socket has a fixed limit of its own */
+        process_demux_ready(cfsp, ptbl->mds[readyfd].skt, dtime, sender, rsp,
+          rbp);
+        return (0);
+    }
+    /* Both are pinned by the table, no refs need to be taken */
+    stp = ptbl->mds[readyfd].stp;
+    stp_out = ptbl->mds[readyfd].sendr;
+    /* Session is gone, the table is yet to be updated */
+    sp = CALL_METHOD(cfsp->sessions_wrt, get_by_idx, stp->seuid);
+    if (sp == NULL) {
+        return (0);
+    }
+    iskt = ptbl->mds[readyfd].skt;
+    nused = 0;
+    if (sp->complete != 0) {
+        nused = rxmit_packets(cfsp, stp, stp_out, dtime, drain_repeat, sender,
+          rsp, sp, iskt, rbp);
+        RTPP_OBJ_DECREF(sp);
+        /*
+         * Using the budget up is what any stream above the quantum rate
+         * does every tick, it's only throttled if there is more queued.
+         */
+        if (nused >= drain_repeat && CALL_METHOD(iskt, rx_backlog) > 0) {
+            CALL_METHOD(stp->pcnt_strm, reg_throttled);
+            rsp->nrx_budget_hits.cnt++;
+        }
+        if (stp->resizer != NULL) {
+            while ((packet = rtp_resizer_get(stp->resizer, dtime->mono)) != NULL) {
+                send_packet(cfsp, stp, stp_out, packet, sender, rsp);
+                rsp->npkts_resizer_out.cnt++;
+                packet = NULL;
+            }
+        }
+    } else {
+        const char *proto;
+
+        RTPP_OBJ_DECREF(sp);
+        proto = CALL_SMETHOD(stp, get_proto);
+        ndrained = CALL_METHOD(iskt, drain, proto, stp->log);
+        if (ndrained > 0) {
+            rsp->npkts_discard.cnt += ndrained;
+        }
+    }
+    return (nused);
+}
+
+/*
+ * Serve one socket within the deficit round robin. Every round a socket
+ * is credited with the quantum of packets, credit that has not been used
+ * is carried over to the following rounds up to the drr_carry limit.
+ * Socket that has used all of its credit up is likely to have more queued
+ * and goes into the backlog, to be served ahead of the others next round.
+ */
+static void
+drr_serve(const struct rtpp_cfg *cfsp, struct rtpp_polltbl *ptbl,
+  int readyfd, const struct rtpp_timestamp *dtime, int quantum, int carry,
+  struct sthread_args *sender, struct rtpp_proc_rstats *rsp,
+  struct rtpp_proc_rxbatch *rbp)
+{
+    struct rtpp_polltbl_mdata *mdp;
+    uint64_t nrounds;
+    int credit, nused;
+
+    mdp = &ptbl->mds[readyfd];
+    nrounds = ptbl->nrounds - mdp->lastrun;
+    if (nrounds > (uint64_t)(carry / quantum) + 1)
+        nrounds = (carry / quantum) + 1;
+    credit = mdp->deficit + (int)nrounds * quantum;
+    if (credit > quantum + carry)
+        credit = quantum + carry;
+    mdp->lastrun = ptbl->nrounds;
+    if (credit <= 0) {
+        /* Still paying off the overdraft (i.e. UDP_GRO leftovers) */
+        mdp->deficit = credit;
+        goto backlog;
+    }
+    nused = process_rtp_ready(cfsp, ptbl, readyfd, dtime, credit, sender, rsp,
+      rbp);
+    mdp->deficit = credit - nused;
+    if (nused < credit)
+        return;
+backlog:
+    if (ptbl->blen < ptbl->balen)
+        ptbl->backlog[ptbl->blen++] = readyfd;
+}
+
+void
+process_rtp_only(const struct rtpp_cfg *cfsp, struct rtpp_polltbl *ptbl,
+  const struct rtpp_timestamp *dtime, int quantum, struct sthread_args *sender,
+  struct rtpp_proc_rstats *rsp, struct rtpp_proc_rxbatch *rbp)
+{
+    int readyfd, carry, i, nbl;
+    int *backlog;
+
+    if (cfsp->drr_quantum > 0)
+        quantum = cfsp->drr_quantum;
+    carry = (cfsp->drr_carry >= 0) ? cfsp->drr_carry : quantum;
+    ptbl->nrounds++;
+
+    /*
+     * Backlog refers to the table slots, which are only valid as long as
+     * the table has not been re-synced since.
+     */
+    nbl = (ptbl->brevision == ptbl->revision) ? ptbl->blen : 0;
+    ptbl->blen = 0;
+    if (ptbl->balen < ptbl->curlen) {
+        backlog = realloc(ptbl->backlog, ptbl->curlen * sizeof(ptbl->backlog[0]));
+        if (backlog != NULL) {
+            ptbl->backlog = backlog;
+            ptbl->balen = ptbl->curlen;
+        }
+    }
+    /* Served sockets are re-queued in place, never ahead of the current one */
+    for (i = 0; i < nbl; i++) {
+        drr_serve(cfsp, ptbl, ptbl->backlog[i], dtime, quantum, carry, sender,
+          rsp, rbp);
+    }
+
+#if HAVE_SYS_EPOLL_H
+    if (ptbl->epfd >= 0) {
+        for (i = 0; i < ptbl->nready; i++) {
+            if ((ptbl->events[i].events & EPOLLIN) == 0)
+                continue;
+            readyfd = ptbl->events[i].data.u32;
+            if (ptbl->mds[readyfd].lastrun == ptbl->nrounds)
+                continue;
+            drr_serve(cfsp, ptbl, readyfd, dtime, quantum, carry, sender,
+              rsp, rbp);
+        }
+        goto done;
+    }
+#endif
     for (readyfd = 0; readyfd < ptbl->curlen; readyfd++) {
         if ((ptbl->pfds[readyfd].revents & POLLIN) == 0)
             continue;
-        stp = CALL_METHOD(ptbl->streams_wrt, get_by_idx,
-          ptbl->mds[readyfd].stuid);
-        if (stp == NULL)
-            continue;
-        sp = CALL_METHOD(cfsp->sessions_wrt, get_by_idx, stp->seuid);
-        if (sp == NULL) {
-            RTPP_OBJ_DECREF(stp);
+        if (ptbl->mds[readyfd].lastrun == ptbl->nrounds)
             continue;
-        }
-        iskt = ptbl->mds[readyfd].skt;
-        if (sp->complete != 0) {
-            rxmit_packets(cfsp, stp, dtime, drain_repeat, sender, rsp, sp);
-            RTPP_OBJ_DECREF(sp);
-            if (stp->resizer != NULL) {
-                while ((packet = rtp_resizer_get(stp->resizer, dtime->mono)) != NULL) {
-                    send_packet(cfsp, stp, packet, sender, rsp);
-                    rsp->npkts_resizer_out.cnt++;
-                    packet = NULL;
-                }
-            }
-        } else {
-            const char *proto;
-
-            RTPP_OBJ_DECREF(sp);
-            proto = CALL_SMETHOD(stp, get_proto);
-            ndrained = CALL_METHOD(iskt, drain, proto, stp->log);
-            if (ndrained > 0) {
-                rsp->npkts_discard.cnt += ndrained;
-            }
-        }
-        RTPP_OBJ_DECREF(stp);
+        drr_serve(cfsp, ptbl, readyfd, dtime, quantum, carry, sender, rsp,
+          rbp);
     }
+#if HAVE_SYS_EPOLL_H
+done:
+#endif
+    ptbl->brevision = ptbl->revision;
 }
@@ -32,6 +32,7 @@ struct sthread_args;
 struct rtpp_polltbl;
 struct rtpp_timestamp;
 struct rtpp_cfg;
+struct rtp_packet;
 
 struct rtpp_proc_stat {
     uint64_t cnt;
@@ -46,12 +47,30 @@ struct rtpp_proc_rstats {
     struct rtpp_proc_stat npkts_resizer_out;
     struct rtpp_proc_stat npkts_resizer_discard;
     struct rtpp_proc_stat npkts_discard;
+    struct rtpp_proc_stat npkts_policed;
+    struct rtpp_proc_stat nrx_budget_hits;
 };
 
+/* Upper limit on the --drr_quantum / --drr_carry */
+#define RTPP_PROC_DRR_MAX 65536
+
+/* Max number of packets received from a single socket in one go */
+#define RTPP_PROC_RXB_MAXLEN 16
+
+/*
+ * Per-thread pool of the pre-allocated packets to receive into, slots
+ * consumed by the batch receive are re-filled on the next use.
+ */
+struct rtpp_proc_rxbatch {
+    struct rtp_packet *pkts[RTPP_PROC_RXB_MAXLEN];
+};
+
+void rtpp_proc_rxbatch_free(struct rtpp_proc_rxbatch *);
 void process_rtp_servers(const struct rtpp_cfg *, double,
   struct sthread_args *, struct rtpp_proc_rstats *);
 void process_rtp_only(const struct rtpp_cfg *,
   struct rtpp_polltbl *, const struct rtpp_timestamp *, int,
-  struct sthread_args *sender, struct rtpp_proc_rstats *);
+  struct sthread_args *sender, struct rtpp_proc_rstats *,
+  struct rtpp_proc_rxbatch *);
 
 #endif
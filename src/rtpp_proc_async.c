@@ -26,6 +26,7 @@
  */
 
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <netinet/in.h>
 #include <assert.h>
 #include <errno.h>
@@ -40,6 +41,13 @@
 
 #include "config.h"
 
+#if HAVE_SYS_EPOLL_H && HAVE_SYS_TIMERFD_H && HAVE_SYS_EVENTFD_H
+#define RTPP_PROC_TICKLESS 1
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
 #include "rtpp_log.h"
 #include "rtpp_cfg.h"
 #include "rtpp_defines.h"
@@ -57,6 +65,7 @@
 #include "rtpp_stats.h"
 #include "rtpp_time.h"
 #include "rtpp_pipe.h"
+#include "rtpp_uring.h"
 
 struct elp_data {
     void *obj;
@@ -66,14 +75,91 @@ struct elp_data {
     double target_pfreq;
 };
 
-struct rtpp_proc_async_cf {
-    struct rtpp_proc_async pub;
+struct rtpp_proc_async_cf;
+
+/*
+ * Forwarding worker, handles a disjoint shard of the sessions as
+ * assigned by the rtpp_sessinfo.
+ */
+struct rtpp_proc_worker {
     pthread_t thread_id;
+    int wid;
     struct rtpp_proc_rstats rstats;
-    const struct rtpp_cfg *cf_save;
-    atomic_int tstate;
     struct elp_data elp_fs;
     struct elp_data elp_lz;
+    int overload;
+    int busy;
+    /* Players in our shard as of the last round */
+    int nplayers;
+    struct rtpp_proc_async_cf *proc_cf;
+};
+
+#if RTPP_PROC_TICKLESS
+/*
+ * Event-driven (tickless) mode: the worker sleeps in an epoll(7) set that
+ * has both per-pipe tables nested into it, along with the timerfd(2) armed
+ * for the next deadline and the eventfd(2) that rtpp_sessinfo kicks when
+ * our shard changes. Load is the fraction of time spent outside of that
+ * sleep.
+ */
+struct rtpp_proc_tkl {
+    int epfd;
+    int tfd;
+    int wakefd;
+    long long nwakes;
+    double tlast;       /* when the last sleep has ended */
+    double tprev;       /* ... and the one before it */
+    double tbusy;
+    double tidle;
+};
+
+#define TKL_WAKE        0
+#define TKL_TIMER       1
+#define TKL_RTP         2
+#define TKL_RTCP        3
+#define TKL_EV(n)       (1 << (n))
+
+/* Longest sleep when nothing is due, matches the lazy periodic rate */
+#define TKL_LZ_TMO      0.1
+/* How often the busy/idle ratio is evaluated */
+#define TKL_LOAD_IVAL   1.0
+#endif
+
+/*
+ * Busy-poll mode: the worker never sleeps, it keeps polling both tables
+ * with zero timeout. Syncing the tables with rtpp_sessinfo and serving
+ * the players is still done at the target_pfreq.
+ */
+struct rtpp_proc_bpoll {
+    double tnext;       /* when the next periodic round is due */
+    double tstat;       /* ... and the next stats / load update */
+    double tprev;       /* when the last round that did anything started */
+    double tspin;
+    double twork;
+    long long nrounds;
+};
+
+/* How often spin / work times are reported */
+#define BPOLL_STAT_IVAL 1.0
+
+/*
+ * Packets backing the io_uring(7) receive ring of each worker, any of the
+ * sockets can take any of those. Ring that has run dry stops receiving
+ * until the next cycle.
+ */
+#define RTPP_PROC_URING_NBUFS 512
+
+/* How far ahead player output is generated when paced by the kernel */
+#define TXTIME_LOOKAHEAD(cfsp) (2.0 / (cfsp)->target_pfreq)
+
+struct rtpp_proc_async_cf {
+    struct rtpp_proc_async pub;
+    const struct rtpp_cfg *cf_save;
+    atomic_int tstate;
+    /* Number of workers that are currently in the overload state */
+    atomic_int noverload;
+    int nworkers;
+    struct rtpp_proc_worker *workers;
 };
 
 #define TSTATE_RUN   0x0
@@ -99,6 +185,8 @@ flush_rstats(struct rtpp_stats *sobj, struct rtpp_proc_rstats *rsp)
     FLUSH_STAT(sobj, rsp->npkts_resizer_out);
     FLUSH_STAT(sobj, rsp->npkts_resizer_discard);
     FLUSH_STAT(sobj, rsp->npkts_discard);
+    FLUSH_STAT(sobj, rsp->npkts_policed);
+    FLUSH_STAT(sobj, rsp->nrx_budget_hits);
 }
 
 static void
@@ -112,6 +200,333 @@ init_rstats(struct rtpp_stats *sobj, struct rtpp_proc_rstats *rsp)
     rsp->npkts_resizer_out.cnt_idx = CALL_SMETHOD(sobj, getidxbyname, "npkts_resizer_out");
     rsp->npkts_resizer_discard.cnt_idx = CALL_SMETHOD(sobj, getidxbyname, "npkts_resizer_discard");
     rsp->npkts_discard.cnt_idx = CALL_SMETHOD(sobj, getidxbyname, "npkts_discard");
+    rsp->npkts_policed.cnt_idx = CALL_SMETHOD(sobj, getidxbyname, "npkts_policed");
+    rsp->nrx_budget_hits.cnt_idx = CALL_SMETHOD(sobj, getidxbyname, "nrx_budget_hits");
+}
+
+static void
+rtpp_proc_async_setoverload(struct rtpp_proc_async_cf *proc_cf, int overload)
+{
+    const struct rtpp_cfg *cfsp;
+
+    cfsp = proc_cf->cf_save;
+    /* Overloaded is when at least one of the workers is */
+    if (overload) {
+        if (atomic_fetch_add(&proc_cf->noverload, 1) == 0)
+            CALL_METHOD(cfsp->rtpp_cmd_cf, reg_overload, 1);
+    } else {
+        if (atomic_fetch_sub(&proc_cf->noverload, 1) == 1)
+            CALL_METHOD(cfsp->rtpp_cmd_cf, reg_overload, 0);
+    }
+}
+
+static void
+rtpp_proc_async_chkload(struct rtpp_proc_worker *wrk, long long ncycles,
+  double lv)
+{
+    const struct rtpp_cfg *cfsp;
+    struct rtpp_proc_async_cf *proc_cf;
+
+    proc_cf = wrk->proc_cf;
+    cfsp = proc_cf->cf_save;
+    if (cfsp->overload_prot.ecode != 0) {
+        if (wrk->overload  && lv < 0.85) {
+            wrk->overload = 0;
+            rtpp_proc_async_setoverload(proc_cf, 0);
+        } else if (wrk->overload == 0 && lv > 0.9) {
+            wrk->overload = 1;
+            rtpp_proc_async_setoverload(proc_cf, 1);
+        }
+        RTPP_LOG(cfsp->glog, RTPP_LOG_INFO, "worker %d: ncycles=%lld "
+          "load=%f", wrk->wid, ncycles, lv);
+    }
+    if (cfsp->inline_send != 0) {
+        if (wrk->busy && lv < 0.4) {
+            wrk->busy = 0;
+            rtpp_anetio_setbusy(proc_cf->pub.netio, 0);
+        } else if (wrk->busy == 0 && lv > 0.6) {
+            wrk->busy = 1;
+            rtpp_anetio_setbusy(proc_cf->pub.netio, 1);
+        }
+    }
+}
+
+static void
+rtpp_proc_async_process(struct rtpp_proc_worker *wrk,
+  struct rtpp_polltbl *ptbl_rtp, int nready_rtp,
+  struct rtpp_polltbl *ptbl_rtcp, int nready_rtcp, int ndrain,
+  struct rtpp_proc_rxbatch *rbp)
+{
+    const struct rtpp_cfg *cfsp;
+    struct rtpp_proc_async_cf *proc_cf;
+    struct sthread_args *sender;
+    struct rtpp_timestamp rtime;
+
+    proc_cf = wrk->proc_cf;
+    cfsp = proc_cf->cf_save;
+
+    rtpp_timestamp_get(&rtime);
+    RTPP_DBG_ASSERT(rtime.wall > 0 && rtime.mono > 0);
+
+    sender = rtpp_anetio_pick_sender(proc_cf->pub.netio, wrk->wid);
+    if (nready_rtp > 0) {
+        process_rtp_only(cfsp, ptbl_rtp, &rtime, ndrain, sender,
+          &wrk->rstats, rbp);
+    }
+    if (nready_rtcp > 0) {
+        process_rtp_only(cfsp, ptbl_rtcp, &rtime, ndrain, sender,
+          &wrk->rstats, rbp);
+    }
+
+    /*
+     * Each worker plays into the streams of its own shard. With the
+     * kernel pacing the output, packets that are due before the next
+     * round or so are handed over right away.
+     */
+    wrk->nplayers = 0;
+    if (CALL_METHOD(cfsp->servers_wrt, get_length) > 0) {
+        wrk->nplayers = rtpp_proc_servers(cfsp, (cfsp->txtime != 0) ?
+          rtime.mono + TXTIME_LOOKAHEAD(cfsp) : rtime.mono, sender,
+          &wrk->rstats, wrk->wid);
+    }
+
+    rtpp_anetio_pump(proc_cf->pub.netio);
+    flush_rstats(cfsp->rtpp_stats, &wrk->rstats);
+}
+
+#if RTPP_PROC_TICKLESS
+static int
+rtpp_proc_tkl_add(struct rtpp_proc_tkl *tkp, int fd, int tag)
+{
+    struct epoll_event ev;
+
+    memset(&ev, '\0', sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = tag;
+    return (epoll_ctl(tkp->epfd, EPOLL_CTL_ADD, fd, &ev));
+}
+
+static int
+rtpp_proc_tkl_init(struct rtpp_proc_tkl *tkp, int wakefd,
+  const struct rtpp_polltbl *ptbl_rtp, const struct rtpp_polltbl *ptbl_rtcp)
+{
+
+    memset(tkp, '\0', sizeof(*tkp));
+    if (wakefd < 0 || ptbl_rtp->epfd < 0 || ptbl_rtcp->epfd < 0)
+        goto e0;
+    tkp->wakefd = wakefd;
+    tkp->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (tkp->epfd < 0)
+        goto e0;
+    tkp->tfd = timerfd_create(RTPP_CLOCK_MONO, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tkp->tfd < 0)
+        goto e1;
+    if (rtpp_proc_tkl_add(tkp, tkp->wakefd, TKL_WAKE) != 0 ||
+      rtpp_proc_tkl_add(tkp, tkp->tfd, TKL_TIMER) != 0 ||
+      rtpp_proc_tkl_add(tkp, ptbl_rtp->epfd, TKL_RTP) != 0 ||
+      rtpp_proc_tkl_add(tkp, ptbl_rtcp->epfd, TKL_RTCP) != 0)
+        goto e2;
+    tkp->tlast = tkp->tprev = getdtime();
+    return (0);
+e2:
+    close(tkp->tfd);
+e1:
+    close(tkp->epfd);
+e0:
+    tkp->epfd = -1;
+    return (-1);
+}
+
+static void
+rtpp_proc_tkl_fini(struct rtpp_proc_tkl *tkp)
+{
+
+    close(tkp->tfd);
+    close(tkp->epfd);
+    tkp->epfd = -1;
+}
+
+/*
+ * Sleep until either of the tables has something for us, sessinfo pokes
+ * us or the timeout expires. Returns mask of TKL_EV() bits, or -1 if the
+ * sleep has been interrupted.
+ */
+static int
+rtpp_proc_tkl_wait(struct rtpp_proc_tkl *tkp, double tmo)
+{
+    struct epoll_event evs[4];
+    struct itimerspec its;
+    uint64_t junk;
+    double tsleep;
+    int i, nev, rdy, tag;
+
+    memset(&its, '\0', sizeof(its));
+    dtime2mtimespec(tmo, &its.it_value);
+    timerfd_settime(tkp->tfd, 0, &its, NULL);
+
+    tsleep = getdtime();
+    tkp->tbusy += tsleep - tkp->tlast;
+    nev = epoll_wait(tkp->epfd, evs, 4, -1);
+    tkp->tprev = tkp->tlast;
+    tkp->tlast = getdtime();
+    tkp->tidle += tkp->tlast - tsleep;
+    tkp->nwakes++;
+    if (nev < 0)
+        return (-1);
+    rdy = 0;
+    for (i = 0; i < nev; i++) {
+        tag = evs[i].data.u32;
+        if (tag == TKL_WAKE || tag == TKL_TIMER) {
+            /* Just reset the counter, its value is of no interest */
+            if (read((tag == TKL_WAKE) ? tkp->wakefd : tkp->tfd, &junk,
+              sizeof(junk)) < 0)
+                continue;
+        }
+        rdy |= TKL_EV(tag);
+    }
+    return (rdy);
+}
+
+/*
+ * Time until the next thing that is not driven by the socket readiness.
+ * Resizer output is clocked by the input packets (see process_rtp_ready()),
+ * RTCP and TTL have their own descriptors / threads, so this leaves just
+ * the players which emit a packet at most once per ptime. Only those in
+ * our own shard count, a new one gets us woken up by the command handler.
+ */
+static double
+rtpp_proc_tkl_deadline(struct rtpp_proc_worker *wrk)
+{
+    const struct rtpp_cfg *cfsp;
+
+    cfsp = wrk->proc_cf->cf_save;
+    if (wrk->nplayers > 0)
+        return (1.0 / cfsp->target_pfreq);
+    return (TKL_LZ_TMO);
+}
+
+/*
+ * Runs until the shutdown, or until epoll(7) fails us in the middle, in
+ * which case the caller falls back to the periodic mode.
+ */
+static void
+rtpp_proc_async_tickless(struct rtpp_proc_worker *wrk,
+  struct rtpp_proc_tkl *tkp, struct rtpp_polltbl *ptbl_rtp,
+  struct rtpp_polltbl *ptbl_rtcp, struct rtpp_proc_rxbatch *rbp)
+{
+    const struct rtpp_cfg *cfsp;
+    struct rtpp_proc_async_cf *proc_cf;
+    int ndrain, rdy, nready_rtp, nready_rtcp;
+    double ttot;
+
+    proc_cf = wrk->proc_cf;
+    cfsp = proc_cf->cf_save;
+
+    while (atomic_load(&proc_cf->tstate) == TSTATE_RUN) {
+        CALL_METHOD(cfsp->sessinfo, sync_polltbl, ptbl_rtp, PIPE_RTP);
+        CALL_METHOD(cfsp->sessinfo, sync_polltbl, ptbl_rtcp, PIPE_RTCP);
+        if (ptbl_rtp->epfd < 0 || ptbl_rtcp->epfd < 0) {
+            RTPP_ELOG(cfsp->glog, RTPP_LOG_ERR, "worker %d: epoll(7) has "
+              "failed, falling back to the periodic mode", wrk->wid);
+            return;
+        }
+        rdy = rtpp_proc_tkl_wait(tkp, rtpp_proc_tkl_deadline(wrk));
+        if (rdy < 0)
+            continue;
+
+        ttot = tkp->tbusy + tkp->tidle;
+        if (ttot >= TKL_LOAD_IVAL) {
+            if (cfsp->overload_prot.ecode != 0 || cfsp->inline_send != 0) {
+                rtpp_proc_async_chkload(wrk, tkp->nwakes, tkp->tbusy / ttot);
+            }
+            tkp->tbusy = tkp->tidle = 0.0;
+        }
+        ndrain = (tkp->tlast - tkp->tprev) * MAX_RTP_RATE;
+        if (ndrain < 1) {
+            ndrain = 1;
+        }
+
+        nready_rtp = nready_rtcp = 0;
+        if (rdy & TKL_EV(TKL_RTP))
+            nready_rtp = rtpp_polltbl_wait(ptbl_rtp, 0);
+        if (rdy & TKL_EV(TKL_RTCP))
+            nready_rtcp = rtpp_polltbl_wait(ptbl_rtcp, 0);
+
+        rtpp_proc_async_process(wrk, ptbl_rtp, nready_rtp, ptbl_rtcp,
+          nready_rtcp, ndrain, rbp);
+    }
+}
+#endif
+
+static void
+rtpp_proc_async_bpoll_stat(struct rtpp_proc_worker *wrk,
+  struct rtpp_proc_bpoll *bpp)
+{
+    const struct rtpp_cfg *cfsp;
+    double ttot;
+
+    cfsp = wrk->proc_cf->cf_save;
+    CALL_SMETHOD(cfsp->rtpp_stats, updatebyname_d, "bpoll_time_spin",
+      bpp->tspin);
+    CALL_SMETHOD(cfsp->rtpp_stats, updatebyname_d, "bpoll_time_work",
+      bpp->twork);
+    ttot = bpp->tspin + bpp->twork;
+    if (ttot > 0 &&
+      (cfsp->overload_prot.ecode != 0 || cfsp->inline_send != 0)) {
+        rtpp_proc_async_chkload(wrk, bpp->nrounds, bpp->twork / ttot);
+    }
+    bpp->tspin = bpp->twork = 0.0;
+}
+
+static void
+rtpp_proc_async_busypoll(struct rtpp_proc_worker *wrk,
+  struct rtpp_polltbl *ptbl_rtp, struct rtpp_polltbl *ptbl_rtcp,
+  struct rtpp_proc_rxbatch *rbp)
+{
+    const struct rtpp_cfg *cfsp;
+    struct rtpp_proc_async_cf *proc_cf;
+    struct rtpp_proc_bpoll bp;
+    int due, ndrain, nready_rtp, nready_rtcp;
+    double tnow, tdone;
+
+    proc_cf = wrk->proc_cf;
+    cfsp = proc_cf->cf_save;
+
+    memset(&bp, '\0', sizeof(bp));
+    bp.tnext = bp.tprev = getdtime();
+    bp.tstat = bp.tnext + BPOLL_STAT_IVAL;
+
+    while (atomic_load(&proc_cf->tstate) == TSTATE_RUN) {
+        tnow = getdtime();
+        due = (tnow >= bp.tnext);
+        if (due) {
+            CALL_METHOD(cfsp->sessinfo, sync_polltbl, ptbl_rtp, PIPE_RTP);
+            CALL_METHOD(cfsp->sessinfo, sync_polltbl, ptbl_rtcp, PIPE_RTCP);
+            bp.tnext = tnow + (1.0 / cfsp->target_pfreq);
+            bp.nrounds++;
+        }
+        nready_rtp = rtpp_polltbl_wait(ptbl_rtp, 0);
+        nready_rtcp = rtpp_polltbl_wait(ptbl_rtcp, 0);
+        if (nready_rtp > 0 || nready_rtcp > 0 || due) {
+            ndrain = (tnow - bp.tprev) * MAX_RTP_RATE;
+            if (ndrain < 1) {
+                ndrain = 1;
+            }
+            bp.tprev = tnow;
+            rtpp_proc_async_process(wrk, ptbl_rtp, nready_rtp, ptbl_rtcp,
+              nready_rtcp, ndrain, rbp);
+            tdone = getdtime();
+            bp.twork += tdone - tnow;
+        } else {
+            tdone = getdtime();
+            bp.tspin += tdone - tnow;
+        }
+        if (tdone >= bp.tstat) {
+            rtpp_proc_async_bpoll_stat(wrk, &bp);
+            bp.tstat = tdone + BPOLL_STAT_IVAL;
+        }
+    }
+    rtpp_proc_async_bpoll_stat(wrk, &bp);
 }
 
 static void
@@ -120,33 +535,66 @@ rtpp_proc_async_run(void *arg)
     const struct rtpp_cfg *cfsp;
     int ndrain, rtp_only;
     int nready_rtp, nready_rtcp;
+    struct rtpp_proc_worker *wrk;
     struct rtpp_proc_async_cf *proc_cf;
     long long last_ctick;
-    struct sthread_args *sender;
-    struct rtpp_proc_rstats *rstats;
-    struct rtpp_stats *stats_cf;
     struct rtpp_polltbl ptbl_rtp;
     struct rtpp_polltbl ptbl_rtcp;
-    int tstate, overload;
-    struct rtpp_timestamp rtime;
+    struct rtpp_proc_rxbatch rxbatch;
+    int tstate;
     struct elp_data *edp;
+    struct rtpp_uring_rx *urx;
+#if RTPP_PROC_TICKLESS
+    struct rtpp_proc_tkl tkl;
+#endif
 
-    proc_cf = (struct rtpp_proc_async_cf *)arg;
+    wrk = (struct rtpp_proc_worker *)arg;
+    proc_cf = wrk->proc_cf;
     cfsp = proc_cf->cf_save;
-    stats_cf = cfsp->rtpp_stats;
-    rstats = &proc_cf->rstats;
 
-    memset(&ptbl_rtp, '\0', sizeof(struct rtpp_polltbl));
-    memset(&ptbl_rtcp, '\0', sizeof(struct rtpp_polltbl));
+    urx = NULL;
+    if (cfsp->recv_engine == RTPP_RECV_URING) {
+        urx = rtpp_uring_rx_ctor(RTPP_PROC_URING_NBUFS);
+        if (urx == NULL) {
+            RTPP_ELOG(cfsp->glog, RTPP_LOG_ERR, "worker %d: can't set up "
+              "io_uring(7) receive ring, falling back to the poll engine",
+              wrk->wid);
+        }
+    }
+    if (rtpp_polltbl_init(&ptbl_rtp, cfsp->poll_engine, wrk->wid, urx) != 0) {
+        RTPP_ELOG(cfsp->glog, RTPP_LOG_ERR, "worker %d: can't initialize "
+          "epoll(7) for RTP, falling back to poll(2)", wrk->wid);
+    }
+    if (rtpp_polltbl_init(&ptbl_rtcp, cfsp->poll_engine, wrk->wid, urx) != 0) {
+        RTPP_ELOG(cfsp->glog, RTPP_LOG_ERR, "worker %d: can't initialize "
+          "epoll(7) for RTCP, falling back to poll(2)", wrk->wid);
+    }
 
-    memset(&rtime, '\0', sizeof(rtime));
+    memset(&rxbatch, '\0', sizeof(rxbatch));
 
     RTPP_DBGCODE(netio) {
         last_ctick = 0;
     }
-    overload = 0;
 
-    edp = &proc_cf->elp_lz;
+#if RTPP_PROC_TICKLESS
+    if (cfsp->tickless != 0) {
+        if (rtpp_proc_tkl_init(&tkl, CALL_METHOD(cfsp->sessinfo, get_wakefd,
+          wrk->wid), &ptbl_rtp, &ptbl_rtcp) == 0) {
+            rtpp_proc_async_tickless(wrk, &tkl, &ptbl_rtp, &ptbl_rtcp,
+              &rxbatch);
+            rtpp_proc_tkl_fini(&tkl);
+        } else {
+            RTPP_ELOG(cfsp->glog, RTPP_LOG_ERR, "worker %d: can't initialize "
+              "tickless mode, falling back to the periodic one", wrk->wid);
+        }
+    }
+#endif
+
+    if (cfsp->busy_poll != 0) {
+        rtpp_proc_async_busypoll(wrk, &ptbl_rtp, &ptbl_rtcp, &rxbatch);
+    }
+
+    edp = &wrk->elp_lz;
 
     for (;;) {
         tstate = atomic_load(&proc_cf->tstate);
@@ -154,18 +602,10 @@ rtpp_proc_async_run(void *arg)
             break;
         }
         edp->ncycles_ref = (long long)prdic_getncycles_ref(edp->obj);
-        if (cfsp->overload_prot.ecode != 0 && edp->ncycles_chk_ol <= edp->ncycles_ref) {
-            double lv = prdic_getload(edp->obj);
-
-            if (overload  && lv < 0.85) {
-                overload = 0;
-                CALL_METHOD(cfsp->rtpp_cmd_cf, reg_overload, 0);
-            } else if (overload == 0 && lv > 0.9) {
-                overload = 1;
-                CALL_METHOD(cfsp->rtpp_cmd_cf, reg_overload, 1);
-            }
-            RTPP_LOG(cfsp->glog, RTPP_LOG_INFO, "ncycles=%lld load=%f",
-              edp->ncycles_ref, lv);
+        if ((cfsp->overload_prot.ecode != 0 || cfsp->inline_send != 0) &&
+          edp->ncycles_chk_ol <= edp->ncycles_ref) {
+            rtpp_proc_async_chkload(wrk, edp->ncycles_ref,
+              prdic_getload(edp->obj));
             edp->ncycles_chk_ol = ((edp->ncycles_ref / 200) + 1) * 200;
         }
         ndrain = ((edp->ncycles_ref - edp->ncycles_ref_last) * MAX_RTP_RATE) / edp->target_pfreq;
@@ -185,14 +625,19 @@ rtpp_proc_async_run(void *arg)
         if (rtp_only == 0)
             CALL_METHOD(cfsp->sessinfo, sync_polltbl, &ptbl_rtcp, PIPE_RTCP);
         nready_rtp = nready_rtcp = 0;
-        if (ptbl_rtp.curlen > 0) {
+        /*
+         * With the receive ring the sockets that have just been removed
+         * are only let go of once their cancellation has been reaped, so
+         * keep at it even when there is nothing left to poll.
+         */
+        if (ptbl_rtp.curlen > 0 || urx != NULL) {
             if (rtp_only == 0) {
                 RTPP_DBGCODE(netio > 1) {
                     RTPP_LOG(cfsp->glog, RTPP_LOG_DBUG, "run %lld " \
                       "polling for %d RTCP file descriptors", \
                       last_ctick, ptbl_rtcp.curlen);
                 }
-                nready_rtcp = poll(ptbl_rtcp.pfds, ptbl_rtcp.curlen, 0);
+                nready_rtcp = rtpp_polltbl_wait(&ptbl_rtcp, 0);
                 RTPP_DBGCODE(netio) {
                     RTPP_DBGCODE(netio > 1 || nready_rtcp > 0) {
                         RTPP_LOG(cfsp->glog, RTPP_LOG_DBUG, "run %lld " \
@@ -206,7 +651,7 @@ rtpp_proc_async_run(void *arg)
                   "polling for %d RTP file descriptors", \
                   last_ctick, ptbl_rtp.curlen);
             }
-            nready_rtp = poll(ptbl_rtp.pfds, ptbl_rtp.curlen, 0);
+            nready_rtp = rtpp_polltbl_wait(&ptbl_rtp, 0);
             RTPP_DBGCODE(netio) {
                 RTPP_DBGCODE(netio > 1 || nready_rtp > 0) {
                     RTPP_LOG(cfsp->glog, RTPP_LOG_DBUG, "run %lld " \
@@ -219,31 +664,16 @@ rtpp_proc_async_run(void *arg)
             }
         }
 
-        rtpp_timestamp_get(&rtime);
-        RTPP_DBG_ASSERT(rtime.wall > 0 && rtime.mono > 0);
-
-        sender = rtpp_anetio_pick_sender(proc_cf->pub.netio);
-        if (nready_rtp > 0) {
-            process_rtp_only(cfsp, &ptbl_rtp, &rtime, ndrain, sender, rstats);
-        }
-        if (nready_rtcp > 0 && rtp_only == 0) {
-            process_rtp_only(cfsp, &ptbl_rtcp, &rtime, ndrain, sender, rstats);
-        }
-
-        if (CALL_METHOD(cfsp->servers_wrt, get_length) > 0) {
-            rtpp_proc_servers(cfsp, rtime.mono, sender, rstats);
-        }
-
-        rtpp_anetio_pump_q(sender);
-        flush_rstats(stats_cf, rstats);
+        rtpp_proc_async_process(wrk, &ptbl_rtp, nready_rtp, &ptbl_rtcp,
+          nready_rtcp, ndrain, &rxbatch);
 
         if (ptbl_rtp.curlen > 0 || ptbl_rtcp.curlen > 0) {
-            if (edp == &proc_cf->elp_lz) {
-                edp = &proc_cf->elp_fs;
+            if (edp == &wrk->elp_lz) {
+                edp = &wrk->elp_fs;
             }
         } else {
-            if (edp == &proc_cf->elp_fs) {
-                edp = &proc_cf->elp_lz;
+            if (edp == &wrk->elp_fs) {
+                edp = &wrk->elp_lz;
             }
         }
         prdic_procrastinate(edp->obj);
@@ -253,48 +683,107 @@ rtpp_proc_async_run(void *arg)
     }
     rtpp_polltbl_free(&ptbl_rtp);
     rtpp_polltbl_free(&ptbl_rtcp);
+    if (urx != NULL)
+        rtpp_uring_rx_dtor(urx);
+    rtpp_proc_rxbatch_free(&rxbatch);
+}
+
+static int
+rtpp_proc_worker_init(struct rtpp_proc_worker *wrk, const struct rtpp_cfg *cfsp)
+{
+
+    init_rstats(cfsp->rtpp_stats, &wrk->rstats);
+
+    wrk->elp_fs.obj = prdic_init(cfsp->target_pfreq, 0.0);
+    if (wrk->elp_fs.obj == NULL) {
+        goto e0;
+    }
+    wrk->elp_fs.target_pfreq = cfsp->target_pfreq;
+    wrk->elp_lz.obj = prdic_init(10.0, 0.0);
+    if (wrk->elp_lz.obj == NULL) {
+        goto e1;
+    }
+    wrk->elp_lz.target_pfreq = 10.0;
+    return (0);
+e1:
+    prdic_free(wrk->elp_fs.obj);
+e0:
+    return (-1);
+}
+
+static void
+rtpp_proc_worker_fini(struct rtpp_proc_worker *wrk)
+{
+
+    prdic_free(wrk->elp_lz.obj);
+    prdic_free(wrk->elp_fs.obj);
+}
+
+static void
+rtpp_proc_async_stop(struct rtpp_proc_async_cf *proc_cf, int nstarted)
+{
+    int i;
+
+    atomic_store(&proc_cf->tstate, TSTATE_CEASE);
+    for (i = 0; i < nstarted; i++) {
+        /* No-op unless in the tickless mode */
+        CALL_METHOD(proc_cf->cf_save->sessinfo, wakeup, i);
+        pthread_join(proc_cf->workers[i].thread_id, NULL);
+    }
 }
 
 struct rtpp_proc_async *
 rtpp_proc_async_ctor(const struct rtpp_cfg *cfsp)
 {
     struct rtpp_proc_async_cf *proc_cf;
+    struct rtpp_proc_worker *wrk;
+    int i, ninit, nstarted;
 
     proc_cf = rtpp_zmalloc(sizeof(*proc_cf));
     if (proc_cf == NULL)
         return (NULL);
 
-    init_rstats(cfsp->rtpp_stats, &proc_cf->rstats);
+    proc_cf->nworkers = (cfsp->nworkers > 0) ? cfsp->nworkers : 1;
+    proc_cf->workers = rtpp_zmalloc(sizeof(proc_cf->workers[0]) *
+      proc_cf->nworkers);
+    if (proc_cf->workers == NULL) {
+        goto e0;
+    }
 
     proc_cf->pub.netio = rtpp_netio_async_init(cfsp, 1);
     if (proc_cf->pub.netio == NULL) {
-        goto e0;
+        goto e1;
     }
 
     proc_cf->cf_save = cfsp;
 
-    proc_cf->elp_fs.obj = prdic_init(cfsp->target_pfreq, 0.0);
-    if (proc_cf->elp_fs.obj == NULL) {
-        goto e1;
-    }
-    proc_cf->elp_fs.target_pfreq = cfsp->target_pfreq;
-    proc_cf->elp_lz.obj = prdic_init(10.0, 0.0);
-    if (proc_cf->elp_lz.obj == NULL) {
-        goto e2;
+    for (ninit = 0; ninit < proc_cf->nworkers; ninit++) {
+        wrk = &proc_cf->workers[ninit];
+        wrk->wid = ninit;
+        wrk->proc_cf = proc_cf;
+        if (rtpp_proc_worker_init(wrk, cfsp) != 0) {
+            goto e2;
+        }
     }
-    proc_cf->elp_lz.target_pfreq = 10.0;
 
-    if (pthread_create(&proc_cf->thread_id, NULL, (void *(*)(void *))&rtpp_proc_async_run, proc_cf) != 0) {
-        goto e3;
+    for (nstarted = 0; nstarted < proc_cf->nworkers; nstarted++) {
+        wrk = &proc_cf->workers[nstarted];
+        if (pthread_create(&wrk->thread_id, NULL,
+          (void *(*)(void *))&rtpp_proc_async_run, wrk) != 0) {
+            goto e3;
+        }
     }
     proc_cf->pub.dtor = &rtpp_proc_async_dtor;
     return (&proc_cf->pub);
 e3:
-    prdic_free(proc_cf->elp_lz.obj);
+    rtpp_proc_async_stop(proc_cf, nstarted);
 e2:
-    prdic_free(proc_cf->elp_fs.obj);
-e1:
+    for (i = 0; i < ninit; i++) {
+        rtpp_proc_worker_fini(&proc_cf->workers[i]);
+    }
     rtpp_netio_async_destroy(proc_cf->pub.netio);
+e1:
+    free(proc_cf->workers);
 e0:
     free(proc_cf);
     return (NULL);
@@ -304,15 +793,16 @@ static void
 rtpp_proc_async_dtor(struct rtpp_proc_async *pub)
 {
     struct rtpp_proc_async_cf *proc_cf;
-    int tstate;
+    int tstate, i;
 
     PUB2PVT(pub, proc_cf);
     tstate = atomic_load(&proc_cf->tstate);
     assert(tstate == TSTATE_RUN);
-    atomic_store(&proc_cf->tstate, TSTATE_CEASE);
-    pthread_join(proc_cf->thread_id, NULL);
-    prdic_free(proc_cf->elp_lz.obj);
-    prdic_free(proc_cf->elp_fs.obj);
+    rtpp_proc_async_stop(proc_cf, proc_cf->nworkers);
+    for (i = 0; i < proc_cf->nworkers; i++) {
+        rtpp_proc_worker_fini(&proc_cf->workers[i]);
+    }
     rtpp_netio_async_destroy(proc_cf->pub.netio);
+    free(proc_cf->workers);
     free(proc_cf);
 }
@@ -41,6 +41,7 @@
 #include "rtpp_proc.h"
 #include "rtpp_proc_servers.h"
 #include "rtpp_server.h"
+#include "rtpp_sessinfo.h"
 #include "rtpp_stream.h"
 
 struct foreach_args {
@@ -49,6 +50,9 @@ struct foreach_args {
     struct rtpp_proc_rstats *rsp;
     struct rtpp_weakref_obj *rtp_streams_wrt;
     struct rtpp_weakref_obj *rtcp_streams_wrt;
+    struct rtpp_sessinfo *sessinfo;
+    int shard;
+    int nplayers;
 };
 
 static int
@@ -70,6 +74,11 @@ process_rtp_servers_foreach(void *dp, void *ap)
     if (rsop == NULL) {
         return (RTPP_WR_MATCH_CONT);
     }
+    /* Played by the worker that forwards the rest of the session */
+    if (CALL_METHOD(fap->sessinfo, get_shard, rsop->seuid) != fap->shard) {
+        RTPP_OBJ_DECREF(rsop);
+        return (RTPP_WR_MATCH_CONT);
+    }
     for (;;) {
         pkt = CALL_SMETHOD(rsrv, get, fap->dtime, &len);
         if (pkt == NULL) {
@@ -91,12 +100,17 @@ process_rtp_servers_foreach(void *dp, void *ap)
         fap->rsp->npkts_played.cnt++;
     }
     RTPP_OBJ_DECREF(rsop);
+    fap->nplayers++;
     return (RTPP_WR_MATCH_CONT);
 }
 
-void
+/*
+ * Play into the streams of the given shard, returns number of players
+ * that are still active there.
+ */
+int
 rtpp_proc_servers(const struct rtpp_cfg *cfsp, double dtime, struct sthread_args *sender,
-  struct rtpp_proc_rstats *rsp)
+  struct rtpp_proc_rstats *rsp, int shard)
 {
     struct foreach_args fargs;
 
@@ -105,7 +119,11 @@ rtpp_proc_servers(const struct rtpp_cfg *cfsp, double dtime, struct sthread_args
     fargs.rsp = rsp;
     fargs.rtp_streams_wrt = cfsp->rtp_streams_wrt;
     fargs.rtcp_streams_wrt = cfsp->rtcp_streams_wrt;
+    fargs.sessinfo = cfsp->sessinfo;
+    fargs.shard = shard;
+    fargs.nplayers = 0;
 
     CALL_METHOD(cfsp->servers_wrt, foreach, process_rtp_servers_foreach,
       &fargs);
+    return (fargs.nplayers);
 }
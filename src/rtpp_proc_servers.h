@@ -1,2 +1,2 @@
-void rtpp_proc_servers(const struct rtpp_cfg *, double,
-  struct sthread_args *, struct rtpp_proc_rstats *);
+int rtpp_proc_servers(const struct rtpp_cfg *, double,
+  struct sthread_args *, struct rtpp_proc_rstats *, int);
@@ -49,8 +49,11 @@
 #include "rtpp_proc_ttl.h"
 #include "rtpp_mallocs.h"
 #include "rtpp_pipe.h"
+#include "rtpp_stream.h"
+#include "rtpp_time.h"
 #include "rtpp_timeout_data.h"
 #include "rtpp_locking.h"
+#include "advanced/po_manager.h"
 
 struct rtpp_proc_ttl_pvt {
     struct rtpp_proc_ttl pub;
@@ -65,16 +68,53 @@ struct rtpp_proc_ttl_pvt {
 #define TSTATE_CEASE 0x1
 
 static void rtpp_proc_ttl(struct rtpp_hash_table *, struct rtpp_weakref_obj *,
-  struct rtpp_notify *, struct rtpp_stats *);
+  struct rtpp_notify *, struct rtpp_stats *, struct rtpp_ebpf *, int);
 
 struct foreach_args {
     struct rtpp_notify *rtpp_notify_cf;
     struct rtpp_stats *rtpp_stats;
     struct rtpp_weakref_obj *sessions_wrt;
+    struct rtpp_ebpf *ebpf;
+    int ofld_ok;
+    double dtime;
 };  
 
 static const char *notyfy_type = "timeout";
 
+/*
+ * Install, update or remove in-kernel relay entries and fold their packet
+ * counters back into the streams. This has to be done before the TTL
+ * check, since the streams won't see any of those packets otherwise.
+ * Packet observers have to see every packet, so while there are any
+ * registered all entries are removed.
+ */
+static void
+rtpp_proc_ttl_offload(struct rtpp_pipe *pp, struct rtpp_ebpf *ebpf,
+  int ofld_ok)
+{
+
+    if (!ofld_ok) {
+        CALL_SMETHOD(pp->stream[0], offload_reset);
+        CALL_SMETHOD(pp->stream[1], offload_reset);
+        return;
+    }
+    CALL_SMETHOD(pp->stream[0], offload_sync, pp->stream[1], ebpf);
+    CALL_SMETHOD(pp->stream[1], offload_sync, pp->stream[0], ebpf);
+}
+
+/*
+ * Resize socket receive buffers to follow the packet rate, this also
+ * picks up the kernel drop counts. Sockets of the incomplete sessions are
+ * kept at the minimum size until activated, only the drops are read.
+ */
+static void
+rtpp_proc_ttl_rbuf(struct rtpp_pipe *pp, double dtime, int resize)
+{
+
+    CALL_SMETHOD(pp->stream[0], tune_rbuf, dtime, resize);
+    CALL_SMETHOD(pp->stream[1], tune_rbuf, dtime, resize);
+}
+
 static int
 rtpp_proc_ttl_foreach(void *dp, void *ap)
 {
@@ -88,6 +128,12 @@ rtpp_proc_ttl_foreach(void *dp, void *ap)
      */
     sp = (struct rtpp_session *)dp;
 
+    if (fap->ebpf != NULL && sp->complete != 0) {
+        rtpp_proc_ttl_offload(sp->rtp, fap->ebpf, fap->ofld_ok);
+        rtpp_proc_ttl_offload(sp->rtcp, fap->ebpf, fap->ofld_ok);
+    }
+    rtpp_proc_ttl_rbuf(sp->rtp, fap->dtime, sp->complete != 0);
+    rtpp_proc_ttl_rbuf(sp->rtcp, fap->dtime, sp->complete != 0);
     if (CALL_METHOD(sp->rtp, get_ttl) == 0) {
         RTPP_LOG(sp->log, RTPP_LOG_INFO, "session timeout");
         if (sp->timeout_data != NULL) {
@@ -107,13 +153,16 @@ rtpp_proc_ttl_foreach(void *dp, void *ap)
 static void
 rtpp_proc_ttl(struct rtpp_hash_table *sessions_ht, struct rtpp_weakref_obj
   *sessions_wrt, struct rtpp_notify *rtpp_notify_cf, struct rtpp_stats
-  *rtpp_stats)
+  *rtpp_stats, struct rtpp_ebpf *ebpf, int ofld_ok)
 {
     struct foreach_args fargs;
 
     fargs.rtpp_notify_cf = rtpp_notify_cf;
     fargs.rtpp_stats = rtpp_stats;
     fargs.sessions_wrt = sessions_wrt;
+    fargs.ebpf = ebpf;
+    fargs.ofld_ok = ofld_ok;
+    fargs.dtime = getdtime();
     CALL_METHOD(sessions_ht, foreach, rtpp_proc_ttl_foreach, &fargs);
 }
 
@@ -136,7 +185,8 @@ rtpp_proc_ttl_run(void *arg)
         }
         prdic_procrastinate(proc_cf->elp);
         rtpp_proc_ttl(cfsp->sessions_ht, cfsp->sessions_wrt,
-          cfsp->rtpp_notify_cf, stats_cf);
+          cfsp->rtpp_notify_cf, stats_cf, cfsp->rtpp_ebpf_cf,
+          cfsp->observers->nobservers == 0);
     }
 }
 
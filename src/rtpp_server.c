@@ -152,10 +152,12 @@ rtpp_server_get(struct rtpp_server *self, double dtime, int *rval)
     int rlen, rticks, bytes_per_frame, ticks_per_frame, number_of_frames;
     int hlen;
     struct rtpp_server_priv *rp;
+    double txtime;
 
     PUB2PVT(self, rp);
 
-    if (rp->started == 0 || (rp->btime + ((double)rp->dts / 1000.0) > dtime)) {
+    txtime = rp->btime + ((double)rp->dts / 1000.0);
+    if (rp->started == 0 || txtime > dtime) {
         *rval = RTPS_LATER;
 	return (NULL);
     }
@@ -232,6 +234,7 @@ rtpp_server_get(struct rtpp_server *self, double dtime, int *rval)
     rp->rtp->seq = htons(ntohs(rp->rtp->seq) + 1);
 
     pkt->size = hlen + rlen;
+    pkt->txtime = txtime;
     return (pkt);
 }
 
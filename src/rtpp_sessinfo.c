@@ -26,6 +26,7 @@
  *
  */
 
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <assert.h>
 #include <stddef.h>
@@ -34,6 +35,16 @@
 #include <string.h>
 #include <poll.h>
 #include <pthread.h>
+#include <unistd.h>
+
+#include "config.h"
+
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+#if HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
 
 #include "rtpp_types.h"
 #include "rtpp_refcnt.h"
@@ -44,14 +55,25 @@
 #include "rtpp_stream.h"
 #include "rtpp_session.h"
 #include "rtpp_socket.h"
+#include "rtpp_demux.h"
+#include "rtpp_uring.h"
 #include "rtpp_mallocs.h"
+#include "rtpp_defines.h"
+#include "rtpp_debug.h"
+#include "rtpp_util.h"
 
 enum polltbl_hst_ops {HST_ADD, HST_DEL, HST_UPD};
 
+/* Single socket for both RTP and RTCP, see rtpp_create_listener() */
+#define RTPP_SINFO_ISMUX(fds) ((fds)[0] == (fds)[1])
+
 struct rtpp_polltbl_hst_ent {
    uint64_t stuid;
    enum polltbl_hst_ops op;
    struct rtpp_socket *skt;
+   /* HST_ADD only: stream and the one it relays to, NULL if none */
+   struct rtpp_stream *stp;
+   struct rtpp_stream *sendr;
 };
 
 struct rtpp_polltbl_hst {
@@ -59,14 +81,25 @@ struct rtpp_polltbl_hst {
    int ulen;	/* Number of entries used */
    int ilen;	/* Minimum number of entries to be allocated when need to extend */
    struct rtpp_polltbl_hst_ent *clog;
-   struct rtpp_weakref_obj *streams_wrt;
 };
 
 struct rtpp_sessinfo_priv {
    struct rtpp_sessinfo pub;
    pthread_mutex_t lock;
-   struct rtpp_polltbl_hst hst_rtp;
-   struct rtpp_polltbl_hst hst_rtcp;
+   int nshards;
+   /* Per-shard histories, indexed by the forwarding worker number */
+   struct rtpp_polltbl_hst *hst_rtp;
+   struct rtpp_polltbl_hst *hst_rtcp;
+   /*
+    * Per-shard eventfd(2)s to kick the tickless workers out of the sleep
+    * when their histories change, NULL in the periodic mode.
+    */
+   int *wakefds;
+   /*
+    * Shared sockets of the single-port demultiplexing mode, NULL if each
+    * stream has socket of its own.
+    */
+   struct rtpp_demux *demux;
 };
 
 static int rtpp_sinfo_append(struct rtpp_sessinfo *, struct rtpp_session *,
@@ -75,8 +108,12 @@ static void rtpp_sinfo_update(struct rtpp_sessinfo *, struct rtpp_session *,
   int, struct rtpp_socket **);
 static void rtpp_sinfo_remove(struct rtpp_sessinfo *, struct rtpp_session *,
   int);
+static int rtpp_sinfo_activate(struct rtpp_sessinfo *, struct rtpp_session *);
 static int rtpp_sinfo_sync_polltbl(struct rtpp_sessinfo *, struct rtpp_polltbl *,
   int);
+static int rtpp_sinfo_get_wakefd(struct rtpp_sessinfo *, int);
+static void rtpp_sinfo_wakeup(struct rtpp_sessinfo *, int);
+static int rtpp_sinfo_get_shard(struct rtpp_sessinfo *, uint64_t);
 static void rtpp_sessinfo_dtor(struct rtpp_sessinfo_priv *);
 
 static int
@@ -91,17 +128,25 @@ rtpp_polltbl_hst_alloc(struct rtpp_polltbl_hst *hp, int alen)
     return (0);
 }
 
+static void
+rtpp_polltbl_hst_ent_free(struct rtpp_polltbl_hst_ent *hpe)
+{
+
+    if (hpe->skt != NULL)
+        RTPP_OBJ_DECREF(hpe->skt);
+    if (hpe->stp != NULL)
+        RTPP_OBJ_DECREF(hpe->stp);
+    if (hpe->sendr != NULL)
+        RTPP_OBJ_DECREF(hpe->sendr);
+}
+
 static void
 rtpp_polltbl_hst_dtor(struct rtpp_polltbl_hst *hp)
 {
     int i;
-    struct rtpp_polltbl_hst_ent *hep;
 
     for (i = 0; i < hp->ulen; i++) {
-        hep = hp->clog + i;
-        if (hep->skt != NULL) {
-            RTPP_OBJ_DECREF(hep->skt);
-        }
+        rtpp_polltbl_hst_ent_free(hp->clog + i);
     }
     if (hp->alen > 0) {
         free(hp->clog);
@@ -133,17 +178,77 @@ rtpp_polltbl_hst_record(struct rtpp_polltbl_hst *hp, enum polltbl_hst_ops op,
     hpe->op = op;
     hpe->stuid = stuid;
     hpe->skt = skt;
+    hpe->stp = hpe->sendr = NULL;
     hp->ulen += 1;
     if (skt != NULL) {
         RTPP_OBJ_INCREF(skt);
     }
 }
 
+/*
+ * Same as above for the HST_ADD, in addition the stream and its peer get
+ * pinned in the poll table, so that workers don't have to look them up
+ * by UID.
+ */
+static void
+rtpp_polltbl_hst_record_add(struct rtpp_polltbl_hst *hp,
+  struct rtpp_stream *stp, struct rtpp_stream *sendr, struct rtpp_socket *skt)
+{
+    struct rtpp_polltbl_hst_ent *hpe;
+
+    rtpp_polltbl_hst_record(hp, HST_ADD, stp->stuid, skt);
+    hpe = hp->clog + hp->ulen - 1;
+    hpe->stp = stp;
+    RTPP_OBJ_INCREF(stp);
+    hpe->sendr = sendr;
+    RTPP_OBJ_INCREF(sendr);
+}
+
+/*
+ * Map session into one of the shards. UIDs are allocated from a global
+ * counter shared with other objects, so the increment between two
+ * consecutive sessions is not necessarily co-prime with the number of
+ * shards, hence the multiplicative hashing.
+ */
+static int
+rtpp_sinfo_shard_of(struct rtpp_sessinfo_priv *pvt, uint64_t seuid)
+{
+
+    if (pvt->nshards == 1)
+        return (0);
+    return (((seuid * 0x9E3779B97F4A7C15ULL) >> 32) % pvt->nshards);
+}
+
+static int
+rtpp_sinfo_shard(struct rtpp_sessinfo_priv *pvt, const struct rtpp_session *sp)
+{
+
+    return (rtpp_sinfo_shard_of(pvt, sp->seuid));
+}
+
+static int
+rtpp_sinfo_hst_reserve(struct rtpp_sessinfo_priv *pvt, int shard)
+{
+
+    if (pvt->hst_rtp[shard].ulen == pvt->hst_rtp[shard].alen) {
+        if (rtpp_polltbl_hst_extend(&pvt->hst_rtp[shard]) < 0) {
+            return (-1);
+        }
+    }
+    if (pvt->hst_rtcp[shard].ulen == pvt->hst_rtcp[shard].alen) {
+        if (rtpp_polltbl_hst_extend(&pvt->hst_rtcp[shard]) < 0) {
+            return (-1);
+        }
+    }
+    return (0);
+}
+
 struct rtpp_sessinfo *
 rtpp_sessinfo_ctor(const struct rtpp_cfg *cfsp)
 {
     struct rtpp_sessinfo *sessinfo;
     struct rtpp_sessinfo_priv *pvt;
+    int i;
 
     pvt = rtpp_rzmalloc(sizeof(struct rtpp_sessinfo_priv), PVT_RCOFFS(pvt));
     if (pvt == NULL) {
@@ -153,26 +258,87 @@ rtpp_sessinfo_ctor(const struct rtpp_cfg *cfsp)
     if (pthread_mutex_init(&pvt->lock, NULL) != 0) {
         goto e5;
     }
-    if (rtpp_polltbl_hst_alloc(&pvt->hst_rtp, 10) != 0) {
+    pvt->nshards = (cfsp->nworkers > 0) ? cfsp->nworkers : 1;
+    pvt->hst_rtp = rtpp_zmalloc(sizeof(pvt->hst_rtp[0]) * pvt->nshards);
+    if (pvt->hst_rtp == NULL) {
         goto e6;
     }
-    if (rtpp_polltbl_hst_alloc(&pvt->hst_rtcp, 10) != 0) {
+    pvt->hst_rtcp = rtpp_zmalloc(sizeof(pvt->hst_rtcp[0]) * pvt->nshards);
+    if (pvt->hst_rtcp == NULL) {
         goto e7;
     }
-    pvt->hst_rtp.streams_wrt = cfsp->rtp_streams_wrt;
-    pvt->hst_rtcp.streams_wrt = cfsp->rtcp_streams_wrt;
+    for (i = 0; i < pvt->nshards; i++) {
+        if (rtpp_polltbl_hst_alloc(&pvt->hst_rtp[i], 10) != 0) {
+            goto e8;
+        }
+        if (rtpp_polltbl_hst_alloc(&pvt->hst_rtcp[i], 10) != 0) {
+            goto e8;
+        }
+    }
+    pvt->demux = cfsp->rtpp_demux_cf;
+    if (pvt->demux != NULL) {
+        struct rtpp_socket *rskt;
+        int j;
+
+        /*
+         * Shared sockets are the only ones that workers have to poll, they
+         * go in with no stream UID attached.
+         */
+        for (i = 0; i < pvt->nshards; i++) {
+            for (j = 0; (rskt = rtpp_demux_get_rskt(pvt->demux, i, j)) != NULL;
+              j++) {
+                if (pvt->hst_rtp[i].ulen == pvt->hst_rtp[i].alen &&
+                  rtpp_polltbl_hst_extend(&pvt->hst_rtp[i]) < 0) {
+                    goto e8;
+                }
+                rtpp_polltbl_hst_record(&pvt->hst_rtp[i], HST_ADD,
+                  RTPP_UID_NONE, rskt);
+            }
+        }
+    }
+#if HAVE_SYS_EVENTFD_H
+    if (cfsp->tickless) {
+        pvt->wakefds = rtpp_zmalloc(sizeof(pvt->wakefds[0]) * pvt->nshards);
+        if (pvt->wakefds == NULL) {
+            goto e8;
+        }
+        for (i = 0; i < pvt->nshards; i++) {
+            pvt->wakefds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (pvt->wakefds[i] < 0) {
+                goto e9;
+            }
+        }
+    }
+#endif
 
     sessinfo->append = &rtpp_sinfo_append;
     sessinfo->update = &rtpp_sinfo_update;
     sessinfo->remove = &rtpp_sinfo_remove;
+    sessinfo->activate = &rtpp_sinfo_activate;
     sessinfo->sync_polltbl = &rtpp_sinfo_sync_polltbl;
+    sessinfo->get_wakefd = &rtpp_sinfo_get_wakefd;
+    sessinfo->wakeup = &rtpp_sinfo_wakeup;
+    sessinfo->get_shard = &rtpp_sinfo_get_shard;
 
     CALL_SMETHOD(pvt->pub.rcnt, attach, (rtpp_refcnt_dtor_t)&rtpp_sessinfo_dtor,
       pvt);
     return (sessinfo);
 
+#if HAVE_SYS_EVENTFD_H
+e9:
+    while (i-- > 0) {
+        close(pvt->wakefds[i]);
+    }
+    free(pvt->wakefds);
+#endif
+e8:
+    for (i = 0; i < pvt->nshards; i++) {
+        rtpp_polltbl_hst_dtor(&pvt->hst_rtp[i]);
+        rtpp_polltbl_hst_dtor(&pvt->hst_rtcp[i]);
+    }
+    free(pvt->hst_rtcp);
 e7:
-    free(pvt->hst_rtp.clog);
+    free(pvt->hst_rtp);
 e6:
     pthread_mutex_destroy(&pvt->lock);
 e5:
@@ -184,39 +350,155 @@ e5:
 static void
 rtpp_sessinfo_dtor(struct rtpp_sessinfo_priv *pvt)
 {
+    int i;
 
     rtpp_sessinfo_fin(&(pvt->pub));
-    rtpp_polltbl_hst_dtor(&pvt->hst_rtp);
-    rtpp_polltbl_hst_dtor(&pvt->hst_rtcp);
+    for (i = 0; i < pvt->nshards; i++) {
+        rtpp_polltbl_hst_dtor(&pvt->hst_rtp[i]);
+        rtpp_polltbl_hst_dtor(&pvt->hst_rtcp[i]);
+    }
+    free(pvt->hst_rtp);
+    free(pvt->hst_rtcp);
+    if (pvt->wakefds != NULL) {
+        for (i = 0; i < pvt->nshards; i++) {
+            close(pvt->wakefds[i]);
+        }
+        free(pvt->wakefds);
+    }
     pthread_mutex_destroy(&pvt->lock);
     free(pvt);
 }
 
+static void
+rtpp_sinfo_signal(struct rtpp_sessinfo_priv *pvt, int shard)
+{
+    uint64_t one;
+
+    if (pvt->wakefds == NULL)
+        return;
+    one = 1;
+    /* EAGAIN means the counter is saturated, so the worker is awake anyway */
+    (void)write(pvt->wakefds[shard], &one, sizeof(one));
+}
+
+static int
+rtpp_sinfo_get_wakefd(struct rtpp_sessinfo *sessinfo, int shard)
+{
+    struct rtpp_sessinfo_priv *pvt;
+
+    PUB2PVT(sessinfo, pvt);
+    if (pvt->wakefds == NULL)
+        return (-1);
+    RTPP_DBG_ASSERT(shard >= 0 && shard < pvt->nshards);
+    return (pvt->wakefds[shard]);
+}
+
+static void
+rtpp_sinfo_wakeup(struct rtpp_sessinfo *sessinfo, int shard)
+{
+    struct rtpp_sessinfo_priv *pvt;
+
+    PUB2PVT(sessinfo, pvt);
+    rtpp_sinfo_signal(pvt, shard);
+}
+
+/* Worker that streams of the session with the given UID are served by */
+static int
+rtpp_sinfo_get_shard(struct rtpp_sessinfo *sessinfo, uint64_t seuid)
+{
+    struct rtpp_sessinfo_priv *pvt;
+
+    PUB2PVT(sessinfo, pvt);
+    return (rtpp_sinfo_shard_of(pvt, seuid));
+}
+
+/*
+ * Start receiving on the sockets of a stream pair: put them into the poll
+ * tables or, in the demultiplexing mode, have the ports they hold routed
+ * to the streams via the shared ones.
+ */
+static void
+rtpp_sinfo_poll_add(struct rtpp_sessinfo_priv *pvt, int shard,
+  struct rtpp_session *sp, int index, struct rtpp_socket **fds)
+{
+    struct rtpp_stream *rtp, *rtcp;
+
+    rtp = sp->rtp->stream[index];
+    rtcp = sp->rtcp->stream[index];
+    if (pvt->demux != NULL) {
+        rtpp_demux_reg(pvt->demux, fds[0], shard, rtp->stuid);
+        if (!rtcp->rtcp_mux)
+            rtpp_demux_reg(pvt->demux, fds[1], shard, rtcp->stuid);
+        return;
+    }
+    rtpp_polltbl_hst_record_add(&pvt->hst_rtp[shard], rtp,
+      sp->rtp->stream[NOT(index)], fds[0]);
+    if (!rtcp->rtcp_mux) {
+        rtpp_polltbl_hst_record_add(&pvt->hst_rtcp[shard], rtcp,
+          sp->rtcp->stream[NOT(index)], fds[1]);
+    }
+}
+
+static void
+rtpp_sinfo_poll_del(struct rtpp_sessinfo_priv *pvt, int shard,
+  struct rtpp_stream *rtp, struct rtpp_stream *rtcp,
+  struct rtpp_socket **fds)
+{
+
+    if (pvt->demux != NULL) {
+        rtpp_demux_reg(pvt->demux, fds[0], shard, RTPP_UID_NONE);
+        if (!rtcp->rtcp_mux)
+            rtpp_demux_reg(pvt->demux, fds[1], shard, RTPP_UID_NONE);
+        return;
+    }
+    rtpp_polltbl_hst_record(&pvt->hst_rtp[shard], HST_DEL, rtp->stuid, NULL);
+    if (!rtcp->rtcp_mux) {
+        rtpp_polltbl_hst_record(&pvt->hst_rtcp[shard], HST_DEL, rtcp->stuid,
+          NULL);
+    }
+}
+
+/*
+ * Sockets of the session that is not complete yet are not polled, shrink
+ * their receive buffers so that whatever is sent to them in the meantime
+ * gets dropped (and counted) by the kernel. The size requested is rounded
+ * up to the minimum supported.
+ */
+static void
+rtpp_sinfo_set_pending(struct rtpp_socket **fds)
+{
+
+    CALL_METHOD(fds[0], setrbuf, 1);
+    if (fds[1] != fds[0])
+        CALL_METHOD(fds[1], setrbuf, 1);
+}
+
 static int
 rtpp_sinfo_append(struct rtpp_sessinfo *sessinfo, struct rtpp_session *sp,
   int index, struct rtpp_socket **new_fds)
 {
     struct rtpp_sessinfo_priv *pvt;
     struct rtpp_stream *rtp, *rtcp;
+    int shard;
 
     PUB2PVT(sessinfo, pvt);
+    shard = rtpp_sinfo_shard(pvt, sp);
     pthread_mutex_lock(&pvt->lock);
-    if (pvt->hst_rtp.ulen == pvt->hst_rtp.alen) {
-        if (rtpp_polltbl_hst_extend(&pvt->hst_rtp) < 0) {
-            goto e0;
-        }
-    }
-    if (pvt->hst_rtcp.ulen == pvt->hst_rtcp.alen) {
-        if (rtpp_polltbl_hst_extend(&pvt->hst_rtcp) < 0) {
-            goto e0;
-        }
+    if (rtpp_sinfo_hst_reserve(pvt, shard) != 0) {
+        goto e0;
     }
     rtp = sp->rtp->stream[index];
-    CALL_SMETHOD(rtp, set_skt, new_fds[0]);
-    rtpp_polltbl_hst_record(&pvt->hst_rtp, HST_ADD, rtp->stuid, new_fds[0]);
     rtcp = sp->rtcp->stream[index];
+    rtp->rtcp_mux = rtcp->rtcp_mux = RTPP_SINFO_ISMUX(new_fds);
+    CALL_SMETHOD(rtp, set_skt, new_fds[0]);
     CALL_SMETHOD(rtcp, set_skt, new_fds[1]);
-    rtpp_polltbl_hst_record(&pvt->hst_rtcp, HST_ADD, rtcp->stuid, new_fds[1]);
+    if (sp->complete == 0) {
+        /* Deferred until rtpp_sinfo_activate() */
+        rtpp_sinfo_set_pending(new_fds);
+    } else {
+        rtpp_sinfo_poll_add(pvt, shard, sp, index, new_fds);
+        rtpp_sinfo_signal(pvt, shard);
+    }
 
     pthread_mutex_unlock(&pvt->lock);
     return (0);
@@ -244,37 +526,65 @@ rtpp_sinfo_update(struct rtpp_sessinfo *sessinfo, struct rtpp_session *sp,
 {
     struct rtpp_sessinfo_priv *pvt;
     struct rtpp_stream *rtp, *rtcp;
+    int shard, was_polled;
     struct rtpp_socket *old_fd;
 
     PUB2PVT(sessinfo, pvt);
 
+    shard = rtpp_sinfo_shard(pvt, sp);
     pthread_mutex_lock(&pvt->lock);
-    if (pvt->hst_rtp.ulen == pvt->hst_rtp.alen) {
-        if (rtpp_polltbl_hst_extend(&pvt->hst_rtp) < 0) {
-            goto e0;
-        }
+    if (rtpp_sinfo_hst_reserve(pvt, shard) != 0) {
+        goto e0;
     }
-    if (pvt->hst_rtcp.ulen == pvt->hst_rtcp.alen) {
-        if (rtpp_polltbl_hst_extend(&pvt->hst_rtcp) < 0) {
-            goto e0;
+    rtp = sp->rtp->stream[index];
+    rtcp = sp->rtcp->stream[index];
+    /* RTCP socket is in the poll table unless shared with the RTP one */
+    was_polled = !rtcp->rtcp_mux;
+    rtp->rtcp_mux = rtcp->rtcp_mux = RTPP_SINFO_ISMUX(new_fds);
+    if (sp->complete == 0 || pvt->demux != NULL) {
+        /*
+         * Nothing to replace in the poll tables, ports held by the old
+         * sockets are released along with them.
+         */
+        old_fd = CALL_SMETHOD(rtp, update_skt, new_fds[0]);
+        if (old_fd != NULL)
+            RTPP_OBJ_DECREF(old_fd);
+        old_fd = CALL_SMETHOD(rtcp, update_skt, new_fds[1]);
+        if (old_fd != NULL)
+            RTPP_OBJ_DECREF(old_fd);
+        if (sp->complete == 0) {
+            rtpp_sinfo_set_pending(new_fds);
+        } else {
+            rtpp_sinfo_poll_add(pvt, shard, sp, index, new_fds);
         }
+        goto e0;
     }
-    rtp = sp->rtp->stream[index];
     old_fd = CALL_SMETHOD(rtp, update_skt, new_fds[0]);
     if (old_fd != NULL) {
-        rtpp_polltbl_hst_record(&pvt->hst_rtp, HST_UPD, rtp->stuid, new_fds[0]);
+        rtpp_polltbl_hst_record(&pvt->hst_rtp[shard], HST_UPD, rtp->stuid, new_fds[0]);
         RTPP_OBJ_DECREF(old_fd);
     } else {
-        rtpp_polltbl_hst_record(&pvt->hst_rtp, HST_ADD, rtp->stuid, new_fds[0]);
+        rtpp_polltbl_hst_record_add(&pvt->hst_rtp[shard], rtp,
+          sp->rtp->stream[NOT(index)], new_fds[0]);
     }
-    rtcp = sp->rtcp->stream[index];
     old_fd = CALL_SMETHOD(rtcp, update_skt, new_fds[1]);
+    if (old_fd == NULL)
+        was_polled = 0;
+    if (rtcp->rtcp_mux) {
+        if (was_polled) {
+            rtpp_polltbl_hst_record(&pvt->hst_rtcp[shard], HST_DEL,
+              rtcp->stuid, NULL);
+        }
+    } else if (was_polled) {
+        rtpp_polltbl_hst_record(&pvt->hst_rtcp[shard], HST_UPD, rtcp->stuid, new_fds[1]);
+    } else {
+        rtpp_polltbl_hst_record_add(&pvt->hst_rtcp[shard], rtcp,
+          sp->rtcp->stream[NOT(index)], new_fds[1]);
+    }
     if (old_fd != NULL) {
-        rtpp_polltbl_hst_record(&pvt->hst_rtcp, HST_UPD, rtcp->stuid, new_fds[1]);
         RTPP_OBJ_DECREF(old_fd);
-    } else {
-        rtpp_polltbl_hst_record(&pvt->hst_rtcp, HST_ADD, rtcp->stuid, new_fds[1]);
     }
+    rtpp_sinfo_signal(pvt, shard);
 
 e0:
     pthread_mutex_unlock(&pvt->lock);
@@ -286,49 +596,322 @@ rtpp_sinfo_remove(struct rtpp_sessinfo *sessinfo, struct rtpp_session *sp,
 {
     struct rtpp_sessinfo_priv *pvt;
     struct rtpp_stream *rtp, *rtcp;
-    struct rtpp_socket *fd;
+    int i, shard;
+    struct rtpp_socket *fds[2];
 
     PUB2PVT(sessinfo, pvt);
 
+    shard = rtpp_sinfo_shard(pvt, sp);
     pthread_mutex_lock(&pvt->lock);
-    if (pvt->hst_rtp.ulen == pvt->hst_rtp.alen) {
-        if (rtpp_polltbl_hst_extend(&pvt->hst_rtp) < 0) {
-            goto e0;
-        }
-    }
-    if (pvt->hst_rtcp.ulen == pvt->hst_rtcp.alen) {
-        if (rtpp_polltbl_hst_extend(&pvt->hst_rtcp) < 0) {
-            goto e0;
-        }
+    if (rtpp_sinfo_hst_reserve(pvt, shard) != 0) {
+        goto e0;
     }
     rtp = sp->rtp->stream[index];
-    fd = CALL_SMETHOD(rtp, get_skt);
-    if (fd != NULL) {
-        rtpp_polltbl_hst_record(&pvt->hst_rtp, HST_DEL, rtp->stuid, NULL);
-        RTPP_OBJ_DECREF(fd);
-    }
     rtcp = sp->rtcp->stream[index];
-    fd = CALL_SMETHOD(rtcp, get_skt);
-    if (fd != NULL) {
-        rtpp_polltbl_hst_record(&pvt->hst_rtcp, HST_DEL, rtcp->stuid, NULL);
-        RTPP_OBJ_DECREF(fd);
+    fds[0] = CALL_SMETHOD(rtp, get_skt);
+    fds[1] = CALL_SMETHOD(rtcp, get_skt);
+    /* Sockets of incomplete sessions have never been polled */
+    if (fds[0] != NULL && sp->complete != 0) {
+        rtpp_sinfo_poll_del(pvt, shard, rtp, rtcp, fds);
+        rtpp_sinfo_signal(pvt, shard);
+    }
+    for (i = 0; i < 2; i++) {
+        if (fds[i] != NULL)
+            RTPP_OBJ_DECREF(fds[i]);
     }
 
 e0:
     pthread_mutex_unlock(&pvt->lock);
 }
 
+/*
+ * Session has been completed, start receiving on the sockets of both of
+ * its legs. Packets that have been queued on them while it was pending
+ * are stale, so they are discarded first, the number of those is
+ * returned.
+ */
+static int
+rtpp_sinfo_activate(struct rtpp_sessinfo *sessinfo, struct rtpp_session *sp)
+{
+    struct rtpp_sessinfo_priv *pvt;
+    struct rtpp_stream *rtp, *rtcp;
+    struct rtpp_socket *fds[2];
+    const char *proto;
+    int i, shard, ndrained;
+
+    PUB2PVT(sessinfo, pvt);
+
+    RTPP_DBG_ASSERT(sp->complete != 0);
+    shard = rtpp_sinfo_shard(pvt, sp);
+    ndrained = 0;
+    pthread_mutex_lock(&pvt->lock);
+    for (i = 0; i < 2; i++) {
+        rtp = sp->rtp->stream[i];
+        rtcp = sp->rtcp->stream[i];
+        fds[0] = CALL_SMETHOD(rtp, get_skt);
+        if (fds[0] == NULL)
+            continue;
+        fds[1] = CALL_SMETHOD(rtcp, get_skt);
+        RTPP_DBG_ASSERT(fds[1] != NULL);
+        if (rtpp_sinfo_hst_reserve(pvt, shard) == 0) {
+            proto = CALL_SMETHOD(rtp, get_proto);
+            ndrained += CALL_METHOD(fds[0], drain, proto, rtp->log);
+            CALL_METHOD(fds[0], setrbuf, MEDIA_RBUF_SIZE);
+            if (!rtcp->rtcp_mux) {
+                proto = CALL_SMETHOD(rtcp, get_proto);
+                ndrained += CALL_METHOD(fds[1], drain, proto, rtcp->log);
+                CALL_METHOD(fds[1], setrbuf, MEDIA_RBUF_RTCP);
+            }
+            rtpp_sinfo_poll_add(pvt, shard, sp, i, fds);
+        }
+        RTPP_OBJ_DECREF(fds[1]);
+        RTPP_OBJ_DECREF(fds[0]);
+    }
+    rtpp_sinfo_signal(pvt, shard);
+    pthread_mutex_unlock(&pvt->lock);
+    return (ndrained);
+}
+
+/*
+ * Table is always left in a usable state, non-zero return value indicates
+ * that epoll(7) has been requested but could not be set up and plain
+ * poll(2) is going to be used instead.
+ */
+int
+rtpp_polltbl_init(struct rtpp_polltbl *ptbl, int poll_engine, int shard,
+  struct rtpp_uring_rx *urx)
+{
+
+    memset(ptbl, '\0', sizeof(struct rtpp_polltbl));
+    ptbl->epfd = -1;
+    ptbl->shard = shard;
+    ptbl->urx = urx;
+#if HAVE_SYS_EPOLL_H
+    if (poll_engine == RTPP_POLL_EPOLL) {
+        ptbl->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (ptbl->epfd < 0) {
+            return (-1);
+        }
+    }
+#endif
+    return (0);
+}
+
+#if HAVE_SYS_EPOLL_H
+/*
+ * epoll(7) has failed us in the middle of the history replay (i.e. ENOMEM
+ * or ENOSPC due to max_user_watches), pfds[] are always kept in sync, so
+ * we can just revert to the plain poll(2) for this table.
+ */
+static void
+rtpp_polltbl_epoll_abort(struct rtpp_polltbl *ptbl)
+{
+
+    close(ptbl->epfd);
+    ptbl->epfd = -1;
+    ptbl->nready = 0;
+}
+
+static void
+rtpp_polltbl_epoll_ctl(struct rtpp_polltbl *ptbl, int op, int idx)
+{
+    struct epoll_event ev;
+
+    if (ptbl->epfd < 0)
+        return;
+    memset(&ev, '\0', sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = idx;
+    if (epoll_ctl(ptbl->epfd, op, ptbl->pfds[idx].fd, &ev) != 0) {
+        rtpp_polltbl_epoll_abort(ptbl);
+    }
+}
+#endif
+
+/*
+ * Start watching socket in the slot. With the receive ring set, sockets of
+ * the streams are handed over to it and left out of the poll set, shared
+ * sockets (which are served in a round robin fashion against a limit
+ * of their own) and sockets that refuse the ring keep being polled.
+ */
+static void
+rtpp_polltbl_watch(struct rtpp_polltbl *ptbl, int idx)
+{
+    struct rtpp_polltbl_mdata *mdp;
+
+    mdp = &ptbl->mds[idx];
+    mdp->rxq = NULL;
+    ptbl->pfds[idx].fd = CALL_METHOD(mdp->skt, getfd);
+    ptbl->pfds[idx].events = POLLIN;
+    ptbl->pfds[idx].revents = 0;
+    if (ptbl->urx != NULL && mdp->stuid != RTPP_UID_NONE) {
+        mdp->rxq = rtpp_uring_rx_add(ptbl->urx, ptbl->pfds[idx].fd,
+          mdp->skt->rcnt, ptbl, idx);
+        if (mdp->rxq != NULL && CALL_METHOD(mdp->skt, seturing, mdp->rxq) != 0) {
+            rtpp_uring_rx_del(mdp->rxq);
+            mdp->rxq = NULL;
+        }
+        if (mdp->rxq != NULL) {
+            ptbl->pfds[idx].events = 0;
+            ptbl->nurx++;
+            return;
+        }
+    }
+#if HAVE_SYS_EPOLL_H
+    rtpp_polltbl_epoll_ctl(ptbl, EPOLL_CTL_ADD, idx);
+#endif
+}
+
+static void
+rtpp_polltbl_unwatch(struct rtpp_polltbl *ptbl, int idx)
+{
+    struct rtpp_polltbl_mdata *mdp;
+
+    mdp = &ptbl->mds[idx];
+    if (mdp->rxq != NULL) {
+        CALL_METHOD(mdp->skt, seturing, NULL);
+        rtpp_uring_rx_del(mdp->rxq);
+        mdp->rxq = NULL;
+        ptbl->nurx--;
+        return;
+    }
+#if HAVE_SYS_EPOLL_H
+    if (ptbl->epfd >= 0) {
+        epoll_ctl(ptbl->epfd, EPOLL_CTL_DEL, ptbl->pfds[idx].fd, NULL);
+    }
+#endif
+}
+
+/* Let whoever is watching the slot know that it has been moved to idx */
+static void
+rtpp_polltbl_moved(struct rtpp_polltbl *ptbl, int idx)
+{
+
+    if (ptbl->mds[idx].rxq != NULL) {
+        rtpp_uring_rxq_setidx(ptbl->mds[idx].rxq, idx);
+        return;
+    }
+#if HAVE_SYS_EPOLL_H
+    rtpp_polltbl_epoll_ctl(ptbl, EPOLL_CTL_MOD, idx);
+#endif
+}
+
+#if HAVE_SYS_EPOLL_H
+/*
+ * Wait with the receive ring set: completions that have been posted since
+ * the last call are processed and sockets that have got packets queued are
+ * appended to whatever epoll(7) or poll(2) has to report on the rest. The
+ * system call is skipped if there is nothing left to poll.
+ */
+static int
+rtpp_polltbl_wait_uring(struct rtpp_polltbl *ptbl, int timeout)
+{
+    int i, n, nrdy;
+
+    n = 0;
+    if (ptbl->epfd >= 0) {
+        if (ptbl->nurx < ptbl->curlen) {
+            n = epoll_wait(ptbl->epfd, ptbl->events, ptbl->evlen,
+              timeout);
+            if (n < 0)
+                n = 0;
+        }
+    } else {
+        n = poll(ptbl->pfds, ptbl->curlen, timeout);
+        if (n < 0)
+            n = 0;
+    }
+    if (rtpp_uring_rx_reap(ptbl->urx) < 0)
+        return (-1);
+    /* Whatever does not fit is left on the ready list until the next call */
+    nrdy = rtpp_uring_rx_ready(ptbl->urx, ptbl, ptbl->urdy,
+      ptbl->evlen - ((ptbl->epfd >= 0) ? n : 0));
+    for (i = 0; i < nrdy; i++) {
+        if (ptbl->epfd >= 0) {
+            ptbl->events[n + i].events = EPOLLIN;
+            ptbl->events[n + i].data.u32 = ptbl->urdy[i];
+        } else {
+            ptbl->pfds[ptbl->urdy[i]].revents |= POLLIN;
+        }
+    }
+    n += nrdy;
+    if (ptbl->epfd >= 0)
+        ptbl->nready = n;
+    return (n);
+}
+#endif
+
+int
+rtpp_polltbl_wait(struct rtpp_polltbl *ptbl, int timeout)
+{
+#if HAVE_SYS_EPOLL_H
+    struct epoll_event *events;
+    int *urdy;
+#endif
+
+    /*
+     * Nothing to wait for, i.e. no sessions in the shard or all of them
+     * doing rtcp-mux, and epoll_wait(2) fails with EINVAL on maxevents 0.
+     * The receive ring still has to be reaped to see the cancellations of
+     * the sockets that have just been removed through.
+     */
+    if (ptbl->curlen == 0 && ptbl->urx == NULL) {
+        ptbl->nready = 0;
+        return (0);
+    }
+#if HAVE_SYS_EPOLL_H
+    if (ptbl->urx != NULL || ptbl->epfd >= 0) {
+        if (ptbl->evlen < ptbl->curlen) {
+            events = realloc(ptbl->events, ptbl->curlen * sizeof(ptbl->events[0]));
+            if (events != NULL) {
+                ptbl->events = events;
+                if (ptbl->urx == NULL) {
+                    ptbl->evlen = ptbl->curlen;
+                } else if ((urdy = realloc(ptbl->urdy,
+                  ptbl->curlen * sizeof(ptbl->urdy[0]))) != NULL) {
+                    ptbl->urdy = urdy;
+                    ptbl->evlen = ptbl->curlen;
+                }
+            }
+        }
+        if (ptbl->urx != NULL)
+            return (rtpp_polltbl_wait_uring(ptbl, timeout));
+        ptbl->nready = epoll_wait(ptbl->epfd, ptbl->events, ptbl->evlen,
+          timeout);
+        if (ptbl->nready < 0) {
+            ptbl->nready = 0;
+            return (-1);
+        }
+        return (ptbl->nready);
+    }
+#endif
+    return (poll(ptbl->pfds, ptbl->curlen, timeout));
+}
+
 void
 rtpp_polltbl_free(struct rtpp_polltbl *ptbl)
 {
     int i;
 
+    if (ptbl->epfd >= 0) {
+        close(ptbl->epfd);
+        ptbl->epfd = -1;
+    }
+    free(ptbl->events);
+    free(ptbl->urdy);
+    free(ptbl->backlog);
     if (ptbl->aloclen == 0) {
         return;
     }
     if (ptbl->curlen > 0) {
         for (i = 0; i < ptbl->curlen; i++) {
+            if (ptbl->mds[i].rxq != NULL)
+                rtpp_polltbl_unwatch(ptbl, i);
             RTPP_OBJ_DECREF(ptbl->mds[i].skt);
+            if (ptbl->mds[i].stp != NULL) {
+                RTPP_OBJ_DECREF(ptbl->mds[i].stp);
+                RTPP_OBJ_DECREF(ptbl->mds[i].sendr);
+            }
         }
     }
     free(ptbl->pfds);
@@ -348,7 +931,9 @@ rtpp_sinfo_sync_polltbl(struct rtpp_sessinfo *sessinfo,
     PUB2PVT(sessinfo, pvt);
 
     pthread_mutex_lock(&pvt->lock);
-    hp = (pipe_type == PIPE_RTP) ? &pvt->hst_rtp : &pvt->hst_rtcp;
+    RTPP_DBG_ASSERT(ptbl->shard >= 0 && ptbl->shard < pvt->nshards);
+    hp = (pipe_type == PIPE_RTP) ? &pvt->hst_rtp[ptbl->shard] :
+      &pvt->hst_rtcp[ptbl->shard];
 
     if (hp->ulen == 0) {
         pthread_mutex_unlock(&pvt->lock);
@@ -390,14 +975,17 @@ rtpp_sinfo_sync_polltbl(struct rtpp_sessinfo *sessinfo,
         switch (hep->op) {
         case HST_ADD:
 #ifdef RTPP_DEBUG
-            assert(find_polltbl_idx(ptbl, hep->stuid) < 0);
+            assert(hep->stuid == RTPP_UID_NONE ||
+              find_polltbl_idx(ptbl, hep->stuid) < 0);
 #endif
             session_index = ptbl->curlen;
-            ptbl->pfds[session_index].fd = CALL_METHOD(hep->skt, getfd);
-            ptbl->pfds[session_index].events = POLLIN;
-            ptbl->pfds[session_index].revents = 0;
             ptbl->mds[session_index].stuid = hep->stuid;
             ptbl->mds[session_index].skt = hep->skt;
+            ptbl->mds[session_index].stp = hep->stp;
+            ptbl->mds[session_index].sendr = hep->sendr;
+            ptbl->mds[session_index].deficit = 0;
+            ptbl->mds[session_index].lastrun = 0;
+            rtpp_polltbl_watch(ptbl, session_index);
             ptbl->curlen++;
             ptbl->revision++;
             break;
@@ -405,13 +993,35 @@ rtpp_sinfo_sync_polltbl(struct rtpp_sessinfo *sessinfo,
         case HST_DEL:
             session_index = find_polltbl_idx(ptbl, hep->stuid);
             assert(session_index > -1);
+            rtpp_polltbl_unwatch(ptbl, session_index);
             RTPP_OBJ_DECREF(ptbl->mds[session_index].skt);
+            if (ptbl->mds[session_index].stp != NULL) {
+                RTPP_OBJ_DECREF(ptbl->mds[session_index].stp);
+                RTPP_OBJ_DECREF(ptbl->mds[session_index].sendr);
+            }
             movelen = (ptbl->curlen - session_index - 1);
+#if HAVE_SYS_EPOLL_H
+            if (ptbl->epfd >= 0 && movelen > 0) {
+                /*
+                 * Order of entries does not matter with epoll(7), move
+                 * the last one into the vacated slot and let the kernel
+                 * know its new index.
+                 */
+                ptbl->pfds[session_index] = ptbl->pfds[ptbl->curlen - 1];
+                ptbl->mds[session_index] = ptbl->mds[ptbl->curlen - 1];
+                rtpp_polltbl_moved(ptbl, session_index);
+                movelen = 0;
+            }
+#endif
             if (movelen > 0) {
                 memmove(&ptbl->pfds[session_index], &ptbl->pfds[session_index + 1],
                   movelen * sizeof(ptbl->pfds[0]));
                 memmove(&ptbl->mds[session_index], &ptbl->mds[session_index + 1],
                   movelen * sizeof(ptbl->mds[0]));
+                for (; movelen > 0; movelen--, session_index++) {
+                    if (ptbl->mds[session_index].rxq != NULL)
+                        rtpp_polltbl_moved(ptbl, session_index);
+                }
             }
             ptbl->curlen--;
             ptbl->revision++;
@@ -420,28 +1030,21 @@ rtpp_sinfo_sync_polltbl(struct rtpp_sessinfo *sessinfo,
         case HST_UPD:
             session_index = find_polltbl_idx(ptbl, hep->stuid);
             assert(session_index > -1);
+            rtpp_polltbl_unwatch(ptbl, session_index);
             RTPP_OBJ_DECREF(ptbl->mds[session_index].skt);
-            ptbl->pfds[session_index].fd = CALL_METHOD(hep->skt, getfd);
-            ptbl->pfds[session_index].events = POLLIN;
-            ptbl->pfds[session_index].revents = 0;
             ptbl->mds[session_index].skt = hep->skt;
+            rtpp_polltbl_watch(ptbl, session_index);
             ptbl->revision++;
             break;
         }
     }
     hp->ulen = 0;
 
-    ptbl->streams_wrt = hp->streams_wrt;
     pthread_mutex_unlock(&pvt->lock);
     return (1);
 e0:
     for (i = 0; i < hp->ulen; i++) {
-        struct rtpp_polltbl_hst_ent *hep;
-
-        hep = hp->clog + i;
-        if (hep->skt != NULL) {
-            RTPP_OBJ_DECREF(hep->skt);
-        }
+        rtpp_polltbl_hst_ent_free(hp->clog + i);
     }
     hp->ulen = 0;
     pthread_mutex_unlock(&pvt->lock);
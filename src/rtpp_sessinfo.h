@@ -27,12 +27,15 @@
  */
 
 struct pollfd;
+struct epoll_event;
 struct rtpp_session;
 struct rtpp_sessinfo;
 struct rtpp_socket;
+struct rtpp_stream;
 struct rtpp_polltbl;
-struct rtpp_weakref_obj;
 struct rtpp_cfg;
+struct rtpp_uring_rx;
+struct rtpp_uring_rxq;
 
 DEFINE_METHOD(rtpp_sessinfo, rtpp_si_append, int, struct rtpp_session *,
   int, struct rtpp_socket **);
@@ -40,14 +43,30 @@ DEFINE_METHOD(rtpp_sessinfo, rtpp_si_update, void, struct rtpp_session *,
   int, struct rtpp_socket **);
 DEFINE_METHOD(rtpp_sessinfo, rtpp_si_remove, void, struct rtpp_session *,
   int);
+DEFINE_METHOD(rtpp_sessinfo, rtpp_si_activate, int, struct rtpp_session *);
 DEFINE_METHOD(rtpp_sessinfo, rtpp_si_sync_polltbl, int, struct rtpp_polltbl *,
   int);
+DEFINE_METHOD(rtpp_sessinfo, rtpp_si_get_wakefd, int, int);
+DEFINE_METHOD(rtpp_sessinfo, rtpp_si_wakeup, void, int);
+DEFINE_METHOD(rtpp_sessinfo, rtpp_si_get_shard, int, uint64_t);
 
 struct rtpp_polltbl_mdata;
 
 struct rtpp_polltbl_mdata {
     uint64_t stuid;
     struct rtpp_socket *skt;
+    /*
+     * Stream receiving on the socket and the one it relays to, pinned for
+     * as long as the socket is in the table. NULL for the shared sockets.
+     */
+    struct rtpp_stream *stp;
+    struct rtpp_stream *sendr;
+    /* Unused (or overdrawn, if negative) receive budget */
+    int deficit;
+    /* Last round the socket has been served in */
+    uint64_t lastrun;
+    /* Receive queue if the socket is served by the io_uring(7) */
+    struct rtpp_uring_rxq *rxq;
 };
 
 struct rtpp_polltbl {
@@ -56,7 +75,23 @@ struct rtpp_polltbl {
     int curlen;
     int aloclen;
     uint64_t revision;
-    struct rtpp_weakref_obj *streams_wrt;
+    /* Shard (i.e. forwarding worker #) whose streams are in the table */
+    int shard;
+    /* epoll(7) descriptor, or -1 if plain poll(2) is used */
+    int epfd;
+    struct epoll_event *events;
+    int evlen;
+    int nready;
+    /* Per-worker receive ring, NULL unless --recv_engine io_uring */
+    struct rtpp_uring_rx *urx;
+    int nurx;
+    int *urdy;
+    /* Deficit round robin state, see process_rtp_only() */
+    uint64_t nrounds;
+    int *backlog;
+    int blen;
+    int balen;
+    uint64_t brevision;
 };
 
 struct rtpp_sessinfo {
@@ -64,9 +99,16 @@ struct rtpp_sessinfo {
     METHOD_ENTRY(rtpp_si_append, append);
     METHOD_ENTRY(rtpp_si_update, update);
     METHOD_ENTRY(rtpp_si_remove, remove);
+    METHOD_ENTRY(rtpp_si_activate, activate);
     METHOD_ENTRY(rtpp_si_sync_polltbl, sync_polltbl);
+    METHOD_ENTRY(rtpp_si_get_wakefd, get_wakefd);
+    METHOD_ENTRY(rtpp_si_wakeup, wakeup);
+    METHOD_ENTRY(rtpp_si_get_shard, get_shard);
 };
 
 struct rtpp_sessinfo *rtpp_sessinfo_ctor(const struct rtpp_cfg *);
 
+int rtpp_polltbl_init(struct rtpp_polltbl *, int, int,
+  struct rtpp_uring_rx *);
+int rtpp_polltbl_wait(struct rtpp_polltbl *, int);
 void rtpp_polltbl_free(struct rtpp_polltbl *);
@@ -136,8 +136,9 @@ rtpp_session_ctor(const struct rtpp_cfg *cfs, struct common_cmd_args *ccap,
         pub->strong = 1;
     }
 
+    pub->rtcp_mux = (fds[0] == fds[1]);
     pub->rtp->stream[0]->port = lport;
-    pub->rtcp->stream[0]->port = lport + 1;
+    pub->rtcp->stream[0]->port = pub->rtcp_mux ? lport : lport + 1;
     for (i = 0; i < 2; i++) {
         if (i == 0 || cfs->ttl_mode == TTL_INDEPENDENT) {
             pub->rtp->stream[i]->ttl = rtpp_ttl_ctor(cfs->max_setup_ttl);
@@ -155,6 +156,9 @@ rtpp_session_ctor(const struct rtpp_cfg *cfs, struct common_cmd_args *ccap,
     for (i = 0; i < 2; i++) {
         pub->rtp->stream[i]->stuid_rtcp = pub->rtcp->stream[i]->stuid;
         pub->rtcp->stream[i]->stuid_rtp = pub->rtp->stream[i]->stuid;
+        /* Until the "p" modifier says otherwise */
+        CALL_SMETHOD(pub->rtp->stream[i], set_police, cfs->police_pps,
+          cfs->police_kbps);
     }
 
     pvt->pub.rtpp_stats = cfs->rtpp_stats;
@@ -203,6 +207,14 @@ rtpp_session_dtor(struct rtpp_session_priv *pvt)
     struct rtpp_session *pub;
 
     pub = &(pvt->pub);
+    /*
+     * Streams may outlive the session for a while, make sure the kernel
+     * stops relaying right away and its counters get accounted for.
+     */
+    for (i = 0; i < 2; i++) {
+        CALL_SMETHOD(pub->rtp->stream[i], offload_reset);
+        CALL_SMETHOD(pub->rtcp->stream[i], offload_reset);
+    }
     rtpp_timestamp_get(pvt->acct->destroy_ts);
     session_time = pvt->acct->destroy_ts->mono - pvt->acct->init_ts->mono;
 
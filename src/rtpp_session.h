@@ -47,6 +47,8 @@ struct rtpp_session {
     int complete;
     /* Flags: strong create/delete; weak ones */
     int strong;
+    /* RTCP is multiplexed with RTP on the same port (RFC 5761) */
+    int rtcp_mux;
     struct rtpp_timeout_data *timeout_data;
     /* UID */
     uint64_t seuid;
@@ -28,15 +28,28 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/ioctl.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "config_pp.h"
 
+#if HAVE_LINUX_FILTER_H
+#include <linux/filter.h>
+#include <linux/sock_diag.h>
+#endif
+#if HAVE_LINUX_NET_TSTAMP_H
+#include <linux/net_tstamp.h>
+#endif
+
 #include "rtpp_log.h"
 #include "rtpp_types.h"
 #include "rtpp_log_obj.h"
@@ -48,28 +61,96 @@
 #include "rtpp_time.h"
 #include "rtpp_network.h"
 #include "rtpp_network_io.h"
+#include "rtpp_netaddr.h"
+#include "rtpp_uring.h"
 #include "rtp.h"
 #include "rtp_packet.h"
 #include "rtpp_debug.h"
 
+#if HAVE_RECVMMSG && defined(UDP_GRO)
+#define RTPP_SKT_GRO 1
+/* Largest buffer that the kernel can hand us with UDP_GRO on */
+#define RTPP_SKT_GRO_BUFLEN 65536
+
+/*
+ * Datagram received with UDP_GRO on, possibly containing several
+ * coalesced segments that have to be split back into packets.
+ */
+struct rtpp_socket_grobuf {
+    unsigned char *buf;
+    size_t size;
+    size_t off;
+    size_t segsize;
+    struct sockaddr_storage raddr;
+    socklen_t rlen;
+    struct sockaddr_storage laddr;
+    socklen_t llen;
+    struct rtpp_timestamp rtime;
+};
+#endif
+
 struct rtpp_socket_priv {
     struct rtpp_socket pub;
     int fd;
+    int rx_mtype;
+    struct rtpp_anetio_sstate sstate;
+    /* Non-zero if the socket can be connect()ed to the remote peer */
+    int connmode;
+    /* Address the socket is connected to, peerlen is 0 if none */
+    struct sockaddr_storage peer;
+    socklen_t peerlen;
+    /* Non-zero if the source filter can be attached to the socket */
+    int filtmode;
+    /* Address the filter is set to accept, fpeerlen is 0 if none */
+    struct sockaddr_storage fpeer;
+    socklen_t fpeerlen;
+    int fhostonly;
+    /* Value of the kernel's drop counter when last checked */
+    uint32_t kdrops_last;
+    /* Drops not reported by kdrops() yet, see rtpp_socket_kdrops_fold() */
+    uint64_t kdrops_ovflw;
+    uint64_t kdrops_filt;
+#if RTPP_SKT_GRO
+    /* Segments left over from the last coalesced datagram, if any */
+    struct rtpp_socket_grobuf *gro_rsd;
+#endif
+    /* io_uring(7) receive queue, packets are taken from there if set */
+    struct rtpp_uring_rxq *urxq;
+    rtpp_socket_rtp_recv_t rtp_recv_sync;
+    rtpp_socket_rtp_recvm_t rtp_recvm_sync;
 };
 
+/* rx_mtype value for sockets that have no receive timestamps enabled */
+#define RTPP_SKT_NOTS (-1)
+
 static void rtpp_socket_dtor(struct rtpp_socket_priv *);
 static int rtpp_socket_bind(struct rtpp_socket *, const struct sockaddr *,
   int);
 static int rtpp_socket_settos(struct rtpp_socket *, int);
 static int rtpp_socket_setrbuf(struct rtpp_socket *, int);
+static int rtpp_socket_getrbuf(struct rtpp_socket *);
 static int rtpp_socket_setnonblock(struct rtpp_socket *);
 static int rtpp_socket_settimestamp(struct rtpp_socket *);
+static int rtpp_socket_setgro(struct rtpp_socket *);
+static int rtpp_socket_setbusypoll(struct rtpp_socket *, int);
+static int rtpp_socket_settxtime(struct rtpp_socket *);
+static int rtpp_socket_setconnect(struct rtpp_socket *);
+static int rtpp_socket_setsrcfilter(struct rtpp_socket *);
+static int rtpp_socket_setpeer(struct rtpp_socket *, struct rtpp_netaddr *,
+  int);
+static uint64_t rtpp_socket_kdrops(struct rtpp_socket *, uint64_t *);
+static int rtpp_socket_seturing(struct rtpp_socket *, struct rtpp_uring_rxq *);
 static int rtpp_socket_send_pkt_na(struct rtpp_socket *, struct sthread_args *,
   struct rtpp_netaddr *, struct rtp_packet *, struct rtpp_log *);
 static struct rtp_packet * rtpp_socket_rtp_recv_simple(struct rtpp_socket *,
   const struct rtpp_timestamp *, const struct sockaddr *, int);
 static struct rtp_packet *rtpp_socket_rtp_recv(struct rtpp_socket *,
   const struct rtpp_timestamp *, const struct sockaddr *, int);
+static int rtpp_socket_rtp_recvm(struct rtpp_socket *,
+  const struct rtpp_timestamp *, const struct sockaddr *, int,
+  struct rtp_packet **, int);
+static int rtpp_socket_rx_pending(struct rtpp_socket *);
+static int rtpp_socket_rx_backlog(struct rtpp_socket *);
 static int rtpp_socket_getfd(struct rtpp_socket *);
 static int rtpp_socket_drain(struct rtpp_socket *, const char *,
   struct rtpp_log *);
@@ -78,6 +159,20 @@ static int rtpp_socket_drain(struct rtpp_socket *, const char *,
 static struct rtp_packet *rtpp_socket_rtp_recv_mono(struct rtpp_socket *,
   const struct rtpp_timestamp *, const struct sockaddr *, int);
 #endif
+#if HAVE_RECVMMSG
+static struct rtp_packet *rtpp_socket_rtp_recv_uring(struct rtpp_socket *,
+  const struct rtpp_timestamp *, const struct sockaddr *, int);
+static int rtpp_socket_rtp_recvm_uring(struct rtpp_socket *,
+  const struct rtpp_timestamp *, const struct sockaddr *, int,
+  struct rtp_packet **, int);
+#endif
+#if RTPP_SKT_GRO
+static struct rtp_packet *rtpp_socket_rtp_recv_gro(struct rtpp_socket *,
+  const struct rtpp_timestamp *, const struct sockaddr *, int);
+static int rtpp_socket_rtp_recvm_gro(struct rtpp_socket *,
+  const struct rtpp_timestamp *, const struct sockaddr *, int,
+  struct rtp_packet **, int);
+#endif
 
 struct rtpp_socket *
 rtpp_socket_ctor(int domain, int type)
@@ -101,13 +196,26 @@ rtpp_socket_ctor(int domain, int type)
     pvt->pub.bind2 = &rtpp_socket_bind;
     pvt->pub.settos = &rtpp_socket_settos;
     pvt->pub.setrbuf = &rtpp_socket_setrbuf;
+    pvt->pub.getrbuf = &rtpp_socket_getrbuf;
     pvt->pub.setnonblock = &rtpp_socket_setnonblock;
     pvt->pub.settimestamp = &rtpp_socket_settimestamp;
+    pvt->pub.setgro = &rtpp_socket_setgro;
+    pvt->pub.setbusypoll = &rtpp_socket_setbusypoll;
+    pvt->pub.settxtime = &rtpp_socket_settxtime;
+    pvt->pub.setconnect = &rtpp_socket_setconnect;
+    pvt->pub.setsrcfilter = &rtpp_socket_setsrcfilter;
+    pvt->pub.setpeer = &rtpp_socket_setpeer;
+    pvt->pub.kdrops = &rtpp_socket_kdrops;
+    pvt->pub.seturing = &rtpp_socket_seturing;
 #if 0
     pvt->pub.send_pkt = &rtpp_socket_send_pkt;
 #endif
     pvt->pub.send_pkt_na = &rtpp_socket_send_pkt_na;
     pvt->pub.rtp_recv = &rtpp_socket_rtp_recv_simple;
+    pvt->pub.rtp_recvm = &rtpp_socket_rtp_recvm;
+    pvt->rx_mtype = RTPP_SKT_NOTS;
+    pvt->pub.rx_pending = &rtpp_socket_rx_pending;
+    pvt->pub.rx_backlog = &rtpp_socket_rx_backlog;
     pvt->pub.getfd = &rtpp_socket_getfd;
     pvt->pub.drain = &rtpp_socket_drain;
     CALL_SMETHOD(pvt->pub.rcnt, attach, (rtpp_refcnt_dtor_t)&rtpp_socket_dtor,
@@ -125,6 +233,9 @@ rtpp_socket_dtor(struct rtpp_socket_priv *pvt)
 {
 
     rtpp_socket_fin(&pvt->pub);
+#if RTPP_SKT_GRO
+    free(pvt->gro_rsd);
+#endif
     shutdown(pvt->fd, SHUT_RDWR);
     close(pvt->fd);
     free(pvt);
@@ -159,6 +270,28 @@ rtpp_socket_setrbuf(struct rtpp_socket *self, int so_rcvbuf)
       sizeof(so_rcvbuf)));
 }
 
+/*
+ * Receive buffer size that is in effect, in the same units setrbuf()
+ * takes. The kernel may have capped the value, and Linux doubles it
+ * to account for its bookkeeping overhead, which is undone here.
+ */
+static int
+rtpp_socket_getrbuf(struct rtpp_socket *self)
+{
+    struct rtpp_socket_priv *pvt;
+    int so_rcvbuf;
+    socklen_t slen;
+
+    PUB2PVT(self, pvt);
+    slen = sizeof(so_rcvbuf);
+    if (getsockopt(pvt->fd, SOL_SOCKET, SO_RCVBUF, &so_rcvbuf, &slen) != 0)
+        return (-1);
+#if defined(__linux__)
+    so_rcvbuf /= 2;
+#endif
+    return (so_rcvbuf);
+}
+
 static int
 rtpp_socket_setnonblock(struct rtpp_socket *self)
 {
@@ -197,11 +330,355 @@ rtpp_socket_settimestamp(struct rtpp_socket *self)
       sizeof(sval));
     if (rval == 0) {
         pvt->pub.rtp_recv = &rtpp_socket_rtp_recv_mono;
+        pvt->rx_mtype = SCM_MONOTONIC;
         return (0);
     }
 #endif
     pvt->pub.rtp_recv = &rtpp_socket_rtp_recv;
+    pvt->rx_mtype = SCM_TIMESTAMP;
+    return (0);
+}
+
+/*
+ * Let the kernel coalesce bursts of datagrams coming from the same peer
+ * (UDP_GRO), this has to be called after settimestamp() since it overrides
+ * receive methods set by the latter.
+ */
+static int
+rtpp_socket_setgro(struct rtpp_socket *self)
+{
+#if RTPP_SKT_GRO
+    struct rtpp_socket_priv *pvt;
+    int sval;
+
+    PUB2PVT(self, pvt);
+    sval = 1;
+    if (setsockopt(pvt->fd, SOL_UDP, UDP_GRO, &sval, sizeof(sval)) != 0)
+        return (-1);
+    pvt->pub.rtp_recv = &rtpp_socket_rtp_recv_gro;
+    pvt->pub.rtp_recvm = &rtpp_socket_rtp_recvm_gro;
     return (0);
+#else
+    errno = ENOTSUP;
+    return (-1);
+#endif
+}
+
+/*
+ * Have the kernel spin on the device queue for up to usecs microseconds
+ * when the socket is empty (SO_BUSY_POLL), instead of waiting for the
+ * interrupt. SO_PREFER_BUSY_POLL is only available on newer kernels, so
+ * it is set on the best effort basis.
+ */
+static int
+rtpp_socket_setbusypoll(struct rtpp_socket *self, int usecs)
+{
+#if defined(SO_BUSY_POLL)
+    struct rtpp_socket_priv *pvt;
+    int sval;
+
+    PUB2PVT(self, pvt);
+    if (setsockopt(pvt->fd, SOL_SOCKET, SO_BUSY_POLL, &usecs,
+      sizeof(usecs)) != 0)
+        return (-1);
+#if defined(SO_PREFER_BUSY_POLL)
+    sval = 1;
+    setsockopt(pvt->fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &sval, sizeof(sval));
+#endif
+    return (0);
+#else
+    errno = ENOTSUP;
+    return (-1);
+#endif
+}
+
+/*
+ * Allow packets that have their departure time set to be handed over to
+ * the kernel ahead of time, to be released by the fq(8) / etf(8) qdisc
+ * when due (SO_TXTIME).
+ */
+static int
+rtpp_socket_settxtime(struct rtpp_socket *self)
+{
+#if HAVE_LINUX_NET_TSTAMP_H && defined(SO_TXTIME)
+    struct rtpp_socket_priv *pvt;
+    struct sock_txtime stt;
+
+    PUB2PVT(self, pvt);
+    memset(&stt, '\0', sizeof(stt));
+    stt.clockid = CLOCK_MONOTONIC;
+    if (setsockopt(pvt->fd, SOL_SOCKET, SO_TXTIME, &stt, sizeof(stt)) != 0)
+        return (-1);
+    pvt->sstate.txtime = 1;
+    return (0);
+#else
+    errno = ENOTSUP;
+    return (-1);
+#endif
+}
+
+static int
+rtpp_socket_setconnect(struct rtpp_socket *self)
+{
+    struct rtpp_socket_priv *pvt;
+
+    PUB2PVT(self, pvt);
+    pvt->connmode = 1;
+    return (0);
+}
+
+static int
+rtpp_socket_setsrcfilter(struct rtpp_socket *self)
+{
+#if HAVE_LINUX_FILTER_H
+    struct rtpp_socket_priv *pvt;
+
+    PUB2PVT(self, pvt);
+    pvt->filtmode = 1;
+    return (0);
+#else
+    errno = ENOTSUP;
+    return (-1);
+#endif
+}
+
+/* Connect to the sa, or disconnect if sa is NULL */
+static int
+rtpp_socket_connect(struct rtpp_socket_priv *pvt, const struct sockaddr *sa,
+  socklen_t salen)
+{
+    struct sockaddr_storage usa;
+
+    if (sa == NULL) {
+        if (pvt->peerlen == 0)
+            return (0);
+        /* Senders have to stop relying on the old peer first */
+        rtpp_anetio_setpeer(&pvt->sstate, NULL, 0);
+        memset(&usa, '\0', sizeof(usa));
+        usa.ss_family = AF_UNSPEC;
+        if (connect(pvt->fd, sstosa(&usa), sizeof(usa)) != 0)
+            return (-1);
+        pvt->peerlen = 0;
+        return (0);
+    }
+    if (salen == pvt->peerlen && memcmp(sa, &pvt->peer, salen) == 0)
+        return (0);
+    rtpp_anetio_setpeer(&pvt->sstate, NULL, 0);
+    if (connect(pvt->fd, sa, salen) != 0) {
+        rtpp_socket_connect(pvt, NULL, 0);
+        return (-1);
+    }
+    memcpy(&pvt->peer, sa, salen);
+    pvt->peerlen = salen;
+    rtpp_anetio_setpeer(&pvt->sstate, sa, salen);
+    return (0);
+}
+
+#if HAVE_LINUX_FILTER_H
+#define RTPP_SKT_FLT_MAXLEN 16
+
+/*
+ * Compile classic BPF program that accepts datagrams coming from the sa
+ * (or from the same host as sa if hostonly is set) and drops the rest.
+ * The filter runs with the data pointing past the IP header, so the
+ * latter is accessed via SKF_NET_OFF. Returns number of instructions.
+ */
+static int
+rtpp_socket_mkfilter(const struct sockaddr *sa, int hostonly,
+  struct sock_filter *code)
+{
+    const struct sockaddr_in6 *sin6;
+    uint32_t aword;
+    int i, n;
+
+#define FLT_STMT(c, k) \
+    (code[n++] = (struct sock_filter)BPF_STMT((c), (k)))
+/* Fall through on match, jump offset to the "drop" is patched below */
+#define FLT_JNE(k) \
+    (code[n++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (k), 0, 0))
+
+    n = 0;
+    switch (sa->sa_family) {
+    case AF_INET:
+        FLT_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 12);
+        FLT_JNE(ntohl(satosin(sa)->sin_addr.s_addr));
+        if (!hostonly) {
+            FLT_STMT(BPF_LDX | BPF_B | BPF_MSH, SKF_NET_OFF);
+            FLT_STMT(BPF_LD | BPF_H | BPF_IND, SKF_NET_OFF);
+            FLT_JNE(ntohs(satosin(sa)->sin_port));
+        }
+        break;
+
+    case AF_INET6:
+        sin6 = (const struct sockaddr_in6 *)sa;
+        for (i = 0; i < 4; i++) {
+            memcpy(&aword, &sin6->sin6_addr.s6_addr[i * 4], sizeof(aword));
+            FLT_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 8 + i * 4);
+            FLT_JNE(ntohl(aword));
+        }
+        if (!hostonly) {
+            /*
+             * Extension headers are not expected on the media path, drop
+             * the packet rather than take some of those for the port.
+             */
+            FLT_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_NET_OFF + 6);
+            FLT_JNE(IPPROTO_UDP);
+            FLT_STMT(BPF_LD | BPF_H | BPF_ABS, SKF_NET_OFF + 40);
+            FLT_JNE(ntohs(sin6->sin6_port));
+        }
+        break;
+
+    default:
+        return (0);
+    }
+    FLT_STMT(BPF_RET | BPF_K, 0xffffffff);
+    FLT_STMT(BPF_RET | BPF_K, 0);
+    for (i = 0; i < n - 2; i++) {
+        if (code[i].code == (BPF_JMP | BPF_JEQ | BPF_K))
+            code[i].jf = n - 1 - (i + 1);
+    }
+#undef FLT_STMT
+#undef FLT_JNE
+    return (n);
+}
+
+/*
+ * Collect drops reported by the kernel since the last check. The kernel
+ * has a single counter for both the packets rejected by the filter and
+ * those lost to the receive buffer overflow, so whatever is dropped while
+ * there is no filter attached is an overflow, otherwise only the drops
+ * found with the queue (nearly) full are. Called before the filter is
+ * changed, so that the drops are weighted against the filter that has
+ * caused them.
+ */
+static void
+rtpp_socket_kdrops_fold(struct rtpp_socket_priv *pvt)
+{
+#if defined(SO_MEMINFO)
+    uint32_t meminfo[SK_MEMINFO_VARS];
+    socklen_t mlen;
+    uint64_t ndrops;
+
+    mlen = sizeof(meminfo);
+    if (getsockopt(pvt->fd, SOL_SOCKET, SO_MEMINFO, meminfo, &mlen) != 0 ||
+      mlen <= SK_MEMINFO_DROPS * sizeof(meminfo[0]))
+        return;
+    /* The counter is 32-bit and wraps around, the difference is not */
+    ndrops = (uint32_t)(meminfo[SK_MEMINFO_DROPS] - pvt->kdrops_last);
+    pvt->kdrops_last = meminfo[SK_MEMINFO_DROPS];
+    if (pvt->fpeerlen == 0 || meminfo[SK_MEMINFO_RMEM_ALLOC] >=
+      meminfo[SK_MEMINFO_RCVBUF] - meminfo[SK_MEMINFO_RCVBUF] / 8) {
+        pvt->kdrops_ovflw += ndrops;
+    } else {
+        pvt->kdrops_filt += ndrops;
+    }
+#endif
+}
+
+/* Attach filter accepting only the sa, or detach it if sa is NULL */
+static int
+rtpp_socket_filter(struct rtpp_socket_priv *pvt, const struct sockaddr *sa,
+  socklen_t salen, int hostonly)
+{
+    struct sock_filter code[RTPP_SKT_FLT_MAXLEN];
+    struct sock_fprog prog;
+    int dummy;
+
+    if (sa == NULL) {
+        if (pvt->fpeerlen == 0)
+            return (0);
+        rtpp_socket_kdrops_fold(pvt);
+        dummy = 0;
+        if (setsockopt(pvt->fd, SOL_SOCKET, SO_DETACH_FILTER, &dummy,
+          sizeof(dummy)) != 0)
+            return (-1);
+        pvt->fpeerlen = 0;
+        return (0);
+    }
+    if (salen == pvt->fpeerlen && hostonly == pvt->fhostonly &&
+      memcmp(sa, &pvt->fpeer, salen) == 0)
+        return (0);
+    rtpp_socket_kdrops_fold(pvt);
+    prog.len = rtpp_socket_mkfilter(sa, hostonly, code);
+    if (prog.len == 0) {
+        errno = EAFNOSUPPORT;
+        return (-1);
+    }
+    prog.filter = code;
+    if (setsockopt(pvt->fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog,
+      sizeof(prog)) != 0) {
+        rtpp_socket_filter(pvt, NULL, 0, 0);
+        return (-1);
+    }
+    memcpy(&pvt->fpeer, sa, salen);
+    pvt->fpeerlen = salen;
+    pvt->fhostonly = hostonly;
+    return (0);
+}
+#endif /* HAVE_LINUX_FILTER_H */
+
+/*
+ * Let the kernel know about the peer, so that it can use cached route
+ * when sending out (connect()) and drop anything coming from elsewhere
+ * (connect() or BPF filter), NULL peer reverts socket back to the
+ * unrestricted state. With hostonly set packets from any port on the
+ * peer's host are allowed, so that the socket is never connected in this
+ * case. Does nothing unless enabled with setconnect() / setsrcfilter().
+ */
+static int
+rtpp_socket_setpeer(struct rtpp_socket *self, struct rtpp_netaddr *peer,
+  int hostonly)
+{
+    struct rtpp_socket_priv *pvt;
+    struct sockaddr_storage sa;
+    struct sockaddr *sap;
+    socklen_t salen;
+    int rval;
+
+    PUB2PVT(self, pvt);
+    if (pvt->connmode == 0 && pvt->filtmode == 0)
+        return (0);
+    if (peer != NULL) {
+        salen = CALL_SMETHOD(peer, get, sstosa(&sa), sizeof(sa));
+        sap = sstosa(&sa);
+    } else {
+        salen = 0;
+        sap = NULL;
+    }
+    rval = 0;
+    if (pvt->connmode != 0) {
+        if (rtpp_socket_connect(pvt, hostonly ? NULL : sap, salen) != 0)
+            rval = -1;
+    }
+#if HAVE_LINUX_FILTER_H
+    if (pvt->filtmode != 0) {
+        if (rtpp_socket_filter(pvt, sap, salen, hostonly) != 0)
+            rval = -1;
+    }
+#endif
+    return (rval);
+}
+
+/*
+ * Number of datagrams dropped by the kernel on this socket since the
+ * last call, either by the filter or due to the receive buffer overflow.
+ * The novflw gets those that are known to be the latter, see
+ * rtpp_socket_kdrops_fold().
+ */
+static uint64_t
+rtpp_socket_kdrops(struct rtpp_socket *self, uint64_t *novflw)
+{
+    struct rtpp_socket_priv *pvt;
+    uint64_t rval;
+
+    PUB2PVT(self, pvt);
+#if HAVE_LINUX_FILTER_H
+    rtpp_socket_kdrops_fold(pvt);
+#endif
+    *novflw = pvt->kdrops_ovflw;
+    rval = pvt->kdrops_ovflw + pvt->kdrops_filt;
+    pvt->kdrops_ovflw = pvt->kdrops_filt = 0;
+    return (rval);
 }
 
 static int
@@ -212,8 +689,13 @@ rtpp_socket_send_pkt_na(struct rtpp_socket *self, struct sthread_args *str,
     struct rtpp_socket_priv *pvt;
 
     PUB2PVT(self, pvt);
+    /*
+     * Destination goes along even if the socket is connected, the sender
+     * leaves it out only if it is still connected to the same peer by
+     * the time the packet goes out.
+     */
     return (rtpp_anetio_send_pkt_na(str, pvt->fd, daddr, pkt,
-      self->rcnt, log));
+      self->rcnt, log, &pvt->sstate));
 }
 
 static struct rtp_packet *
@@ -339,6 +821,356 @@ out:
 }
 #endif
 
+#if HAVE_RECVMMSG
+static void
+rtpp_socket_rx_rtime(struct rtpp_socket_priv *pvt, const struct rtpp_rxmsg *rmp,
+  const struct rtpp_timestamp *dtime, struct rtpp_timestamp *rtime)
+{
+
+    rtime->wall = dtime->wall;
+    rtime->mono = dtime->mono;
+    switch (pvt->rx_mtype) {
+    case SCM_TIMESTAMP:
+        if (!timevaliszero(&rmp->time.tv))
+            rtime->wall = timeval2dtime(&rmp->time.tv);
+        break;
+
+#if HAVE_SO_TS_CLOCK
+    case SCM_MONOTONIC:
+        if (!timespeciszero(&rmp->time.ts))
+            rtime->mono = timespec2dtime(&rmp->time.ts);
+        break;
+#endif
+    }
+}
+
+static int
+rtpp_socket_rtp_recvm(struct rtpp_socket *self, const struct rtpp_timestamp *dtime,
+  const struct sockaddr *laddr, int port, struct rtp_packet **pkts, int npkts)
+{
+    struct rtpp_socket_priv *pvt;
+    struct rtpp_rxmsg rmsgs[RTPP_RXMSG_MAX];
+    struct rtp_packet *packet;
+    int i, nrcvd;
+
+    PUB2PVT(self, pvt);
+    if (npkts > RTPP_RXMSG_MAX)
+        npkts = RTPP_RXMSG_MAX;
+    memset(rmsgs, '\0', sizeof(rmsgs[0]) * npkts);
+    for (i = 0; i < npkts; i++) {
+        packet = pkts[i];
+        rmsgs[i].buf = packet->data.buf;
+        rmsgs[i].len = sizeof(packet->data.buf);
+        rmsgs[i].from = sstosa(&packet->raddr);
+        rmsgs[i].fromlen = sizeof(packet->raddr);
+        rmsgs[i].to = sstosa(&packet->_laddr);
+    }
+    nrcvd = recvmmsgfromto(pvt->fd, rmsgs, npkts, pvt->rx_mtype);
+    if (nrcvd <= 0)
+        return (0);
+    for (i = 0; i < nrcvd; i++) {
+        packet = pkts[i];
+        packet->size = rmsgs[i].size;
+        packet->rlen = rmsgs[i].fromlen;
+        if (rmsgs[i].tolen > 0) {
+            /* Zero port: socket is shared, keep whatever kernel reports */
+            if (port != 0)
+                setport(sstosa(&packet->_laddr), port);
+            packet->laddr = sstosa(&packet->_laddr);
+        } else {
+            packet->laddr = laddr;
+        }
+        packet->lport = port;
+        if (dtime == NULL)
+            continue;
+        rtpp_socket_rx_rtime(pvt, &rmsgs[i], dtime, &packet->rtime);
+    }
+    return (nrcvd);
+}
+#else
+static int
+rtpp_socket_rtp_recvm(struct rtpp_socket *self, const struct rtpp_timestamp *dtime,
+  const struct sockaddr *laddr, int port, struct rtp_packet **pkts, int npkts)
+{
+    struct rtp_packet *packet;
+    int nrcvd;
+
+    /* No recvmmsg(2), fall back to receiving packets one by one */
+    for (nrcvd = 0; nrcvd < npkts; nrcvd++) {
+        packet = CALL_METHOD(self, rtp_recv, dtime, laddr, port);
+        if (packet == NULL)
+            break;
+        RTPP_OBJ_DECREF(pkts[nrcvd]);
+        pkts[nrcvd] = packet;
+    }
+    return (nrcvd);
+}
+#endif
+
+#if RTPP_SKT_GRO
+/*
+ * Copy segments out of the (possibly coalesced) datagram into the packets,
+ * one segment per packet. Returns number of the packets filled.
+ */
+static int
+rtpp_socket_gro_split(struct rtpp_socket_grobuf *gbp, const struct sockaddr *laddr,
+  int port, struct rtp_packet **pkts, int npkts)
+{
+    struct rtp_packet *packet;
+    size_t len;
+    int n;
+
+    for (n = 0; n < npkts && gbp->off < gbp->size; n++) {
+        packet = pkts[n];
+        len = gbp->size - gbp->off;
+        if (len > gbp->segsize)
+            len = gbp->segsize;
+        packet->size = (len > sizeof(packet->data.buf)) ?
+          sizeof(packet->data.buf) : len;
+        memcpy(packet->data.buf, gbp->buf + gbp->off, packet->size);
+        gbp->off += len;
+        memcpy(&packet->raddr, &gbp->raddr, gbp->rlen);
+        packet->rlen = gbp->rlen;
+        if (gbp->llen > 0) {
+            memcpy(&packet->_laddr, &gbp->laddr, gbp->llen);
+            setport(sstosa(&packet->_laddr), port);
+            packet->laddr = sstosa(&packet->_laddr);
+        } else {
+            packet->laddr = laddr;
+        }
+        packet->lport = port;
+        packet->rtime = gbp->rtime;
+    }
+    return (n);
+}
+
+/*
+ * Version of the rtp_recvm() for sockets with UDP_GRO enabled. Datagrams
+ * are received one at a time into a large enough buffer and then split
+ * into packets. Segments that do not fit into the batch are kept with the
+ * socket and returned first on the next call.
+ */
+static int
+rtpp_socket_rtp_recvm_gro(struct rtpp_socket *self, const struct rtpp_timestamp *dtime,
+  const struct sockaddr *laddr, int port, struct rtp_packet **pkts, int npkts)
+{
+    struct rtpp_socket_priv *pvt;
+    struct rtpp_socket_grobuf gb, *gbp;
+    struct rtpp_rxmsg rmsg;
+    unsigned char buf[RTPP_SKT_GRO_BUFLEN];
+    int nrcvd;
+
+    PUB2PVT(self, pvt);
+    nrcvd = 0;
+    if (pvt->gro_rsd != NULL) {
+        nrcvd = rtpp_socket_gro_split(pvt->gro_rsd, laddr, port, pkts, npkts);
+        if (pvt->gro_rsd->off < pvt->gro_rsd->size)
+            return (nrcvd);
+        free(pvt->gro_rsd);
+        pvt->gro_rsd = NULL;
+    }
+    while (nrcvd < npkts) {
+        memset(&rmsg, '\0', sizeof(rmsg));
+        rmsg.buf = buf;
+        rmsg.len = sizeof(buf);
+        rmsg.from = sstosa(&gb.raddr);
+        rmsg.fromlen = sizeof(gb.raddr);
+        rmsg.to = sstosa(&gb.laddr);
+        if (recvmmsgfromto(pvt->fd, &rmsg, 1, pvt->rx_mtype) <= 0)
+            break;
+        gb.buf = buf;
+        gb.size = rmsg.size;
+        gb.off = 0;
+        gb.segsize = (rmsg.segsize > 0) ? rmsg.segsize : rmsg.size;
+        gb.rlen = rmsg.fromlen;
+        gb.llen = rmsg.tolen;
+        if (dtime != NULL) {
+            rtpp_socket_rx_rtime(pvt, &rmsg, dtime, &gb.rtime);
+        } else {
+            memset(&gb.rtime, '\0', sizeof(gb.rtime));
+        }
+        nrcvd += rtpp_socket_gro_split(&gb, laddr, port, pkts + nrcvd,
+          npkts - nrcvd);
+        if (gb.off == gb.size)
+            continue;
+        gbp = malloc(sizeof(*gbp) + gb.size - gb.off);
+        if (gbp == NULL)
+            break;
+        *gbp = gb;
+        gbp->buf = (unsigned char *)(gbp + 1);
+        memcpy(gbp->buf, buf + gb.off, gb.size - gb.off);
+        gbp->size = gb.size - gb.off;
+        gbp->off = 0;
+        pvt->gro_rsd = gbp;
+        break;
+    }
+    return (nrcvd);
+}
+
+static struct rtp_packet *
+rtpp_socket_rtp_recv_gro(struct rtpp_socket *self, const struct rtpp_timestamp *dtime,
+  const struct sockaddr *laddr, int port)
+{
+    struct rtp_packet *packet;
+
+    packet = rtp_packet_alloc();
+    if (packet == NULL) {
+        return NULL;
+    }
+    if (rtpp_socket_rtp_recvm_gro(self, dtime, laddr, port, &packet, 1) == 0) {
+        RTPP_OBJ_DECREF(packet);
+        return (NULL);
+    }
+    return (packet);
+}
+#endif /* RTPP_SKT_GRO */
+
+#if HAVE_RECVMMSG
+/*
+ * Version of the rtp_recvm() for sockets served by the io_uring(7), the
+ * packets have already been received by the time this is called, so they
+ * just have to be picked up from the queue.
+ */
+static int
+rtpp_socket_rtp_recvm_uring(struct rtpp_socket *self,
+  const struct rtpp_timestamp *dtime, const struct sockaddr *laddr, int port,
+  struct rtp_packet **pkts, int npkts)
+{
+    struct rtpp_socket_priv *pvt;
+    struct rtpp_rxmsg rmsg;
+    struct sockaddr_storage to;
+    struct rtp_packet *packet;
+    int i, nrcvd;
+
+    PUB2PVT(self, pvt);
+    nrcvd = rtpp_uring_rxq_pull(pvt->urxq, pkts, npkts);
+    for (i = 0; i < nrcvd; i++) {
+        packet = pkts[i];
+        memset(&rmsg, '\0', sizeof(rmsg));
+        rmsg.from = sstosa(&packet->raddr);
+        rmsg.to = sstosa(&to);
+        rtpp_uring_rx_unpack(packet, &rmsg, pvt->rx_mtype);
+        packet->size = rmsg.size;
+        packet->rlen = rmsg.fromlen;
+        if (rmsg.tolen > 0) {
+            memcpy(&packet->_laddr, &to, rmsg.tolen);
+            setport(sstosa(&packet->_laddr), port);
+            packet->laddr = sstosa(&packet->_laddr);
+        } else {
+            packet->laddr = laddr;
+        }
+        packet->lport = port;
+        if (dtime == NULL)
+            continue;
+        rtpp_socket_rx_rtime(pvt, &rmsg, dtime, &packet->rtime);
+    }
+    return (nrcvd);
+}
+
+static struct rtp_packet *
+rtpp_socket_rtp_recv_uring(struct rtpp_socket *self,
+  const struct rtpp_timestamp *dtime, const struct sockaddr *laddr, int port)
+{
+    struct rtp_packet *packet;
+
+    packet = rtp_packet_alloc();
+    if (packet == NULL) {
+        return NULL;
+    }
+    if (rtpp_socket_rtp_recvm_uring(self, dtime, laddr, port, &packet, 1) == 0) {
+        RTPP_OBJ_DECREF(packet);
+        return (NULL);
+    }
+    return (packet);
+}
+#endif
+
+/*
+ * Hand receiving over to the io_uring(7) queue, or take it back if rxq is
+ * NULL. Only to be called by the thread that receives on the socket.
+ * Sockets with UDP_GRO on are not supported.
+ */
+static int
+rtpp_socket_seturing(struct rtpp_socket *self, struct rtpp_uring_rxq *rxq)
+{
+#if HAVE_RECVMMSG
+    struct rtpp_socket_priv *pvt;
+
+    PUB2PVT(self, pvt);
+    if (rxq == NULL) {
+        if (pvt->urxq == NULL)
+            return (0);
+        pvt->pub.rtp_recv = pvt->rtp_recv_sync;
+        pvt->pub.rtp_recvm = pvt->rtp_recvm_sync;
+        pvt->urxq = NULL;
+        return (0);
+    }
+#if RTPP_SKT_GRO
+    if (pvt->pub.rtp_recvm == &rtpp_socket_rtp_recvm_gro) {
+        errno = EOPNOTSUPP;
+        return (-1);
+    }
+#endif
+    if (pvt->urxq == NULL) {
+        pvt->rtp_recv_sync = pvt->pub.rtp_recv;
+        pvt->rtp_recvm_sync = pvt->pub.rtp_recvm;
+    }
+    pvt->urxq = rxq;
+    pvt->pub.rtp_recv = &rtpp_socket_rtp_recv_uring;
+    pvt->pub.rtp_recvm = &rtpp_socket_rtp_recvm_uring;
+    return (0);
+#else
+    errno = EOPNOTSUPP;
+    return (-1);
+#endif
+}
+
+/*
+ * Number of packets already received from the kernel and held by the
+ * socket, poll(2) won't report those. Packets in the io_uring(7) queue
+ * are not counted, the ring keeps reporting the socket until they are
+ * all gone.
+ */
+static int
+rtpp_socket_rx_pending(struct rtpp_socket *self)
+{
+#if RTPP_SKT_GRO
+    struct rtpp_socket_priv *pvt;
+    struct rtpp_socket_grobuf *gbp;
+
+    PUB2PVT(self, pvt);
+    gbp = pvt->gro_rsd;
+    if (gbp != NULL)
+        return ((gbp->size - gbp->off + gbp->segsize - 1) / gbp->segsize);
+#endif
+    return (0);
+}
+
+/*
+ * Whether there is anything left to be received at all: held by the
+ * socket, waiting in the io_uring(7) queue or still in the kernel. Only
+ * tells empty (0) from not (> 0), the count is not exact.
+ */
+static int
+rtpp_socket_rx_backlog(struct rtpp_socket *self)
+{
+    struct rtpp_socket_priv *pvt;
+    int nqueued;
+
+    PUB2PVT(self, pvt);
+    nqueued = rtpp_socket_rx_pending(self);
+    if (nqueued > 0)
+        return (nqueued);
+    if (pvt->urxq != NULL) {
+        nqueued = rtpp_uring_rxq_len(pvt->urxq);
+        if (nqueued > 0)
+            return (nqueued);
+    }
+    if (ioctl(pvt->fd, FIONREAD, &nqueued) != 0)
+        return (1);
+    return (nqueued);
+}
+
 static int
 rtpp_socket_getfd(struct rtpp_socket *self)
 {
@@ -362,6 +1194,15 @@ rtpp_socket_drain(struct rtpp_socket *self, const char *ptype,
         RTPP_LOG(log, RTPP_LOG_DBUG, "Draining %s socket %d", ptype,
           pvt->fd);
     }
+#if RTPP_SKT_GRO
+    if (pvt->gro_rsd != NULL) {
+        free(pvt->gro_rsd);
+        pvt->gro_rsd = NULL;
+        ndrained++;
+    }
+#endif
+    if (pvt->urxq != NULL)
+        ndrained += rtpp_uring_rxq_drain(pvt->urxq);
     for (;;) {
         rval = recv(pvt->fd, scrapbuf, sizeof(scrapbuf), 0);
         if (rval < 0)
@@ -33,13 +33,25 @@ struct sthread_args;
 struct rtpp_log;
 struct rtpp_netaddr;
 struct rtpp_timestamp;
+struct rtpp_uring_rxq;
 
 DEFINE_METHOD(rtpp_socket, rtpp_socket_bind, int, const struct sockaddr *,
   int);
 DEFINE_METHOD(rtpp_socket, rtpp_socket_settos, int, int);
 DEFINE_METHOD(rtpp_socket, rtpp_socket_setrbuf, int, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_getrbuf, int);
 DEFINE_METHOD(rtpp_socket, rtpp_socket_setnonblock, int);
 DEFINE_METHOD(rtpp_socket, rtpp_socket_settimestamp, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_setgro, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_setbusypoll, int, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_settxtime, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_setconnect, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_setsrcfilter, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_setpeer, int, struct rtpp_netaddr *,
+  int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_kdrops, uint64_t, uint64_t *);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_seturing, int,
+  struct rtpp_uring_rxq *);
 #if 0
 /*DEFINE_METHOD(rtpp_socket, rtpp_socket_send_pkt, int,
   struct sthread_args *, const struct sockaddr *, int, struct rtp_packet *,
@@ -50,6 +62,11 @@ DEFINE_METHOD(rtpp_socket, rtpp_socket_send_pkt_na, int,
   struct rtpp_log *);
 DEFINE_METHOD(rtpp_socket, rtpp_socket_rtp_recv, struct rtp_packet *,
   const struct rtpp_timestamp *, const struct sockaddr *, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_rtp_recvm, int,
+  const struct rtpp_timestamp *, const struct sockaddr *, int,
+  struct rtp_packet **, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_rx_pending, int);
+DEFINE_METHOD(rtpp_socket, rtpp_socket_rx_backlog, int);
 DEFINE_METHOD(rtpp_socket, rtpp_socket_getfd, int);
 DEFINE_METHOD(rtpp_socket, rtpp_socket_drain, int, const char *,
   struct rtpp_log *);
@@ -60,13 +77,25 @@ struct rtpp_socket {
     METHOD_ENTRY(rtpp_socket_bind, bind2);
     METHOD_ENTRY(rtpp_socket_settos, settos);
     METHOD_ENTRY(rtpp_socket_setrbuf, setrbuf);
+    METHOD_ENTRY(rtpp_socket_getrbuf, getrbuf);
     METHOD_ENTRY(rtpp_socket_setnonblock, setnonblock);
     METHOD_ENTRY(rtpp_socket_settimestamp, settimestamp);
+    METHOD_ENTRY(rtpp_socket_setgro, setgro);
+    METHOD_ENTRY(rtpp_socket_setbusypoll, setbusypoll);
+    METHOD_ENTRY(rtpp_socket_settxtime, settxtime);
+    METHOD_ENTRY(rtpp_socket_setconnect, setconnect);
+    METHOD_ENTRY(rtpp_socket_setsrcfilter, setsrcfilter);
+    METHOD_ENTRY(rtpp_socket_setpeer, setpeer);
+    METHOD_ENTRY(rtpp_socket_kdrops, kdrops);
+    METHOD_ENTRY(rtpp_socket_seturing, seturing);
 #if 0
     METHOD_ENTRY(rtpp_socket_send_pkt, send_pkt);
 #endif
     METHOD_ENTRY(rtpp_socket_send_pkt_na, send_pkt_na);
     METHOD_ENTRY(rtpp_socket_rtp_recv, rtp_recv);
+    METHOD_ENTRY(rtpp_socket_rtp_recvm, rtp_recvm);
+    METHOD_ENTRY(rtpp_socket_rx_pending, rx_pending);
+    METHOD_ENTRY(rtpp_socket_rx_backlog, rx_backlog);
     METHOD_ENTRY(rtpp_socket_getfd, getfd);
     METHOD_ENTRY(rtpp_socket_drain, drain);
 };
@@ -95,7 +95,14 @@ static struct rtpp_stat_descr default_stats[] = {
     {.name = "npkts_resizer_out",    .descr = "Total number of RTP packets egress out of resizer (re-packetizer)", .type = RTPP_CNT_U64},
     {.name = "npkts_resizer_discard",.descr = "Total number of RTP packets dropped by the resizer (re-packetizer)", .type = RTPP_CNT_U64},
     {.name = "npkts_discard",        .descr = "Total number of RTP/RTPC packets discarded", .type = RTPP_CNT_U64},
+    {.name = "npkts_kdropped",       .descr = "Total number of RTP/RTCP packets dropped by the kernel due to the socket buffer overflow", .type = RTPP_CNT_U64},
+    {.name = "npkts_kfiltered",      .descr = "Total number of RTP/RTCP packets rejected by the kernel source filter", .type = RTPP_CNT_U64},
+    {.name = "npkts_policed",        .descr = "Total number of RTP/RTCP packets dropped for exceeding the per-stream rate limit", .type = RTPP_CNT_U64},
+    {.name = "nrx_budget_hits",      .descr = "Number of times a stream has used up its receive budget for the forwarding round with packets still queued", .type = RTPP_CNT_U64},
+    {.name = "npkts_offloaded",      .descr = "Total number of RTP/RTCP packets relayed in-kernel (eBPF offload)", .type = RTPP_CNT_U64},
     {.name = "total_duration",       .descr = "Cumulative duration of all sessions", .type = RTPP_CNT_DBL},
+    {.name = "bpoll_time_spin",      .descr = "Time spent by the forwarding workers spinning idle (busy-poll mode)", .type = RTPP_CNT_DBL},
+    {.name = "bpoll_time_work",      .descr = "Time spent by the forwarding workers doing work (busy-poll mode)", .type = RTPP_CNT_DBL},
     {.name = "ncmds_rcvd",           .descr = "Total number of control commands received", .type = RTPP_CNT_U64},
     {.name = "ncmds_rcvd_ndups",     .descr = "Total number of duplicate control commands received", .type = RTPP_CNT_U64},
     {.name = "ncmds_succd",          .descr = "Total number of control commands successfully processed", .type = RTPP_CNT_U64},
@@ -30,6 +30,8 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -59,6 +61,7 @@
 #include "rtpp_network.h"
 #include "rtpp_pcount.h"
 #include "rtpp_pcnt_strm.h"
+#include "rtpp_pcnts_strm.h"
 #include "rtpp_proc.h"
 #include "rtpp_record.h"
 #include "rtpp_stats.h"
@@ -72,8 +75,16 @@
 #include "rtpp_netaddr.h"
 #include "rtpp_debug.h"
 #include "rtpp_acct_pipe.h"
+#include "rtpp_ebpf.h"
+#include "rtpp_math.h"
+#include "rtpp_tbucket.h"
 
 #define  SEQ_SYNC_IVAL   1.0    /* in seconds */
+#define  POLICE_BURST    0.25   /* in seconds worth of the rate limit */
+#define  RBUF_WINDOW     0.25   /* in seconds of traffic to absorb */
+#define  RBUF_PKTCOST    1024   /* SO_RCVBUF bytes per packet, kernel doubles it */
+#define  RBUF_HOLD       30     /* in checks, after the kernel has dropped packets */
+#define  RBUF_SHRINK_IVAL 5     /* in checks, between two shrinking steps */
 
 struct rtpps_latch {
     int latched;
@@ -82,35 +93,112 @@ struct rtpps_latch {
     double last_sync;
 };
 
+/*
+ * What the rx/tx path needs to know about the remote end, published by
+ * the _rtpp_stream_publish() every time any of it changes and never
+ * modified after that.
+ */
+struct rtpps_peer {
+    struct rtpp_refcnt *rcnt;
+    /* Socket, NULL - none yet */
+    struct rtpp_socket *fd;
+    /* Private copy of the remote address, NULL - not known yet */
+    struct rtpp_netaddr *rem_addr;
+    int latched;
+};
+
+#define RTPPS_POLICE_REQ(pps, kbps) (((uint64_t)(pps) << 32) | (uint32_t)(kbps))
+#define RTPPS_POLICE_PPS(req)       ((int)((req) >> 32))
+#define RTPPS_POLICE_KBPS(req)      ((int)((req) & 0xffffffff))
+
+struct rtpps_police {
+    /*
+     * Limits as requested, see RTPPS_POLICE_REQ(), 0 - not limited. The
+     * rx path picks those up into the cur and re-sets buckets.
+     */
+    _Atomic(uint64_t) req;
+    uint64_t cur;
+    struct rtpp_tbucket pkts;
+    struct rtpp_tbucket bytes;
+};
+
+struct rtpps_rbuf {
+    /* SO_RCVBUF in effect on the socket as reported by it, 0 - unknown */
+    int size;
+    /* Largest SO_RCVBUF the kernel would let us have, 0 - unknown */
+    int limit;
+    /* Packet counter and time as of the last check */
+    unsigned long npkts_last;
+    double last;
+    /* Number of checks left before the buffer can be shrunk */
+    int hold;
+    /* Times the receive budget has been used up as of the last check */
+    unsigned long nthrottled_last;
+};
+
 struct rtps {
-    uint64_t uid;
+    /* Written with the lock held, read lock-free by the isplayer_active() */
+    _Atomic(uint64_t) uid;
     int inact;
 };
 
+struct rtpps_offload {
+    struct rtpp_ebpf *ebpf;
+    /* In-kernel relay entry for our inbound flow, if installed */
+    int active;
+    struct rtpp_ebpf_flow key;
+    /* Counters in here are those we have already accounted for */
+    struct rtpp_ebpf_ent ent;
+    /* Inbound flow of the peer's entry that relays into us, if any */
+    int ractive;
+    struct rtpp_ebpf_flow rkey;
+};
+
 struct rtpp_stream_priv
 {
     struct rtpp_stream pub;
-    struct rtpp_weakref_obj *servers_wrt;
-    struct rtpp_stats *rtpp_stats;
-    pthread_mutex_t lock;
+    /* vvv Used by the rx/tx path for every packet, lock-free vvv */
+    /* Current snapshot of the fd, rem_addr and latch_info.latched */
+    _Atomic(struct rtpps_peer *) peer;
+    /* Number of threads between _rtpp_stream_peer_enter() and exit() */
+    atomic_uint npeer_readers;
     /* Weak reference to the "rtpp_server" (player) */
     struct rtps rtps;
+    /* Ingress rate limits */
+    struct rtpps_police police;
+    /* vvv Protected by the lock, rx path only takes it on a change vvv */
+    pthread_mutex_t lock;
+    /* Descriptor */
+    struct rtpp_socket *fd;
+    /* Remote source address */
+    struct rtpp_netaddr *rem_addr;
+    /* Flag which tells if we are allowed to update address with RTP src IP */
+    struct rtpps_latch latch_info;
+    /* vvv Control path only vvv */
+    struct rtpp_weakref_obj *servers_wrt;
+    struct rtpp_stats *rtpp_stats;
     /* Timestamp of the last session update */
     double last_update;
     /* Flag that indicates whether or not address supplied by client can't be trusted */
     int untrusted_addr;
     /* Save previous address when doing update */
     struct rtpp_netaddr *raddr_prev;
-    /* Flag which tells if we are allowed to update address with RTP src IP */
-    struct rtpps_latch latch_info;
     /* Structure to track hold requests */
     struct rtpp_acct_hold hld_stat;
-    /* Descriptor */
-    struct rtpp_socket *fd;
-    /* Remote source address */
-    struct rtpp_netaddr *rem_addr;
+    /* State of the eBPF offload */
+    struct rtpps_offload ofld;
+    /* Receive buffer sizing */
+    struct rtpps_rbuf rbuf;
 };
 
+/*
+ * Keep what the rx path touches for every packet within the first four
+ * cache lines and the rest of the per-packet state (policing) within six.
+ */
+RTPP_LAYOUT_FITS(struct rtpp_stream_priv, pub.stuid_rtcp, 2);
+RTPP_LAYOUT_FITS(struct rtpp_stream_priv, rtps.uid, 4);
+RTPP_LAYOUT_FITS(struct rtpp_stream_priv, police, 6);
+
 static void rtpp_stream_dtor(struct rtpp_stream_priv *);
 static int rtpp_stream_handle_play(struct rtpp_stream *, const char *,
   const char *, int, struct rtpp_command *, int);
@@ -135,18 +223,33 @@ static struct rtpp_socket *rtpp_stream_update_skt(struct rtpp_stream *,
   struct rtpp_socket *);
 static int rtpp_stream_send_pkt(struct rtpp_stream *, struct sthread_args *,
   struct rtp_packet *);
-static struct rtp_packet *_rtpp_stream_recv_pkt(struct rtpp_stream_priv *,
-  const struct rtpp_timestamp *);
 static int rtpp_stream_issendable(struct rtpp_stream *);
 static int _rtpp_stream_islatched(struct rtpp_stream_priv *);
+static uint64_t _rtpp_stream_reg_kdrops(struct rtpp_stream_priv *,
+  struct rtpp_socket *, int);
 static void rtpp_stream_locklatch(struct rtpp_stream *);
 static void rtpp_stream_reg_onhold(struct rtpp_stream *);
 void rtpp_stream_get_stats(struct rtpp_stream *, struct rtpp_acct_hold *);
 static struct rtp_packet *rtpp_stream_rx(struct rtpp_stream *,
   struct rtpp_weakref_obj *, const struct rtpp_timestamp *, struct rtpp_proc_rstats *);
+static struct rtp_packet *rtpp_stream_rx_demux(struct rtpp_stream *,
+  struct rtpp_weakref_obj *, const struct rtpp_timestamp *,
+  struct rtpp_proc_rstats *, struct rtp_packet *);
+static int rtpp_stream_rx_batch(struct rtpp_stream *,
+  struct rtpp_weakref_obj *, const struct rtpp_timestamp *, struct rtpp_proc_rstats *,
+  struct rtp_packet **, int);
 static struct rtpp_netaddr *rtpp_stream_get_rem_addr(struct rtpp_stream *, int);
-
-static const struct rtpp_stream_smethods rtpp_stream_smethods = {
+static void rtpp_stream_offload_sync(struct rtpp_stream *, struct rtpp_stream *,
+  struct rtpp_ebpf *);
+static int rtpp_stream_offload_target(struct rtpp_stream *, struct rtpp_ebpf *,
+  const struct rtpp_ebpf_flow *, struct rtpp_ebpf_flow *);
+static void rtpp_stream_offload_reset(struct rtpp_stream *);
+static void _rtpp_stream_offload_reset(struct rtpp_stream_priv *);
+static void rtpp_stream_set_police(struct rtpp_stream *, int, int);
+static void rtpp_stream_tune_rbuf(struct rtpp_stream *, double, int);
+static int _rtpp_stream_publish(struct rtpp_stream_priv *);
+
+const struct rtpp_stream_smethods rtpp_stream_smethods = {
     .handle_play = &rtpp_stream_handle_play,
     .handle_noplay = &rtpp_stream_handle_noplay,
     .isplayer_active = &rtpp_stream_isplayer_active,
@@ -164,7 +267,14 @@ static const struct rtpp_stream_smethods rtpp_stream_smethods = {
     .reg_onhold = &rtpp_stream_reg_onhold,
     .get_stats = &rtpp_stream_get_stats,
     .rx = &rtpp_stream_rx,
-    .get_rem_addr = &rtpp_stream_get_rem_addr
+    .rx_batch = &rtpp_stream_rx_batch,
+    .rx_demux = &rtpp_stream_rx_demux,
+    .get_rem_addr = &rtpp_stream_get_rem_addr,
+    .offload_sync = &rtpp_stream_offload_sync,
+    .offload_target = &rtpp_stream_offload_target,
+    .offload_reset = &rtpp_stream_offload_reset,
+    .set_police = &rtpp_stream_set_police,
+    .tune_rbuf = &rtpp_stream_tune_rbuf
 };
 
 struct rtpp_stream *
@@ -174,7 +284,8 @@ rtpp_stream_ctor(struct rtpp_log *log, struct rtpp_weakref_obj *servers_wrt,
 {
     struct rtpp_stream_priv *pvt;
 
-    pvt = rtpp_rzmalloc(sizeof(struct rtpp_stream_priv), PVT_RCOFFS(pvt));
+    pvt = rtpp_rzmalloc_aligned(sizeof(struct rtpp_stream_priv), PVT_RCOFFS(pvt),
+      RTPP_CACHE_LINE);
     if (pvt == NULL) {
         goto e0;
     }
@@ -209,10 +320,16 @@ rtpp_stream_ctor(struct rtpp_log *log, struct rtpp_weakref_obj *servers_wrt,
 
     rtpp_gen_uid(&pvt->pub.stuid);
     pvt->pub.seuid = seuid;
+    if (_rtpp_stream_publish(pvt) != 0) {
+        goto e7;
+    }
     CALL_SMETHOD(pvt->pub.rcnt, attach, (rtpp_refcnt_dtor_t)&rtpp_stream_dtor,
       pvt);
     return (&pvt->pub);
 
+e7:
+    RTPP_OBJ_DECREF(pvt->pub.log);
+    RTPP_OBJ_DECREF(pvt->rem_addr);
 e6:
     RTPP_OBJ_DECREF(pvt->raddr_prev);
 e5:
@@ -296,8 +413,12 @@ rtpp_stream_dtor(struct rtpp_stream_priv *pvt)
          }
          RTPP_OBJ_DECREF(pvt->pub.analyzer);
     }
-    if (pvt->fd != NULL)
+    _rtpp_stream_offload_reset(pvt);
+    if (pvt->fd != NULL) {
+        _rtpp_stream_reg_kdrops(pvt, pvt->fd, 0);
         RTPP_OBJ_DECREF(pvt->fd);
+    }
+    RTPP_OBJ_DECREF(atomic_load(&pvt->peer));
     if (pub->codecs != NULL)
         free(pub->codecs);
     if (pvt->rtps.uid != RTPP_UID_NONE)
@@ -342,6 +463,7 @@ rtpp_stream_handle_play(struct rtpp_stream *self, const char *codecs,
 
     PUB2PVT(self, pvt);
     pthread_mutex_lock(&pvt->lock);
+    _rtpp_stream_offload_reset(pvt);
     plerror = "reason unknown";
     while (*codecs != '\0') {
         n = strtol(codecs, &cp, 10);
@@ -425,9 +547,7 @@ rtpp_stream_isplayer_active(struct rtpp_stream *self)
     int rval;
 
     PUB2PVT(self, pvt);
-    pthread_mutex_lock(&pvt->lock);
     rval = (pvt->rtps.uid != RTPP_UID_NONE) ? 1 : 0;
-    pthread_mutex_unlock(&pvt->lock);
     return (rval);
 }
 
@@ -462,6 +582,155 @@ rtpp_stream_get_proto(struct rtpp_stream *self)
     return (PP_NAME(self->pipe_type));
 }
 
+static void
+rtpps_peer_dtor(struct rtpps_peer *pp)
+{
+
+    if (pp->fd != NULL)
+        RTPP_OBJ_DECREF(pp->fd);
+    if (pp->rem_addr != NULL)
+        RTPP_OBJ_DECREF(pp->rem_addr);
+    free(pp);
+}
+
+/*
+ * Replace the snapshot used by the rx/tx path with the one reflecting
+ * current state. The old one is released once nobody could be looking
+ * at it without holding a reference. Must be called with the lock held
+ * and never between the _rtpp_stream_peer_enter() and exit(). The old
+ * snapshot stays in effect if we fail to allocate a new one.
+ */
+static int
+_rtpp_stream_publish(struct rtpp_stream_priv *pvt)
+{
+    struct rtpps_peer *pp, *opp;
+
+    pp = rtpp_rzmalloc(sizeof(*pp), offsetof(struct rtpps_peer, rcnt));
+    if (pp == NULL) {
+        goto e0;
+    }
+    if (!CALL_SMETHOD(pvt->rem_addr, isempty)) {
+        pp->rem_addr = rtpp_netaddr_ctor();
+        if (pp->rem_addr == NULL) {
+            goto e1;
+        }
+        CALL_SMETHOD(pp->rem_addr, copy, pvt->rem_addr);
+    }
+    if (pvt->fd != NULL) {
+        pp->fd = pvt->fd;
+        RTPP_OBJ_INCREF(pp->fd);
+    }
+    pp->latched = pvt->latch_info.latched;
+    CALL_SMETHOD(pp->rcnt, attach, (rtpp_refcnt_dtor_t)&rtpps_peer_dtor, pp);
+    opp = atomic_exchange(&pvt->peer, pp);
+    /*
+     * Whoever has entered before the exchange may still be using the old
+     * one, and whoever enters after it sees the new one.
+     */
+    while (atomic_load(&pvt->npeer_readers) != 0)
+        sched_yield();
+    if (opp != NULL)
+        RTPP_OBJ_DECREF(opp);
+    return (0);
+
+e1:
+    RTPP_OBJ_DECREF(pp);
+    free(pp);
+e0:
+    RTPP_LOG(pvt->pub.log, RTPP_LOG_ERR, "can't allocate memory to "
+      "update %s's %s stream state", _rtpp_stream_get_actor(pvt),
+      _rtpp_stream_get_proto(pvt));
+    return (-1);
+}
+
+/*
+ * Get hold of the current snapshot for a short while, no reference is
+ * taken. Nothing in between this and the _rtpp_stream_peer_exit() may
+ * block or change the stream state.
+ */
+static inline struct rtpps_peer *
+_rtpp_stream_peer_enter(struct rtpp_stream_priv *pvt)
+{
+
+    atomic_fetch_add(&pvt->npeer_readers, 1);
+    return (atomic_load(&pvt->peer));
+}
+
+static inline void
+_rtpp_stream_peer_exit(struct rtpp_stream_priv *pvt)
+{
+
+    atomic_fetch_sub(&pvt->npeer_readers, 1);
+}
+
+/* Same, but with the reference taken, to be kept for as long as needed */
+static struct rtpps_peer *
+_rtpp_stream_peer_get(struct rtpp_stream_priv *pvt)
+{
+    struct rtpps_peer *pp;
+
+    pp = _rtpp_stream_peer_enter(pvt);
+    RTPP_OBJ_INCREF(pp);
+    _rtpp_stream_peer_exit(pvt);
+    return (pp);
+}
+
+/*
+ * Called with the lock held after any change to the fd, rem_addr or latch
+ * state. Publish the new state to the rx/tx path and restrict the socket
+ * to the remote address (connect() and/or source filter) as long as we
+ * are sure it is the right one (i.e. latched), and lift the restriction
+ * otherwise, so that packets from a new source can get through. The latter
+ * only has effect if the socket has been set up for it, see
+ * rtpp_socket_setconnect() and rtpp_socket_setsrcfilter().
+ */
+static void
+_rtpp_stream_update_peer(struct rtpp_stream_priv *pvt)
+{
+
+    _rtpp_stream_publish(pvt);
+    _rtpp_stream_offload_reset(pvt);
+    if (pvt->fd == NULL)
+        return;
+    /* Shared socket is managed by the RTP stream */
+    if (pvt->pub.rtcp_mux != 0 && pvt->pub.pipe_type == PIPE_RTCP)
+        return;
+    if (pvt->latch_info.latched != 0 &&
+      !CALL_SMETHOD(pvt->rem_addr, isempty)) {
+        CALL_METHOD(pvt->fd, setpeer, pvt->rem_addr, pvt->pub.asymmetric);
+    } else {
+        CALL_METHOD(pvt->fd, setpeer, NULL, 0);
+    }
+}
+
+/*
+ * Account for packets dropped by the kernel, returns how many of those
+ * were lost to the receive buffer overflow. The rest has been rejected
+ * by the source filter, those are of no concern for the stream. With
+ * the filter on the socket can only tell overflows that are still going
+ * on, so if the stream has been falling behind since the last check
+ * (congested) all of the drops are taken for overflows.
+ */
+static uint64_t
+_rtpp_stream_reg_kdrops(struct rtpp_stream_priv *pvt, struct rtpp_socket *skt,
+  int congested)
+{
+    uint64_t ndrops, novflw;
+
+    ndrops = CALL_METHOD(skt, kdrops, &novflw);
+    if (congested)
+        novflw = ndrops;
+    if (novflw > 0) {
+        CALL_SMETHOD(pvt->rtpp_stats, updatebyname, "npkts_kdropped", novflw);
+        CALL_METHOD(pvt->pub.pcnt_strm, reg_kdropped, novflw);
+    }
+    if (ndrops > novflw) {
+        CALL_SMETHOD(pvt->rtpp_stats, updatebyname, "npkts_kfiltered",
+          ndrops - novflw);
+    }
+    return (novflw);
+}
+
 static int
 _rtpp_stream_latch(struct rtpp_stream_priv *pvt, double dtime,
   struct rtp_packet *packet)
@@ -510,6 +779,7 @@ _rtpp_stream_latch(struct rtpp_stream_priv *pvt, double dtime,
       "%s's address %s: %s (%s), SSRC=%s, Seq=%s", actor, relatch,
       saddr, ptype, ssrc, seq);
     pvt->latch_info.latched = newlatch;
+    _rtpp_stream_update_peer(pvt);
     return (1);
 }
 
@@ -520,16 +790,19 @@ _rtpp_stream_latch_sync(struct rtpp_stream_priv *pvt, double dtime,
     struct rtpps_latch *lip;
 
     lip = &pvt->latch_info;
-    if (pvt->pub.pipe_type != PIPE_RTP || lip->ssrc.inited == 0)
+    if (pvt->pub.pipe_type != PIPE_RTP)
         return;
-    if (dtime - lip->last_sync < SEQ_SYNC_IVAL)
+    /* Only updated by the rx path, so it's safe to peek without the lock */
+    if (lip->ssrc.inited == 0 || dtime - lip->last_sync < SEQ_SYNC_IVAL)
         return;
     if (rtp_packet_parse(packet) != RTP_PARSER_OK)
         return;
-    if (lip->ssrc.val != packet->parsed->ssrc)
-        return;
-    lip->seq = packet->parsed->seq;
-    lip->last_sync = dtime;
+    pthread_mutex_lock(&pvt->lock);
+    if (lip->ssrc.inited != 0 && lip->ssrc.val == packet->parsed->ssrc) {
+        lip->seq = packet->parsed->seq;
+        lip->last_sync = dtime;
+    }
+    pthread_mutex_unlock(&pvt->lock);
 }
 
 static int
@@ -593,6 +866,7 @@ __rtpp_stream_fill_addr(struct rtpp_stream_priv *pvt, struct rtp_packet *packet)
     if (pvt->rtps.inact != 0 && pvt->fd != NULL) {
         _rtpp_stream_plr_start(pvt, packet->rtime.mono);
     }
+    _rtpp_stream_update_peer(pvt);
 
     actor = _rtpp_stream_get_actor(pvt);
     ptype = _rtpp_stream_get_proto(pvt);
@@ -614,8 +888,11 @@ rtpp_stream_guess_addr(struct rtpp_stream *self,
     RTPP_DBG_ASSERT(self->pipe_type == PIPE_RTCP);
     PUB2PVT(self, pvt);
 
+    /* Called by the RTP stream with its lock held */
+    pthread_mutex_lock(&pvt->lock);
     if (!CALL_SMETHOD(pvt->rem_addr, isempty) &&
       CALL_SMETHOD(pvt->rem_addr, cmphost, sstosa(&packet->raddr))) {
+        pthread_mutex_unlock(&pvt->lock);
         return (0);
     }
 #if 0
@@ -629,18 +906,24 @@ rtpp_stream_guess_addr(struct rtpp_stream *self,
     actor = rtpp_stream_get_actor(self);
     ptype = rtpp_stream_get_proto(self);
     rport = ntohs(satosin(&packet->raddr)->sin_port);
-    if (IS_LAST_PORT(rport)) {
-        return (-1);
+    if (self->rtcp_mux == 0) {
+        if (IS_LAST_PORT(rport)) {
+            pthread_mutex_unlock(&pvt->lock);
+            return (-1);
+        }
+        rport += 1;
     }
 
     memcpy(&ta, &packet->raddr, packet->rlen);
-    setport(sstosa(&ta), rport + 1);
+    setport(sstosa(&ta), rport);
 
     CALL_SMETHOD(pvt->rem_addr, set, sstosa(&ta), packet->rlen);
     /* Use guessed value as the only true one for asymmetric clients */
     pvt->latch_info.latched = self->asymmetric;
+    _rtpp_stream_update_peer(pvt);
+    pthread_mutex_unlock(&pvt->lock);
     RTPP_LOG(pvt->pub.log, RTPP_LOG_INFO, "guessing %s port "
-      "for %s to be %d", ptype, actor, rport + 1);
+      "for %s to be %d", ptype, actor, rport);
 
     return (0);
 }
@@ -694,6 +977,7 @@ rtpp_stream_prefill_addr(struct rtpp_stream *self, struct sockaddr **iapp,
     if (pvt->rtps.inact != 0 && pvt->fd != NULL) {
         _rtpp_stream_plr_start(pvt, dtime);
     }
+    _rtpp_stream_update_peer(pvt);
     pthread_mutex_unlock(&pvt->lock);
 }
 
@@ -726,15 +1010,18 @@ rtpp_stream_set_skt(struct rtpp_stream *self, struct rtpp_socket *new_skt)
         RTPP_DBG_ASSERT(pvt->fd != NULL);
         RTPP_OBJ_DECREF(pvt->fd);
         pvt->fd = NULL;
+        _rtpp_stream_publish(pvt);
         pthread_mutex_unlock(&pvt->lock);
         return;
     }
     RTPP_DBG_ASSERT(pvt->fd == NULL);
     pvt->fd = new_skt;
     RTPP_OBJ_INCREF(pvt->fd);
+    pvt->rbuf.size = pvt->rbuf.limit = 0;
     if (pvt->rtps.inact != 0 && !CALL_SMETHOD(pvt->rem_addr, isempty)) {
         _rtpp_stream_plr_start(pvt, getdtime());
     }
+    _rtpp_stream_update_peer(pvt);
     pthread_mutex_unlock(&pvt->lock);
 }
 
@@ -766,11 +1053,16 @@ rtpp_stream_update_skt(struct rtpp_stream *self, struct rtpp_socket *new_skt)
     PUB2PVT(self, pvt);
     pthread_mutex_lock(&pvt->lock);
     old_skt = pvt->fd;
+    if (old_skt != NULL)
+        _rtpp_stream_reg_kdrops(pvt, old_skt, 0);
     pvt->fd = new_skt;
     RTPP_OBJ_INCREF(pvt->fd);
+    pvt->rbuf.size = pvt->rbuf.limit = 0;
     if (pvt->rtps.inact != 0 && !CALL_SMETHOD(pvt->rem_addr, isempty)) {
         _rtpp_stream_plr_start(pvt, getdtime());
     }
+    /* Old socket is left as is, it may still have packets queued */
+    _rtpp_stream_update_peer(pvt);
     pthread_mutex_unlock(&pvt->lock);
     return (old_skt);
 }
@@ -780,43 +1072,34 @@ rtpp_stream_send_pkt(struct rtpp_stream *self, struct sthread_args *sap,
   struct rtp_packet *pkt)
 {
     struct rtpp_stream_priv *pvt;
+    struct rtpps_peer *pp;
     int rval;
 
     PUB2PVT(self, pvt);
-    pthread_mutex_lock(&pvt->lock);
-    rval = CALL_METHOD(pvt->fd, send_pkt_na, sap, pvt->rem_addr, pkt,
-      self->log);
-    pthread_mutex_unlock(&pvt->lock);
+    pp = _rtpp_stream_peer_enter(pvt);
+    if (pp->fd != NULL && pp->rem_addr != NULL) {
+        rval = CALL_METHOD(pp->fd, send_pkt_na, sap, pp->rem_addr, pkt,
+          self->log);
+    } else {
+        RTPP_OBJ_DECREF(pkt);
+        rval = -1;
+    }
+    _rtpp_stream_peer_exit(pvt);
     return (rval);
 }
 
-static struct rtp_packet *
-_rtpp_stream_recv_pkt(struct rtpp_stream_priv *pvt,
-  const struct rtpp_timestamp *dtime)
-{
-    struct rtp_packet *pkt;
-
-    pkt = CALL_METHOD(pvt->fd, rtp_recv, dtime, pvt->pub.laddr, pvt->pub.port);
-    return (pkt);
-}
-
 static int
 rtpp_stream_issendable(struct rtpp_stream *self)
 {
     struct rtpp_stream_priv *pvt;
+    struct rtpps_peer *pp;
+    int rval;
 
     PUB2PVT(self, pvt);
-    pthread_mutex_lock(&pvt->lock);
-    if (CALL_SMETHOD(pvt->rem_addr, isempty)) {
-        pthread_mutex_unlock(&pvt->lock);
-        return (0);
-    }
-    if (pvt->fd == NULL) {
-        pthread_mutex_unlock(&pvt->lock);
-        return (0);
-    }
-    pthread_mutex_unlock(&pvt->lock);
-    return (1);
+    pp = _rtpp_stream_peer_enter(pvt);
+    rval = (pp->rem_addr != NULL && pp->fd != NULL);
+    _rtpp_stream_peer_exit(pvt);
+    return (rval);
 }
 
 static int
@@ -836,6 +1119,7 @@ rtpp_stream_locklatch(struct rtpp_stream *self)
     PUB2PVT(self, pvt);
     pthread_mutex_lock(&pvt->lock);
     pvt->latch_info.latched = 1;
+    _rtpp_stream_update_peer(pvt);
     pthread_mutex_unlock(&pvt->lock);
 }
 
@@ -871,84 +1155,273 @@ _rtpp_stream_fill_addr(struct rtpp_stream_priv *pvt,
     return (rval);
 }
 
-static struct rtp_packet *
-rtpp_stream_rx(struct rtpp_stream *self, struct rtpp_weakref_obj *rtcps_wrt,
-  const struct rtpp_timestamp *dtime, struct rtpp_proc_rstats *rsp)
+/*
+ * Check whether the packet comes from where the snapshot says the remote
+ * end is, in which case there is nothing to latch or update and the lock
+ * need not be taken.
+ */
+static inline int
+_rtpp_stream_rx_known(const struct rtpp_stream *self,
+  const struct rtpps_peer *pp, struct rtp_packet *packet)
 {
-    struct rtp_packet *packet = NULL;
-    struct rtpp_stream_priv *pvt;
 
-    PUB2PVT(self, pvt);
-    pthread_mutex_lock(&pvt->lock);
-    packet = _rtpp_stream_recv_pkt(pvt, dtime);
-    if (packet == NULL) {
-        /* Move on to the next session */
-        pthread_mutex_unlock(&pvt->lock);
-        return (NULL);
+    if (pp->rem_addr == NULL)
+        return (0);
+    if (self->asymmetric != 0) {
+        /*
+         * For asymmetric clients don't check
+         * source port since it may be different.
+         */
+        return (CALL_SMETHOD(pp->rem_addr, cmphost, sstosa(&packet->raddr)));
     }
-    rsp->npkts_rcvd.cnt++;
+    return (pp->latched != 0 && CALL_SMETHOD(pp->rem_addr, cmp,
+      sstosa(&packet->raddr), packet->rlen) == 0);
+}
 
-    if (!CALL_SMETHOD(pvt->rem_addr, isempty)) {
-        /* Check that the packet is authentic, drop if it isn't */
-        if (self->asymmetric == 0) {
-            if (CALL_SMETHOD(pvt->rem_addr, cmp, sstosa(&packet->raddr),
-              packet->rlen) != 0) {
-                if (_rtpp_stream_islatched(pvt) && \
-                  _rtpp_stream_check_latch_override(pvt, packet, dtime->mono) == 0) {
-                    /*
-                     * Continue, since there could be good packets in
-                     * queue.
-                     */
-                    CALL_METHOD(self->pcount, reg_ignr);
-                    goto discard_and_continue;
-                } else if (!_rtpp_stream_islatched(pvt)) {
-                    _rtpp_stream_latch(pvt, dtime->mono, packet);
-                }
-                /* Signal that an address has to be updated */
-                _rtpp_stream_fill_addr(pvt, rtcps_wrt, packet);
+/*
+ * Authentication and latching logic for a packet that has not passed the
+ * _rtpp_stream_rx_known(). Must be called with the pvt->lock held. Returns
+ * -1 if the packet is not authentic and has to be discarded.
+ */
+static int
+_rtpp_stream_rx_auth(struct rtpp_stream_priv *pvt,
+  struct rtpp_weakref_obj *rtcps_wrt, const struct rtpp_timestamp *dtime,
+  struct rtp_packet *packet)
+{
+    struct rtpp_stream *self;
+
+    self = &pvt->pub;
+    if (CALL_SMETHOD(pvt->rem_addr, isempty)) {
+        /* Update address recorded in the session */
+        _rtpp_stream_fill_addr(pvt, rtcps_wrt, packet);
+        return (0);
+    }
+    /* Check that the packet is authentic, drop if it isn't */
+    if (self->asymmetric == 0) {
+        if (CALL_SMETHOD(pvt->rem_addr, cmp, sstosa(&packet->raddr),
+          packet->rlen) != 0) {
+            if (_rtpp_stream_islatched(pvt) && \
+              _rtpp_stream_check_latch_override(pvt, packet, dtime->mono) == 0) {
+                return (-1);
             } else if (!_rtpp_stream_islatched(pvt)) {
                 _rtpp_stream_latch(pvt, dtime->mono, packet);
             }
-        } else {
-            /*
-             * For asymmetric clients don't check
-             * source port since it may be different.
-             */
-            if (!CALL_SMETHOD(pvt->rem_addr, cmphost, sstosa(&packet->raddr))) {
-                /*
-                 * Continue, since there could be good packets in
-                 * queue.
-                 */
-                CALL_METHOD(self->pcount, reg_ignr);
-                goto discard_and_continue;
-            }
+            /* Signal that an address has to be updated */
+            _rtpp_stream_fill_addr(pvt, rtcps_wrt, packet);
+        } else if (!_rtpp_stream_islatched(pvt)) {
+            _rtpp_stream_latch(pvt, dtime->mono, packet);
         }
-        CALL_METHOD(self->pcnt_strm, reg_pktin, packet);
-    } else {
-        CALL_METHOD(self->pcnt_strm, reg_pktin, packet);
-        /* Update address recorded in the session */
-        _rtpp_stream_fill_addr(pvt, rtcps_wrt, packet);
+    } else if (!CALL_SMETHOD(pvt->rem_addr, cmphost,
+      sstosa(&packet->raddr))) {
+        return (-1);
     }
+    return (0);
+}
+
+/*
+ * Check the packet against the rate limits, returns -1 if it is over. The
+ * buckets are only ever touched by the rx path, limits requested by the
+ * set_police() are picked up here.
+ */
+static int
+_rtpp_stream_police(struct rtpp_stream_priv *pvt, struct rtp_packet *packet)
+{
+    struct rtpps_police *plp;
+    uint64_t req;
+    double rate;
+    int pps;
+
+    plp = &pvt->police;
+    req = atomic_load_explicit(&plp->req, memory_order_relaxed);
+    if (req != plp->cur) {
+        pps = RTPPS_POLICE_PPS(req);
+        rtpp_tbucket_init(&plp->pkts, pps, MAX(pps * POLICE_BURST, 1.0));
+        rate = (double)RTPPS_POLICE_KBPS(req) * 1000.0 / 8.0;
+        rtpp_tbucket_init(&plp->bytes, rate, MAX(rate * POLICE_BURST,
+          MAX_RPKT_LEN));
+        plp->cur = req;
+    }
+    if (req == 0)
+        return (0);
+    if (!rtpp_tbucket_check(&plp->pkts, 1.0, packet->rtime.mono) ||
+      !rtpp_tbucket_check(&plp->bytes, packet->size, packet->rtime.mono))
+        return (-1);
+    rtpp_tbucket_debit(&plp->pkts, 1.0);
+    rtpp_tbucket_debit(&plp->bytes, packet->size);
+    return (0);
+}
+
+/* Feed the accepted packet to the analyzer, re-latch on the SSRC change */
+static void
+_rtpp_stream_rx_track(struct rtpp_stream_priv *pvt,
+  const struct rtpp_timestamp *dtime, struct rtp_packet *packet)
+{
+    struct rtpp_stream *self;
+
+    self = &pvt->pub;
     if (self->analyzer != NULL) {
         if (CALL_METHOD(self->analyzer, update, packet) == UPDATE_SSRC_CHG) {
+            pthread_mutex_lock(&pvt->lock);
             _rtpp_stream_latch(pvt, dtime->mono, packet);
+            pthread_mutex_unlock(&pvt->lock);
         }
     }
     _rtpp_stream_latch_sync(pvt, dtime->mono, packet);
+}
+
+/*
+ * Run authentication, latching and accounting logic over a single
+ * received packet. The *ppp is the snapshot the caller holds a reference
+ * to, the lock is only taken if the packet does not match it, in which
+ * case the *ppp is replaced with the up to date one. Returns
+ * the packet itself, NULL if the packet has been consumed by the
+ * resizer or RTPP_S_RX_DCONT if it has to be discarded, in which case
+ * the caller is responsible for releasing it.
+ */
+static struct rtp_packet *
+_rtpp_stream_rx_pkt(struct rtpp_stream_priv *pvt, struct rtpps_peer **ppp,
+  struct rtpp_weakref_obj *rtcps_wrt, const struct rtpp_timestamp *dtime,
+  struct rtpp_proc_rstats *rsp, struct rtp_packet *packet)
+{
+    struct rtpp_stream *self;
+    int rval;
+
+    self = &pvt->pub;
+    rsp->npkts_rcvd.cnt++;
+
+    if (!_rtpp_stream_rx_known(self, *ppp, packet)) {
+        pthread_mutex_lock(&pvt->lock);
+        rval = _rtpp_stream_rx_auth(pvt, rtcps_wrt, dtime, packet);
+        pthread_mutex_unlock(&pvt->lock);
+        if (rval != 0) {
+            /*
+             * Continue, since there could be good packets in
+             * queue.
+             */
+            CALL_METHOD(self->pcount, reg_ignr);
+            return (RTPP_S_RX_DCONT);
+        }
+        /* Whatever has been latched or filled in is for the next one */
+        RTPP_OBJ_DECREF(*ppp);
+        *ppp = _rtpp_stream_peer_get(pvt);
+    }
+    CALL_METHOD(self->pcnt_strm, reg_pktin, packet);
+    if (_rtpp_stream_police(pvt, packet) != 0) {
+        CALL_METHOD(self->pcount, reg_plcd);
+        rsp->npkts_policed.cnt++;
+        return (RTPP_S_RX_DCONT);
+    }
+    _rtpp_stream_rx_track(pvt, dtime, packet);
     if (self->resizer != NULL) {
         rtp_resizer_enqueue(self->resizer, &packet, rsp);
         if (packet == NULL) {
             rsp->npkts_resizer_in.cnt++;
         }
     }
-    pthread_mutex_unlock(&pvt->lock);
     return (packet);
+}
 
-discard_and_continue:
-    pthread_mutex_unlock(&pvt->lock);
-    RTPP_OBJ_DECREF(packet);
-    rsp->npkts_discard.cnt++;
-    return (RTPP_S_RX_DCONT);
+static struct rtp_packet *
+rtpp_stream_rx(struct rtpp_stream *self, struct rtpp_weakref_obj *rtcps_wrt,
+  const struct rtpp_timestamp *dtime, struct rtpp_proc_rstats *rsp)
+{
+    struct rtp_packet *packet = NULL, *rpacket;
+    struct rtpp_stream_priv *pvt;
+    struct rtpps_peer *pp;
+
+    PUB2PVT(self, pvt);
+    pp = _rtpp_stream_peer_get(pvt);
+    if (pp->fd != NULL)
+        packet = CALL_METHOD(pp->fd, rtp_recv, dtime, self->laddr, self->port);
+    if (packet == NULL) {
+        /* Move on to the next session */
+        RTPP_OBJ_DECREF(pp);
+        return (NULL);
+    }
+    rpacket = _rtpp_stream_rx_pkt(pvt, &pp, rtcps_wrt, dtime, rsp, packet);
+    RTPP_OBJ_DECREF(pp);
+    if (rpacket == RTPP_S_RX_DCONT) {
+        RTPP_OBJ_DECREF(packet);
+        rsp->npkts_discard.cnt++;
+    }
+    return (rpacket);
+}
+
+/*
+ * Batched version of the rx() method. On input pkts[] contains npkts
+ * pre-allocated packets, up to that many datagrams are received into
+ * them in one go. On return first N slots (return value) contain
+ * either the packet that has to be relayed, NULL if the packet has been
+ * consumed by the resizer or RTPP_S_RX_DCONT if it has been discarded.
+ * Slots past N are left intact.
+ */
+static int
+rtpp_stream_rx_batch(struct rtpp_stream *self, struct rtpp_weakref_obj *rtcps_wrt,
+  const struct rtpp_timestamp *dtime, struct rtpp_proc_rstats *rsp,
+  struct rtp_packet **pkts, int npkts)
+{
+    struct rtpp_stream_priv *pvt;
+    struct rtp_packet *packet;
+    struct rtpp_stream *stp_rtcp;
+    struct rtpps_peer *pp;
+    int i, nrcvd;
+
+    PUB2PVT(self, pvt);
+    stp_rtcp = NULL;
+    pp = _rtpp_stream_peer_get(pvt);
+    nrcvd = 0;
+    if (pp->fd != NULL)
+        nrcvd = CALL_METHOD(pp->fd, rtp_recvm, dtime, self->laddr,
+          self->port, pkts, npkts);
+    for (i = 0; i < nrcvd; i++) {
+        if (self->rtcp_mux != 0 && RTP_IS_RTCP_MUX(pkts[i]->data.buf,
+          pkts[i]->size)) {
+            if (stp_rtcp == NULL)
+                stp_rtcp = CALL_METHOD(rtcps_wrt, get_by_idx,
+                  self->stuid_rtcp);
+            if (stp_rtcp != NULL) {
+                packet = CALL_SMETHOD(stp_rtcp, rx_demux, NULL, dtime,
+                  rsp, pkts[i]);
+            } else {
+                rsp->npkts_rcvd.cnt++;
+                packet = RTPP_S_RX_DCONT;
+            }
+        } else {
+            packet = _rtpp_stream_rx_pkt(pvt, &pp, rtcps_wrt, dtime, rsp,
+              pkts[i]);
+        }
+        if (packet == RTPP_S_RX_DCONT) {
+            RTPP_OBJ_DECREF(pkts[i]);
+            rsp->npkts_discard.cnt++;
+        }
+        pkts[i] = packet;
+    }
+    RTPP_OBJ_DECREF(pp);
+    if (stp_rtcp != NULL)
+        RTPP_OBJ_DECREF(stp_rtcp);
+    return (nrcvd);
+}
+
+/*
+ * Run receive logic over a packet that came in on a socket that is not
+ * owned by this stream, i.e. the one RTCP stream shares with the RTP
+ * stream or the shared socket of the rtpp_demux. Return value is the same
+ * as for the rx_batch() slots.
+ */
+static struct rtp_packet *
+rtpp_stream_rx_demux(struct rtpp_stream *self,
+  struct rtpp_weakref_obj *rtcps_wrt, const struct rtpp_timestamp *dtime,
+  struct rtpp_proc_rstats *rsp, struct rtp_packet *packet)
+{
+    struct rtpp_stream_priv *pvt;
+    struct rtp_packet *rpacket;
+    struct rtpps_peer *pp;
+
+    PUB2PVT(self, pvt);
+    pp = _rtpp_stream_peer_get(pvt);
+    rpacket = _rtpp_stream_rx_pkt(pvt, &pp, rtcps_wrt, dtime, rsp, packet);
+    RTPP_OBJ_DECREF(pp);
+    return (rpacket);
 }
 
 static struct rtpp_netaddr *
@@ -968,3 +1441,341 @@ rtpp_stream_get_rem_addr(struct rtpp_stream *self, int retempty)
     pthread_mutex_unlock(&pvt->lock);
     return (rval);
 }
+
+/*
+ * In-kernel relaying (eBPF offload). Each stream owns the map entry keyed
+ * by its inbound flow, which rewrites packets into the outbound flow of
+ * the sending stream. The entry is (re)installed by the offload_sync()
+ * called periodically on streams of complete sessions and is removed or
+ * disabled right away by either side once there is a change that the
+ * kernel can't handle on its own: relatch or address update on either
+ * side, start of recording or playback.
+ */
+static int
+_rtpp_stream_offload_flow(struct rtpp_stream_priv *pvt,
+  struct rtpp_ebpf_flow *flp)
+{
+    struct sockaddr_storage raddr;
+    const struct sockaddr_in *lsin, *rsin;
+
+    if (pvt->fd == NULL || pvt->pub.laddr == NULL ||
+      pvt->pub.laddr->sa_family != AF_INET)
+        return (-1);
+    if (CALL_SMETHOD(pvt->rem_addr, isempty))
+        return (-1);
+    CALL_SMETHOD(pvt->rem_addr, get, sstosa(&raddr), sizeof(raddr));
+    if (raddr.ss_family != AF_INET)
+        return (-1);
+    lsin = satosin(pvt->pub.laddr);
+    rsin = satosin(&raddr);
+    if (lsin->sin_addr.s_addr == htonl(INADDR_ANY))
+        return (-1);
+    memset(flp, '\0', sizeof(*flp));
+    flp->saddr = rsin->sin_addr.s_addr;
+    flp->sport = rsin->sin_port;
+    flp->daddr = lsin->sin_addr.s_addr;
+    flp->dport = htons(pvt->pub.port);
+    return (0);
+}
+
+static int
+_rtpp_stream_offload_eligible(struct rtpp_stream_priv *pvt,
+  struct rtpp_ebpf_flow *flp)
+{
+
+    if (pvt->latch_info.latched == 0 || pvt->pub.asymmetric != 0)
+        return (0);
+    /* The kernel program does not tell RTCP from RTP */
+    if (pvt->pub.rtcp_mux != 0)
+        return (0);
+    if (pvt->pub.rrc != NULL || pvt->pub.resizer != NULL)
+        return (0);
+    /* Nor does it know anything about rate limits */
+    if (pvt->police.req != 0)
+        return (0);
+    return (_rtpp_stream_offload_flow(pvt, flp) == 0);
+}
+
+static void
+_rtpp_stream_offload_credit(struct rtpp_stream_priv *pvt,
+  const struct rtpp_ebpf_ent *ep)
+{
+    struct rtpp_timestamp dtime;
+    unsigned long npkts;
+
+    npkts = ep->npkts - pvt->ofld.ent.npkts;
+    pvt->ofld.ent.npkts = ep->npkts;
+    pvt->ofld.ent.nbytes = ep->nbytes;
+    if (npkts == 0)
+        return;
+    rtpp_timestamp_get(&dtime);
+    CALL_METHOD(pvt->pub.pcnt_strm, reg_npktin, npkts, &dtime);
+    CALL_METHOD(pvt->pub.pcount, reg_nreld, npkts);
+    CALL_METHOD(pvt->pub.ttl, reset);
+    CALL_SMETHOD(pvt->rtpp_stats, updatebyname, "npkts_rcvd", npkts);
+    CALL_SMETHOD(pvt->rtpp_stats, updatebyname, "npkts_relayed", npkts);
+    CALL_SMETHOD(pvt->rtpp_stats, updatebyname, "npkts_offloaded", npkts);
+}
+
+static void
+_rtpp_stream_offload_drop(struct rtpp_stream_priv *pvt)
+{
+    struct rtpp_ebpf_ent ent;
+
+    if (pvt->ofld.active == 0)
+        return;
+    if (rtpp_ebpf_lookup(pvt->ofld.ebpf, &pvt->ofld.key, &ent) == 0) {
+        rtpp_ebpf_delete(pvt->ofld.ebpf, &pvt->ofld.key);
+        _rtpp_stream_offload_credit(pvt, &ent);
+    }
+    pvt->ofld.active = 0;
+    memset(&pvt->ofld.ent, '\0', sizeof(pvt->ofld.ent));
+}
+
+static void
+_rtpp_stream_offload_reset(struct rtpp_stream_priv *pvt)
+{
+    struct rtpp_ebpf_ent ent;
+
+    _rtpp_stream_offload_drop(pvt);
+    if (pvt->ofld.ractive != 0) {
+        /*
+         * The entry is owned by the peer, disable it but leave counters
+         * in place for the peer to pick up.
+         */
+        if (rtpp_ebpf_lookup(pvt->ofld.ebpf, &pvt->ofld.rkey, &ent) == 0 &&
+          (ent.flags & RTPP_EBPF_F_DISABLED) == 0) {
+            ent.flags |= RTPP_EBPF_F_DISABLED;
+            rtpp_ebpf_update(pvt->ofld.ebpf, &pvt->ofld.rkey, &ent);
+        }
+        pvt->ofld.ractive = 0;
+    }
+}
+
+static void
+rtpp_stream_offload_reset(struct rtpp_stream *self)
+{
+    struct rtpp_stream_priv *pvt;
+
+    PUB2PVT(self, pvt);
+    pthread_mutex_lock(&pvt->lock);
+    _rtpp_stream_offload_reset(pvt);
+    pthread_mutex_unlock(&pvt->lock);
+}
+
+static void
+rtpp_stream_set_police(struct rtpp_stream *self, int pps, int kbps)
+{
+    struct rtpp_stream_priv *pvt;
+    uint64_t req;
+
+    PUB2PVT(self, pvt);
+    req = RTPPS_POLICE_REQ(pps, kbps);
+    pthread_mutex_lock(&pvt->lock);
+    if (pvt->police.req == req) {
+        pthread_mutex_unlock(&pvt->lock);
+        return;
+    }
+    /* Buckets are re-set by the rx path as it picks the new limits up */
+    pvt->police.req = req;
+    pthread_mutex_unlock(&pvt->lock);
+    if (pps != 0 || kbps != 0) {
+        RTPP_LOG(pvt->pub.log, RTPP_LOG_INFO, "%s's %s stream is limited to "
+          "%d packets/s, %d kbit/s (0 - no limit)", _rtpp_stream_get_actor(pvt),
+          _rtpp_stream_get_proto(pvt), pps, kbps);
+    }
+}
+
+/*
+ * Called periodically to fit the receive buffer to the packet rate seen
+ * on the stream. The buffer grows right away as the rate goes up or the
+ * kernel reports overflows on the socket, shrinks gradually and only after
+ * some time without any. RTCP rate is too low to be of any help, so its
+ * buffer only grows on overflows. With the resize unset only the kernel
+ * drop counts are picked up, the buffer is left alone.
+ */
+static void
+rtpp_stream_tune_rbuf(struct rtpp_stream *self, double dtime, int resize)
+{
+    struct rtpp_stream_priv *pvt;
+    struct rtpps_rbuf *rbp;
+    struct rtpp_pcnts_strm pst;
+    double pps;
+    uint64_t novflw;
+    int target, nsize, asize;
+
+    PUB2PVT(self, pvt);
+    /* Shared socket is managed by the RTP stream */
+    if (self->rtcp_mux != 0 && self->pipe_type == PIPE_RTCP)
+        return;
+    CALL_METHOD(self->pcnt_strm, get_stats, &pst);
+    pthread_mutex_lock(&pvt->lock);
+    if (pvt->fd == NULL)
+        goto out;
+    rbp = &pvt->rbuf;
+    /* Keep the kernel drop stats current, whether we resize or not */
+    novflw = _rtpp_stream_reg_kdrops(pvt, pvt->fd,
+      pst.nthrottled != rbp->nthrottled_last);
+    rbp->nthrottled_last = pst.nthrottled;
+    if (resize == 0) {
+        /* Start over once it's allowed, the rate seen so far is moot */
+        rbp->size = 0;
+        goto out;
+    }
+    /* Whatever is in effect, it might have been changed elsewhere */
+    asize = CALL_METHOD(pvt->fd, getrbuf);
+    if (asize <= 0)
+        goto out;
+    if (rbp->size == 0 || dtime <= rbp->last) {
+        rbp->size = asize;
+        rbp->npkts_last = pst.npkts_in;
+        rbp->last = dtime;
+        goto out;
+    }
+    pps = (double)(pst.npkts_in - rbp->npkts_last) / (dtime - rbp->last);
+    rbp->npkts_last = pst.npkts_in;
+    rbp->last = dtime;
+    rbp->size = asize;
+    /* Packets relayed in-kernel never make it into the socket queue */
+    if (pvt->ofld.active != 0)
+        pps = 0.0;
+    if (self->pipe_type == PIPE_RTP) {
+        target = MAX(MIN(pps * RBUF_WINDOW * RBUF_PKTCOST, MEDIA_RBUF_MAX),
+          MEDIA_RBUF_SIZE);
+    } else {
+        target = MEDIA_RBUF_RTCP;
+    }
+    nsize = rbp->size;
+    if (novflw > 0) {
+        nsize = MAX(nsize * 2, target);
+        rbp->hold = RBUF_HOLD;
+    } else if (target > nsize) {
+        while (nsize < target)
+            nsize *= 2;
+    } else if (rbp->hold > 0) {
+        rbp->hold -= 1;
+    } else if (target * 2 <= nsize) {
+        nsize /= 2;
+        rbp->hold = RBUF_SHRINK_IVAL;
+    }
+    nsize = MIN(nsize, MEDIA_RBUF_MAX);
+    if (rbp->limit > 0)
+        nsize = MIN(nsize, rbp->limit);
+    if (nsize == rbp->size)
+        goto out;
+    if (CALL_METHOD(pvt->fd, setrbuf, nsize) != 0 ||
+      (asize = CALL_METHOD(pvt->fd, getrbuf)) <= 0) {
+        RTPP_ELOG(self->log, RTPP_LOG_ERR, "unable to set %dK receive buffer "
+          "size", nsize / 1024);
+        goto out;
+    }
+    /* Capped by the system-wide limit, no point in asking for more */
+    if (asize < nsize)
+        rbp->limit = asize;
+    RTPP_LOG(self->log, RTPP_LOG_DBUG, "%s's %s receive buffer %dK -> %dK "
+      "(%.1f packets/s, %llu overflowed)", _rtpp_stream_get_actor(pvt),
+      _rtpp_stream_get_proto(pvt), rbp->size / 1024, asize / 1024, pps,
+      (unsigned long long)novflw);
+    rbp->size = asize;
+out:
+    pthread_mutex_unlock(&pvt->lock);
+}
+
+/*
+ * Called on the sending stream: check that packets relayed to it could go
+ * out bypassing us and fill in the outbound flow. The rkey is inbound flow
+ * of the entry that is going to be installed by the peer, we need it to
+ * disable that entry should anything change on our side.
+ */
+static int
+rtpp_stream_offload_target(struct rtpp_stream *self, struct rtpp_ebpf *ebpf,
+  const struct rtpp_ebpf_flow *rkey, struct rtpp_ebpf_flow *out)
+{
+    struct rtpp_stream_priv *pvt;
+    struct rtpp_ebpf_flow fl;
+
+    PUB2PVT(self, pvt);
+    pthread_mutex_lock(&pvt->lock);
+    if (pvt->rtps.uid != RTPP_UID_NONE ||
+      _rtpp_stream_offload_flow(pvt, &fl) != 0) {
+        pthread_mutex_unlock(&pvt->lock);
+        return (-1);
+    }
+    memset(out, '\0', sizeof(*out));
+    out->saddr = fl.daddr;
+    out->sport = fl.dport;
+    out->daddr = fl.saddr;
+    out->dport = fl.sport;
+    pvt->ofld.ebpf = ebpf;
+    pvt->ofld.rkey = *rkey;
+    pvt->ofld.ractive = 1;
+    pthread_mutex_unlock(&pvt->lock);
+    return (0);
+}
+
+static void
+rtpp_stream_offload_sync(struct rtpp_stream *self, struct rtpp_stream *sender,
+  struct rtpp_ebpf *ebpf)
+{
+    struct rtpp_stream_priv *pvt;
+    struct rtpp_ebpf_flow key, nkey, out;
+    struct rtpp_ebpf_ent ent;
+    int eligible, relaying;
+
+    PUB2PVT(self, pvt);
+    relaying = 0;
+    pthread_mutex_lock(&pvt->lock);
+    eligible = _rtpp_stream_offload_eligible(pvt, &key);
+    pthread_mutex_unlock(&pvt->lock);
+    if (eligible && CALL_SMETHOD(sender, offload_target, ebpf, &key,
+      &out) != 0)
+        eligible = 0;
+
+    pthread_mutex_lock(&pvt->lock);
+    pvt->ofld.ebpf = ebpf;
+    /* Things might have changed while the lock was released */
+    if (eligible && (!_rtpp_stream_offload_eligible(pvt, &nkey) ||
+      memcmp(&key, &nkey, sizeof(key)) != 0))
+        eligible = 0;
+    if (pvt->ofld.active != 0) {
+        if (rtpp_ebpf_lookup(ebpf, &pvt->ofld.key, &ent) != 0) {
+            pvt->ofld.active = 0;
+            memset(&pvt->ofld.ent, '\0', sizeof(pvt->ofld.ent));
+        } else {
+            _rtpp_stream_offload_credit(pvt, &ent);
+            if (!eligible || memcmp(&key, &pvt->ofld.key, sizeof(key)) != 0) {
+                _rtpp_stream_offload_drop(pvt);
+            } else if (ent.flags == 0) {
+                relaying = 1;
+                /* Up to date? */
+                if (memcmp(&ent.out, &out, sizeof(out)) == 0)
+                    eligible = 0;
+            }
+        }
+    }
+    if (eligible && relaying == 0) {
+        /*
+         * Don't let in-kernel relaying overtake packets that are still
+         * waiting to be processed by us, wait until the queue is drained.
+         */
+        if (CALL_METHOD(pvt->fd, rx_backlog) > 0)
+            eligible = 0;
+    }
+    if (eligible) {
+        ent = pvt->ofld.ent;
+        ent.out = out;
+        ent.flags = 0;
+        if (rtpp_ebpf_update(ebpf, &key, &ent) == 0) {
+            if (pvt->ofld.active == 0) {
+                RTPP_LOG(pvt->pub.log, RTPP_LOG_DBUG, "%s's %s stream is "
+                  "now relayed in-kernel", _rtpp_stream_get_actor(pvt),
+                  _rtpp_stream_get_proto(pvt));
+            }
+            pvt->ofld.active = 1;
+            pvt->ofld.key = key;
+            pvt->ofld.ent = ent;
+        }
+    }
+    pthread_mutex_unlock(&pvt->lock);
+}
+
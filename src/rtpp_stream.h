@@ -45,6 +45,8 @@ struct sthread_args;
 struct rtpp_acct_hold;
 struct rtpp_proc_rstats;
 struct rtpp_timestamp;
+struct rtpp_ebpf;
+struct rtpp_ebpf_flow;
 
 DEFINE_METHOD(rtpp_stream, rtpp_stream_handle_play, int, const char *,
   const char *, int, struct rtpp_command *, int);
@@ -70,13 +72,30 @@ DEFINE_METHOD(rtpp_stream, rtpp_stream_get_stats, void,
   struct rtpp_acct_hold *);
 DEFINE_METHOD(rtpp_stream, rtpp_stream_rx, struct rtp_packet *,
   struct rtpp_weakref_obj *, const struct rtpp_timestamp *, struct rtpp_proc_rstats *);
+DEFINE_METHOD(rtpp_stream, rtpp_stream_rx_batch, int,
+  struct rtpp_weakref_obj *, const struct rtpp_timestamp *, struct rtpp_proc_rstats *,
+  struct rtp_packet **, int);
+DEFINE_METHOD(rtpp_stream, rtpp_stream_rx_demux, struct rtp_packet *,
+  struct rtpp_weakref_obj *, const struct rtpp_timestamp *,
+  struct rtpp_proc_rstats *, struct rtp_packet *);
 DEFINE_METHOD(rtpp_stream, rtpp_stream_get_rem_addr, struct rtpp_netaddr *,
   int);
+DEFINE_METHOD(rtpp_stream, rtpp_stream_offload_sync, void,
+  struct rtpp_stream *, struct rtpp_ebpf *);
+DEFINE_METHOD(rtpp_stream, rtpp_stream_offload_target, int,
+  struct rtpp_ebpf *, const struct rtpp_ebpf_flow *, struct rtpp_ebpf_flow *);
+DEFINE_METHOD(rtpp_stream, rtpp_stream_offload_reset, void);
+DEFINE_METHOD(rtpp_stream, rtpp_stream_set_police, void, int, int);
+DEFINE_METHOD(rtpp_stream, rtpp_stream_tune_rbuf, void, double, int);
 
 enum rtpp_stream_side {RTPP_SSIDE_CALLER = 1, RTPP_SSIDE_CALLEE = 0};
 
 #define RTPP_S_RX_DCONT (void *)((char *)NULL + 1)
 
+/* Upper limits on the ingress rate policing parameters */
+#define RTPP_POLICE_PPS_MAX	1000000
+#define RTPP_POLICE_KBPS_MAX	10000000
+
 struct rtpp_stream_smethods {
     /* Static methods */
     METHOD_ENTRY(rtpp_stream_handle_play, handle_play);
@@ -96,48 +115,66 @@ struct rtpp_stream_smethods {
     METHOD_ENTRY(rtpp_stream_reg_onhold, reg_onhold);
     METHOD_ENTRY(rtpp_stream_get_stats, get_stats);
     METHOD_ENTRY(rtpp_stream_rx, rx);
+    METHOD_ENTRY(rtpp_stream_rx_batch, rx_batch);
+    METHOD_ENTRY(rtpp_stream_rx_demux, rx_demux);
     METHOD_ENTRY(rtpp_stream_get_rem_addr, get_rem_addr);
+    METHOD_ENTRY(rtpp_stream_offload_sync, offload_sync);
+    METHOD_ENTRY(rtpp_stream_offload_target, offload_target);
+    METHOD_ENTRY(rtpp_stream_offload_reset, offload_reset);
+    METHOD_ENTRY(rtpp_stream_set_police, set_police);
+    METHOD_ENTRY(rtpp_stream_tune_rbuf, tune_rbuf);
 };
 
 struct rtpp_stream {
+    /*
+     * Members used by the rx/tx path for every packet go first, so that
+     * they share the first two cache lines of the object, see the
+     * RTPP_LAYOUT_FITS() checks in the rtpp_stream.c.
+     */
+    /* Public methods */
+    const struct rtpp_stream_smethods *smethods;
+    /* Refcounter */
+    struct rtpp_refcnt *rcnt;
     /* ttl for stream */
     struct rtpp_ttl *ttl;
+    /* Copy of the per-pipe counters */
+    struct rtpp_pcount *pcount;
+    /* Per-stream counters */
+    struct rtpp_pcnt_strm *pcnt_strm;
+    /* Pointer to rtpp_record's opaque data type */
+    struct rtpp_record *rrc;
+    struct rtp_resizer *resizer;
+    struct rtpp_analyzer *analyzer;
+    struct rtpp_log *log;
     /* Local listen address/port */
     const struct sockaddr *laddr;
     int port;
     int asymmetric;
+    /*
+     * RTP and RTCP share the same socket (RFC 5761), set by the sessinfo
+     * when the socket is attached
+     */
+    int rtcp_mux;
+    /* Type of pipe we are associated with, read-only */
+    int pipe_type;
+    /* UID of the associated "RTCP" stream, read-only */
+    uint64_t stuid_rtcp;
+    /* Everything below is only used by the control path */
     enum rtpp_stream_side side;
     /* Flags: strong create/delete; weak ones */
     int weak;
-    /* Pointer to rtpp_record's opaque data type */
-    struct rtpp_record *rrc;
-    struct rtp_resizer *resizer;
-    struct rtpp_analyzer *analyzer;
     /* Supported codecs */
     char *codecs;
     /* Requested ptime */
     int ptime;
-    /* Refcounter */
-    struct rtpp_refcnt *rcnt;
     /* UID, read-only */
     uint64_t stuid;
     /* UID of the session we belong to, read-only */
     uint64_t seuid;
     /* UID of the associated "sending" stream, read-only */
     uint64_t stuid_sendr;
-    /* UID of the associated "RTCP" stream, read-only */
-    uint64_t stuid_rtcp;
     /* UID of the associated "RTP" stream, read-only */
     uint64_t stuid_rtp;
-    /* Type of pipe we are associated with, read-only */
-    int pipe_type;
-    struct rtpp_log *log;
-    /* Copy of the per-pipe counters */
-    struct rtpp_pcount *pcount;
-    /* Per-stream counters */
-    struct rtpp_pcnt_strm *pcnt_strm;
-    /* Public methods */
-    const struct rtpp_stream_smethods *smethods;
 };
 
 struct rtpp_stream *rtpp_stream_ctor(struct rtpp_log *,
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "rtpp_tbucket.h"
+
+void
+rtpp_tbucket_init(struct rtpp_tbucket *tbp, double rate, double depth)
+{
+
+    tbp->rate = rate;
+    tbp->depth = depth;
+    tbp->tokens = depth;
+    tbp->last = 0.0;
+}
+
+/*
+ * Refill the bucket up to the time "now" and check if there are ntokens
+ * in it. Returns 1 if there are, 0 otherwise. Nothing is taken out, so
+ * that the packet can be checked against several buckets before it is
+ * charged to any of them with rtpp_tbucket_debit().
+ */
+int
+rtpp_tbucket_check(struct rtpp_tbucket *tbp, double ntokens, double now)
+{
+
+    if (tbp->rate == 0.0)
+        return (1);
+    if (now > tbp->last) {
+        if (tbp->last != 0.0) {
+            tbp->tokens += (now - tbp->last) * tbp->rate;
+            if (tbp->tokens > tbp->depth)
+                tbp->tokens = tbp->depth;
+        }
+        tbp->last = now;
+    }
+    return (tbp->tokens >= ntokens);
+}
+
+void
+rtpp_tbucket_debit(struct rtpp_tbucket *tbp, double ntokens)
+{
+
+    if (tbp->rate == 0.0)
+        return;
+    tbp->tokens -= ntokens;
+}
+
+#if defined(rtpp_tbucket_selftest)
+#include <assert.h>
+
+int
+rtpp_tbucket_selftest(void)
+{
+    struct rtpp_tbucket pkts, bytes;
+
+    /* No limit */
+    rtpp_tbucket_init(&pkts, 0.0, 1.0);
+    assert(rtpp_tbucket_check(&pkts, 1e9, 1.0) == 1);
+    rtpp_tbucket_debit(&pkts, 1e9);
+    assert(rtpp_tbucket_check(&pkts, 1e9, 1.0) == 1);
+
+    /* Full at start, empty after depth tokens, refills at rate */
+    rtpp_tbucket_init(&pkts, 128.0, 32.0);
+    assert(rtpp_tbucket_check(&pkts, 32.0, 10.0) == 1);
+    assert(rtpp_tbucket_check(&pkts, 33.0, 10.0) == 0);
+    rtpp_tbucket_debit(&pkts, 32.0);
+    assert(rtpp_tbucket_check(&pkts, 1.0, 10.0) == 0);
+    assert(rtpp_tbucket_check(&pkts, 1.0, 10.0 + 0.5 / 128.0) == 0);
+    assert(rtpp_tbucket_check(&pkts, 1.0, 10.0 + 1.0 / 128.0) == 1);
+    /* Time going backwards adds nothing */
+    rtpp_tbucket_debit(&pkts, 1.0);
+    assert(rtpp_tbucket_check(&pkts, 1.0, 9.0) == 0);
+    /* Never more than depth */
+    assert(rtpp_tbucket_check(&pkts, 32.0, 1000.0) == 1);
+    assert(rtpp_tbucket_check(&pkts, 32.5, 1000.0) == 0);
+
+    /*
+     * A packet that fails the second bucket must not be charged to the
+     * first one.
+     */
+    rtpp_tbucket_init(&pkts, 50.0, 2.0);
+    rtpp_tbucket_init(&bytes, 1000.0, 300.0);
+    assert(rtpp_tbucket_check(&pkts, 1.0, 1.0) &&
+      rtpp_tbucket_check(&bytes, 200.0, 1.0));
+    rtpp_tbucket_debit(&pkts, 1.0);
+    rtpp_tbucket_debit(&bytes, 200.0);
+    assert(rtpp_tbucket_check(&pkts, 1.0, 1.0) == 1);
+    assert(rtpp_tbucket_check(&bytes, 200.0, 1.0) == 0);
+    assert(rtpp_tbucket_check(&pkts, 1.0, 1.0) == 1);
+    assert(rtpp_tbucket_check(&pkts, 2.0, 1.0) == 0);
+    assert(rtpp_tbucket_check(&bytes, 100.0, 1.0) == 1);
+
+    return (0);
+}
+#endif /* rtpp_tbucket_selftest */
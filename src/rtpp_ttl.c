@@ -49,6 +49,15 @@ static void rtpp_ttl_reset_with(struct rtpp_ttl *, int);
 static int rtpp_ttl_get_remaining(struct rtpp_ttl *);
 static int rtpp_ttl_decr(struct rtpp_ttl *);
 
+#if defined(RTPP_STATIC_DISPATCH)
+const struct rtpp_ttl rtpp_ttl_methods = {
+    .reset = &rtpp_ttl_reset,
+    .reset_with = &rtpp_ttl_reset_with,
+    .get_remaining = &rtpp_ttl_get_remaining,
+    .decr = &rtpp_ttl_decr
+};
+#endif
+
 struct rtpp_ttl *
 rtpp_ttl_ctor(int max_ttl)
 {
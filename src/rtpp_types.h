@@ -41,8 +41,35 @@ struct rtpp_type_linkable {
 #define DEFINE_METHOD(class, func, rval, args...) typedef rval (*func##_t)(struct class *, ## args)
 #define DEFINE_RAW_METHOD(func, rval, args...) typedef rval (*func##_t)(args)
 #define METHOD_ENTRY(func, epname) func##_t epname
+#if defined(RTPP_STATIC_DISPATCH) && !defined(RTPP_DEBUG)
+/*
+ * Classes that only have a single implementation get their methods
+ * resolved at build time from the table exported by the implementation,
+ * so that the compiler can call them directly and inline them (with the
+ * LTO) on the packet path. Anything else is dispatched via the object
+ * as usual, this includes rtpp_socket, which has a separate demux
+ * implementation and picks its receive methods per instance. Not used in the debug builds, which rely on the finalizers
+ * replacing methods of the destroyed objects to catch use after free.
+ */
+extern const struct rtpp_stream_smethods rtpp_stream_smethods;
+extern const struct rtpp_netaddr_smethods rtpp_netaddr_smethods;
+extern const struct rtpp_refcnt_smethods rtpp_refcnt_smethods;
+extern const struct rtpp_pcount rtpp_pcount_methods;
+extern const struct rtpp_ttl rtpp_ttl_methods;
+
+#define CALL_METHOD(obj, method, args...) _Generic((obj), \
+  struct rtpp_pcount *: &rtpp_pcount_methods, \
+  struct rtpp_ttl *: &rtpp_ttl_methods, \
+  default: (obj))->method(obj, ## args)
+#define CALL_SMETHOD(obj, method, args...) _Generic((obj), \
+  struct rtpp_stream *: &rtpp_stream_smethods, \
+  struct rtpp_netaddr *: &rtpp_netaddr_smethods, \
+  struct rtpp_refcnt *: &rtpp_refcnt_smethods, \
+  default: (obj)->smethods)->method(obj, ## args)
+#else
 #define CALL_METHOD(obj, method, args...) (obj)->method(obj, ## args)
 #define CALL_SMETHOD(obj, method, args...) (obj)->smethods->method(obj, ## args)
+#endif
 
 #define PVT_RCOFFS(pvt) (size_t)(&(((typeof(pvt))NULL)->pub.rcnt))
 
@@ -51,6 +78,17 @@ struct rtpp_type_linkable {
 
 #define CONST(p) ((const typeof(*p) *)(p))
 
+#define RTPP_CACHE_LINE 64
+
+/*
+ * Build-time layout check: fail if the member of the type and everything
+ * that precedes it no longer fit into the first nlines cache lines.
+ */
+#define RTPP_LAYOUT_FITS(type, member, nlines) \
+  _Static_assert(offsetof(type, member) + sizeof(((type *)NULL)->member) <= \
+  (nlines) * RTPP_CACHE_LINE, #type ": " #member " is not within first " \
+  #nlines " cache line(s)")
+
 #define RTPP_OBJ_INCREF(obj) RC_INCREF((obj)->rcnt)
 #define RTPP_OBJ_DECREF(obj) RC_DECREF((obj)->rcnt)
 
@@ -0,0 +1,924 @@
+/*
+ * Copyright (c) 2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#if HAVE_LINUX_IO_URING_H
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <unistd.h>
+#endif
+
+#include "rtpp_types.h"
+#include "rtpp_refcnt.h"
+#include "rtpp_mallocs.h"
+#include "rtpp_time.h"
+#include "rtpp_network_io.h"
+#include "rtp.h"
+#include "rtp_packet.h"
+#include "rtpp_uring.h"
+
+#if HAVE_LINUX_IO_URING_H && HAVE_RECVMMSG && defined(__NR_io_uring_setup)
+/*
+ * Minimal io_uring(7) submission/completion ring, driven through the raw
+ * system calls. It has two users: each async sender thread has one to push
+ * batches of datagrams out (rtpp_uring_ctor()), and each forwarding worker
+ * has one behind its struct rtpp_uring_rx to run the multishot receives on
+ * its sockets (rtpp_uring_rx_ctor()). Either way the ring belongs to that
+ * single thread, which is the only one to submit and reap, so there is no
+ * locking here.
+ */
+struct rtpp_uring {
+    int fd;
+    unsigned int sq_entries;
+    unsigned int sq_npend;
+    void *sq_ring;
+    size_t sq_ring_sz;
+    void *cq_ring;
+    size_t cq_ring_sz;
+    struct io_uring_sqe *sqes;
+    size_t sqes_sz;
+    _Atomic unsigned int *sq_head;
+    _Atomic unsigned int *sq_tail;
+    _Atomic unsigned int *sq_flags;
+    unsigned int *sq_mask;
+    _Atomic unsigned int *cq_head;
+    _Atomic unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+#define RING_PTR(base, off) ((void *)((char *)(base) + (off)))
+
+static struct rtpp_uring *
+rtpp_uring_setup(unsigned int entries, unsigned int cq_entries)
+{
+    struct rtpp_uring *rp;
+    struct io_uring_params p;
+    unsigned int *sq_array, i;
+
+    rp = rtpp_zmalloc(sizeof(*rp));
+    if (rp == NULL)
+        goto e0;
+    memset(&p, '\0', sizeof(p));
+    if (cq_entries > 0) {
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = cq_entries;
+    }
+    rp->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (rp->fd < 0)
+        goto e1;
+    rp->sq_entries = p.sq_entries;
+    rp->sq_ring_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    rp->cq_ring_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (rp->cq_ring_sz > rp->sq_ring_sz)
+            rp->sq_ring_sz = rp->cq_ring_sz;
+        rp->cq_ring_sz = 0;
+    }
+    rp->sq_ring = mmap(NULL, rp->sq_ring_sz, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, rp->fd, IORING_OFF_SQ_RING);
+    if (rp->sq_ring == MAP_FAILED)
+        goto e2;
+    if (rp->cq_ring_sz == 0) {
+        rp->cq_ring = rp->sq_ring;
+    } else {
+        rp->cq_ring = mmap(NULL, rp->cq_ring_sz, PROT_READ | PROT_WRITE,
+          MAP_SHARED | MAP_POPULATE, rp->fd, IORING_OFF_CQ_RING);
+        if (rp->cq_ring == MAP_FAILED)
+            goto e3;
+    }
+    rp->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+    rp->sqes = mmap(NULL, rp->sqes_sz, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, rp->fd, IORING_OFF_SQES);
+    if (rp->sqes == MAP_FAILED)
+        goto e4;
+
+    rp->sq_head = RING_PTR(rp->sq_ring, p.sq_off.head);
+    rp->sq_tail = RING_PTR(rp->sq_ring, p.sq_off.tail);
+    rp->sq_flags = RING_PTR(rp->sq_ring, p.sq_off.flags);
+    rp->sq_mask = RING_PTR(rp->sq_ring, p.sq_off.ring_mask);
+    rp->cq_head = RING_PTR(rp->cq_ring, p.cq_off.head);
+    rp->cq_tail = RING_PTR(rp->cq_ring, p.cq_off.tail);
+    rp->cq_mask = RING_PTR(rp->cq_ring, p.cq_off.ring_mask);
+    rp->cqes = RING_PTR(rp->cq_ring, p.cq_off.cqes);
+    /* SQE slots are always consumed in order, map them 1:1 */
+    sq_array = RING_PTR(rp->sq_ring, p.sq_off.array);
+    for (i = 0; i < p.sq_entries; i++)
+        sq_array[i] = i;
+    return (rp);
+
+e4:
+    if (rp->cq_ring != rp->sq_ring)
+        munmap(rp->cq_ring, rp->cq_ring_sz);
+e3:
+    munmap(rp->sq_ring, rp->sq_ring_sz);
+e2:
+    close(rp->fd);
+e1:
+    free(rp);
+e0:
+    return (NULL);
+}
+
+struct rtpp_uring *
+rtpp_uring_ctor(unsigned int entries)
+{
+
+    return (rtpp_uring_setup(entries, 0));
+}
+
+void
+rtpp_uring_dtor(struct rtpp_uring *rp)
+{
+
+    munmap(rp->sqes, rp->sqes_sz);
+    if (rp->cq_ring != rp->sq_ring)
+        munmap(rp->cq_ring, rp->cq_ring_sz);
+    munmap(rp->sq_ring, rp->sq_ring_sz);
+    close(rp->fd);
+    free(rp);
+}
+
+static int
+rtpp_uring_enter(struct rtpp_uring *rp, unsigned int to_submit,
+  unsigned int min_complete)
+{
+    int rval;
+
+    do {
+        rval = syscall(__NR_io_uring_enter, rp->fd, to_submit, min_complete,
+          IORING_ENTER_GETEVENTS, NULL, 0);
+    } while (rval < 0 && errno == EINTR);
+    return (rval);
+}
+
+/*
+ * Submit sendmsg(2) for each message and wait for all of them to complete,
+ * the result of each operation is stored into its res field. Consecutive
+ * messages for the same socket are chained (IOSQE_IO_LINK), so that each
+ * one is only issued once the previous one has completed and, should it
+ * fail, the rest of the chain completes with -ECANCELED instead of
+ * overtaking it. Chains never span two submissions, the caller is
+ * expected to group messages by socket and to size the ring to fit the
+ * whole batch. Returns -1 if the ring itself has failed, in which case
+ * state of the messages is undefined.
+ */
+int
+rtpp_uring_sendmsgs(struct rtpp_uring *rp, struct rtpp_uring_msg *msgs,
+  int nmsgs)
+{
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe *cqe;
+    struct rtpp_uring_msg *mp;
+    unsigned int tail, head, n, i, nsub, ndone;
+    int done, rval;
+
+    for (done = 0; done < nmsgs; done += n) {
+        n = nmsgs - done;
+        if (n > rp->sq_entries)
+            n = rp->sq_entries;
+        tail = atomic_load_explicit(rp->sq_tail, memory_order_relaxed);
+        for (i = 0; i < n; i++) {
+            mp = &msgs[done + i];
+            sqe = &rp->sqes[(tail + i) & *rp->sq_mask];
+            memset(sqe, '\0', sizeof(*sqe));
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = mp->sock;
+            sqe->addr = (uintptr_t)&mp->msg;
+            sqe->len = 1;
+            sqe->msg_flags = mp->flags | MSG_DONTWAIT;
+            sqe->user_data = done + i;
+            if (i + 1 < n && msgs[done + i + 1].sock == mp->sock)
+                sqe->flags = IOSQE_IO_LINK;
+        }
+        atomic_store_explicit(rp->sq_tail, tail + n, memory_order_release);
+
+        for (nsub = ndone = 0; ndone < n;) {
+            rval = rtpp_uring_enter(rp, n - nsub, 1);
+            if (rval < 0)
+                return (-1);
+            nsub += rval;
+            head = atomic_load_explicit(rp->cq_head, memory_order_relaxed);
+            while (head != atomic_load_explicit(rp->cq_tail,
+              memory_order_acquire)) {
+                cqe = &rp->cqes[head & *rp->cq_mask];
+                msgs[cqe->user_data].res = cqe->res;
+                head++;
+                ndone++;
+            }
+            atomic_store_explicit(rp->cq_head, head, memory_order_release);
+        }
+    }
+    return (nmsgs);
+}
+/*
+ * Receive side: one multishot recvmsg(2) request per socket, datagrams are
+ * placed by the kernel straight into rtp_packet buffers taken from the
+ * provided buffer ring. Each buffer starts RTPP_URING_RXHDR bytes ahead of
+ * the packet's data.buf, so that the io_uring_recvmsg_out header, source
+ * address and control messages land in the _laddr storage right in front
+ * of it and the payload needs no copying.
+ */
+#define RTPP_URING_BGID		0
+#define RTPP_URING_NAMELEN	sizeof(struct sockaddr_in6)
+#define RTPP_URING_CTRLLEN	(CMSG_SPACE(sizeof(struct timeval)) + \
+  CMSG_SPACE(sizeof(struct sockaddr_in6)))
+#define RTPP_URING_RXHDR	(sizeof(struct io_uring_recvmsg_out) + \
+  RTPP_URING_NAMELEN + RTPP_URING_CTRLLEN)
+
+_Static_assert(offsetof(struct rtp_packet, data) ==
+  offsetof(struct rtp_packet, _laddr) + sizeof(((struct rtp_packet *)0)->_laddr),
+  "rtp_packet: _laddr has to immediately precede data");
+_Static_assert(RTPP_URING_RXHDR <= sizeof(((struct rtp_packet *)0)->_laddr),
+  "RTPP_URING_RXHDR does not fit into rtp_packet._laddr");
+_Static_assert(RTPP_URING_CTRLLEN % sizeof(uint64_t) == 0 &&
+  offsetof(struct rtp_packet, data) % sizeof(uint64_t) == 0,
+  "control messages have to be aligned");
+
+#define RXBUF_BASE(pkt)	((unsigned char *)(pkt)->data.buf - RTPP_URING_RXHDR)
+
+/* user_data of the requests whose completions are of no interest */
+#define RTPP_URING_UD_NONE	0
+
+struct rtpp_uring_rx {
+    struct rtpp_uring *ring;
+    struct io_uring_buf_ring *br;
+    size_t br_sz;
+    unsigned int nbufs;
+    /* Packet backing each of the buffer IDs, NULL if yet to be refilled */
+    struct rtp_packet **pkts;
+    unsigned int nmissing;
+    /* Clean packets to refill the buffer ring from */
+    struct rtp_packet *spare;
+    unsigned int nspare;
+    /* Template for all multishot requests, only lengths are used */
+    struct msghdr mhdr;
+    /* All queues, queues that have packets and ones waiting to be armed */
+    struct rtpp_uring_rxq *all;
+    struct rtpp_uring_rxq *ready;
+    struct rtpp_uring_rxq *toarm;
+};
+
+struct rtpp_uring_rxq {
+    struct rtpp_uring_rx *urx;
+    int fd;
+    struct rtpp_refcnt *rcnt;
+    void *owner;
+    int idx;
+    /* Cleared by rtpp_uring_rx_del(), the rest is up to the completions */
+    int live;
+    int armed;
+    int onready;
+    int ontoarm;
+    struct rtp_packet *head;
+    struct rtp_packet *tail;
+    int len;
+    struct rtpp_uring_rxq *prev;
+    struct rtpp_uring_rxq *next;
+    struct rtpp_uring_rxq *rnext;
+    struct rtpp_uring_rxq *anext;
+};
+
+static struct io_uring_sqe *
+rtpp_uring_get_sqe(struct rtpp_uring *rp)
+{
+    struct io_uring_sqe *sqe;
+    unsigned int tail;
+
+    tail = atomic_load_explicit(rp->sq_tail, memory_order_relaxed);
+    if (tail - atomic_load_explicit(rp->sq_head, memory_order_acquire) >=
+      rp->sq_entries)
+        return (NULL);
+    sqe = &rp->sqes[tail & *rp->sq_mask];
+    memset(sqe, '\0', sizeof(*sqe));
+    return (sqe);
+}
+
+static void
+rtpp_uring_put_sqe(struct rtpp_uring *rp)
+{
+    unsigned int tail;
+
+    tail = atomic_load_explicit(rp->sq_tail, memory_order_relaxed);
+    atomic_store_explicit(rp->sq_tail, tail + 1, memory_order_release);
+    rp->sq_npend++;
+}
+
+/*
+ * Pass queued SQEs on to the kernel, without waiting for anything. The
+ * completions are posted asynchronously, so the system call is skipped
+ * altogether unless there is something to submit or the kernel asks for
+ * it (i.e. to flush overflown completions).
+ */
+static int
+rtpp_uring_flush(struct rtpp_uring *rp)
+{
+    unsigned int kflags;
+    int rval;
+
+    kflags = atomic_load_explicit(rp->sq_flags, memory_order_relaxed);
+    if (rp->sq_npend == 0 &&
+      (kflags & (IORING_SQ_CQ_OVERFLOW | IORING_SQ_TASKRUN)) == 0)
+        return (0);
+    rval = rtpp_uring_enter(rp, rp->sq_npend, 0);
+    if (rval < 0)
+        return (-1);
+    rp->sq_npend -= rval;
+    return (rval);
+}
+
+static void
+rtpp_uring_rx_putbuf(struct rtpp_uring_rx *urx, unsigned int bid)
+{
+    struct io_uring_buf *bp;
+    unsigned short tail;
+
+    tail = urx->br->tail;
+    bp = &urx->br->bufs[tail & (urx->nbufs - 1)];
+    bp->addr = (uintptr_t)RXBUF_BASE(urx->pkts[bid]);
+    bp->len = RTPP_URING_RXHDR + sizeof(urx->pkts[bid]->data.buf);
+    bp->bid = bid;
+    atomic_store_explicit((_Atomic unsigned short *)&urx->br->tail,
+      tail + 1, memory_order_release);
+}
+
+static struct rtp_packet *
+rtpp_uring_rx_getspare(struct rtpp_uring_rx *urx)
+{
+    struct rtp_packet *pkt;
+
+    pkt = urx->spare;
+    if (pkt == NULL)
+        return (rtp_packet_alloc());
+    urx->spare = pkt->next;
+    urx->nspare--;
+    pkt->next = NULL;
+    return (pkt);
+}
+
+static void
+rtpp_uring_rx_putspare(struct rtpp_uring_rx *urx, struct rtp_packet *pkt)
+{
+
+    if (urx->nspare >= urx->nbufs) {
+        RTPP_OBJ_DECREF(pkt);
+        return;
+    }
+    pkt->next = urx->spare;
+    urx->spare = pkt;
+    urx->nspare++;
+}
+
+/* Put a packet back into every slot whose buffer has been used up */
+static void
+rtpp_uring_rx_refill(struct rtpp_uring_rx *urx)
+{
+    unsigned int bid;
+
+    for (bid = 0; urx->nmissing > 0 && bid < urx->nbufs; bid++) {
+        if (urx->pkts[bid] != NULL)
+            continue;
+        urx->pkts[bid] = rtpp_uring_rx_getspare(urx);
+        if (urx->pkts[bid] == NULL)
+            break;
+        rtpp_uring_rx_putbuf(urx, bid);
+        urx->nmissing--;
+    }
+}
+
+struct rtpp_uring_rx *
+rtpp_uring_rx_ctor(unsigned int nbufs)
+{
+    struct rtpp_uring_rx *urx;
+    struct io_uring_buf_reg reg;
+    unsigned int bid;
+
+    /* Buffer ring size has to be a power of 2 */
+    if (nbufs == 0 || nbufs > 32768 || (nbufs & (nbufs - 1)) != 0) {
+        errno = EINVAL;
+        goto e0;
+    }
+    urx = rtpp_zmalloc(sizeof(*urx));
+    if (urx == NULL)
+        goto e0;
+    urx->nbufs = nbufs;
+    urx->pkts = rtpp_zmalloc(nbufs * sizeof(urx->pkts[0]));
+    if (urx->pkts == NULL)
+        goto e1;
+    urx->ring = rtpp_uring_setup(nbufs, nbufs * 4);
+    if (urx->ring == NULL)
+        goto e2;
+    urx->br_sz = nbufs * sizeof(struct io_uring_buf);
+    urx->br = mmap(NULL, urx->br_sz, PROT_READ | PROT_WRITE,
+      MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (urx->br == MAP_FAILED)
+        goto e3;
+    memset(&reg, '\0', sizeof(reg));
+    reg.ring_addr = (uintptr_t)urx->br;
+    reg.ring_entries = nbufs;
+    reg.bgid = RTPP_URING_BGID;
+    if (syscall(__NR_io_uring_register, urx->ring->fd,
+      IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+        goto e4;
+    for (bid = 0; bid < nbufs; bid++) {
+        urx->pkts[bid] = rtp_packet_alloc();
+        if (urx->pkts[bid] == NULL)
+            goto e5;
+        rtpp_uring_rx_putbuf(urx, bid);
+    }
+    urx->mhdr.msg_namelen = RTPP_URING_NAMELEN;
+    urx->mhdr.msg_controllen = RTPP_URING_CTRLLEN;
+    return (urx);
+
+e5:
+    for (bid = 0; bid < nbufs && urx->pkts[bid] != NULL; bid++)
+        RTPP_OBJ_DECREF(urx->pkts[bid]);
+e4:
+    munmap(urx->br, urx->br_sz);
+e3:
+    rtpp_uring_dtor(urx->ring);
+e2:
+    free(urx->pkts);
+e1:
+    free(urx);
+e0:
+    return (NULL);
+}
+
+static void
+rtpp_uring_rxq_flush(struct rtpp_uring_rxq *q)
+{
+    struct rtp_packet *pkt;
+
+    while (q->head != NULL) {
+        pkt = q->head;
+        q->head = pkt->next;
+        pkt->next = NULL;
+        RTPP_OBJ_DECREF(pkt);
+    }
+    q->tail = NULL;
+    q->len = 0;
+}
+
+/* Release the queue once nothing refers to it anymore */
+static void
+rtpp_uring_rxq_gc(struct rtpp_uring_rxq *q)
+{
+
+    if (q->live || q->armed || q->onready || q->ontoarm)
+        return;
+    if (q->prev != NULL)
+        q->prev->next = q->next;
+    else
+        q->urx->all = q->next;
+    if (q->next != NULL)
+        q->next->prev = q->prev;
+    rtpp_uring_rxq_flush(q);
+    RC_DECREF(q->rcnt);
+    free(q);
+}
+
+void
+rtpp_uring_rx_dtor(struct rtpp_uring_rx *urx)
+{
+    struct rtpp_uring_rxq *q;
+    struct rtp_packet *pkt;
+    unsigned int bid;
+
+    /* Closing the ring cancels all outstanding requests */
+    rtpp_uring_dtor(urx->ring);
+    munmap(urx->br, urx->br_sz);
+    while ((q = urx->all) != NULL) {
+        q->live = q->armed = q->onready = q->ontoarm = 0;
+        rtpp_uring_rxq_gc(q);
+    }
+    for (bid = 0; bid < urx->nbufs; bid++) {
+        if (urx->pkts[bid] != NULL)
+            RTPP_OBJ_DECREF(urx->pkts[bid]);
+    }
+    while ((pkt = urx->spare) != NULL) {
+        urx->spare = pkt->next;
+        pkt->next = NULL;
+        RTPP_OBJ_DECREF(pkt);
+    }
+    free(urx->pkts);
+    free(urx);
+}
+
+static void
+rtpp_uring_rxq_toarm(struct rtpp_uring_rxq *q)
+{
+
+    if (q->ontoarm)
+        return;
+    q->ontoarm = 1;
+    q->anext = q->urx->toarm;
+    q->urx->toarm = q;
+}
+
+/*
+ * Register socket with the ring. Receiving starts on the next call to the
+ * rtpp_uring_rx_reap(), the refcnt is held until the request is gone for
+ * good, owner and idx are for the caller to identify the queue by.
+ */
+struct rtpp_uring_rxq *
+rtpp_uring_rx_add(struct rtpp_uring_rx *urx, int fd, struct rtpp_refcnt *rcnt,
+  void *owner, int idx)
+{
+    struct rtpp_uring_rxq *q;
+
+    q = rtpp_zmalloc(sizeof(*q));
+    if (q == NULL)
+        return (NULL);
+    q->urx = urx;
+    q->fd = fd;
+    q->rcnt = rcnt;
+    RC_INCREF(rcnt);
+    q->owner = owner;
+    q->idx = idx;
+    q->live = 1;
+    q->next = urx->all;
+    if (q->next != NULL)
+        q->next->prev = q;
+    urx->all = q;
+    rtpp_uring_rxq_toarm(q);
+    return (q);
+}
+
+void
+rtpp_uring_rxq_setidx(struct rtpp_uring_rxq *q, int idx)
+{
+
+    q->idx = idx;
+}
+
+/*
+ * Stop receiving on the socket, packets that are already queued are
+ * discarded and so is anything that is still in flight. The request is
+ * cancelled on the next call to the rtpp_uring_rx_reap().
+ */
+void
+rtpp_uring_rx_del(struct rtpp_uring_rxq *q)
+{
+
+    q->live = 0;
+    rtpp_uring_rxq_flush(q);
+    if (q->armed)
+        rtpp_uring_rxq_toarm(q);
+    rtpp_uring_rxq_gc(q);
+}
+
+/*
+ * Submit multishot requests for the live queues on the list and cancel
+ * the ones that have been deleted.
+ */
+static int
+rtpp_uring_rx_arm(struct rtpp_uring_rx *urx)
+{
+    struct rtpp_uring_rxq *q, **qpp;
+    struct io_uring_sqe *sqe;
+
+    for (qpp = &urx->toarm; (q = *qpp) != NULL;) {
+        if (q->live || q->armed) {
+            sqe = rtpp_uring_get_sqe(urx->ring);
+            if (sqe == NULL) {
+                /* Retry on the next round */
+                qpp = &q->anext;
+                continue;
+            }
+        }
+        if (q->live) {
+            sqe->opcode = IORING_OP_RECVMSG;
+            sqe->fd = q->fd;
+            sqe->addr = (uintptr_t)&urx->mhdr;
+            sqe->len = 1;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = RTPP_URING_BGID;
+            sqe->user_data = (uintptr_t)q;
+            rtpp_uring_put_sqe(urx->ring);
+            q->armed = 1;
+        } else if (q->armed) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = -1;
+            sqe->addr = (uintptr_t)q;
+            sqe->user_data = RTPP_URING_UD_NONE;
+            rtpp_uring_put_sqe(urx->ring);
+        }
+        *qpp = q->anext;
+        q->ontoarm = 0;
+        rtpp_uring_rxq_gc(q);
+    }
+    return (rtpp_uring_flush(urx->ring));
+}
+
+static void
+rtpp_uring_rx_complete(struct rtpp_uring_rx *urx, const struct io_uring_cqe *cqe)
+{
+    struct rtpp_uring_rxq *q;
+    struct io_uring_recvmsg_out *out;
+    struct rtp_packet *pkt;
+    unsigned int bid;
+
+    q = (struct rtpp_uring_rxq *)(uintptr_t)cqe->user_data;
+    if (q == NULL)
+        return;
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+        pkt = urx->pkts[bid];
+        urx->pkts[bid] = NULL;
+        urx->nmissing++;
+        out = (struct io_uring_recvmsg_out *)RXBUF_BASE(pkt);
+        if (cqe->res < 0 || !q->live || (out->flags & MSG_TRUNC) != 0) {
+            rtpp_uring_rx_putspare(urx, pkt);
+        } else {
+            pkt->next = NULL;
+            if (q->tail != NULL)
+                q->tail->next = pkt;
+            else
+                q->head = pkt;
+            q->tail = pkt;
+            q->len++;
+            if (!q->onready) {
+                q->onready = 1;
+                q->rnext = urx->ready;
+                urx->ready = q;
+            }
+        }
+    }
+    if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+        /* Multishot has terminated, i.e. ran out of buffers or cancelled */
+        q->armed = 0;
+        if (q->live)
+            rtpp_uring_rxq_toarm(q);
+        else
+            rtpp_uring_rxq_gc(q);
+    }
+}
+
+/*
+ * Process whatever completions have been posted since the last call and
+ * (re-)arm receive requests as needed. Returns -1 if the ring has failed.
+ */
+int
+rtpp_uring_rx_reap(struct rtpp_uring_rx *urx)
+{
+    struct rtpp_uring *rp;
+    unsigned int head;
+
+    rp = urx->ring;
+    head = atomic_load_explicit(rp->cq_head, memory_order_relaxed);
+    while (head != atomic_load_explicit(rp->cq_tail, memory_order_acquire)) {
+        rtpp_uring_rx_complete(urx, &rp->cqes[head & *rp->cq_mask]);
+        head++;
+    }
+    atomic_store_explicit(rp->cq_head, head, memory_order_release);
+    rtpp_uring_rx_refill(urx);
+    return (rtpp_uring_rx_arm(urx) < 0 ? -1 : 0);
+}
+
+/*
+ * Report queues of the given owner that have packets in them, their idx
+ * values are stored into idxs. Just like with the level-triggered poll(2)
+ * a queue is reported over and over again until it has been emptied, so
+ * the caller is free to only take some of the packets.
+ */
+int
+rtpp_uring_rx_ready(struct rtpp_uring_rx *urx, void *owner, int *idxs,
+  int nidxs)
+{
+    struct rtpp_uring_rxq *q, **qpp;
+    int n;
+
+    n = 0;
+    for (qpp = &urx->ready; (q = *qpp) != NULL && n < nidxs;) {
+        if (q->owner != owner) {
+            qpp = &q->rnext;
+            continue;
+        }
+        if (q->live && q->len > 0) {
+            idxs[n++] = q->idx;
+            qpp = &q->rnext;
+            continue;
+        }
+        *qpp = q->rnext;
+        q->onready = 0;
+        rtpp_uring_rxq_gc(q);
+    }
+    return (n);
+}
+
+/*
+ * Swap up to npkts received packets into the pkts array, packets that
+ * were there are used to refill the buffer ring. Use
+ * rtpp_uring_rx_unpack() to get the length and addresses.
+ */
+int
+rtpp_uring_rxq_pull(struct rtpp_uring_rxq *q, struct rtp_packet **pkts,
+  int npkts)
+{
+    struct rtp_packet *pkt;
+    int n;
+
+    for (n = 0; n < npkts && q->head != NULL; n++) {
+        pkt = q->head;
+        q->head = pkt->next;
+        pkt->next = NULL;
+        rtpp_uring_rx_putspare(q->urx, pkts[n]);
+        pkts[n] = pkt;
+    }
+    if (q->head == NULL)
+        q->tail = NULL;
+    q->len -= n;
+    return (n);
+}
+
+int
+rtpp_uring_rxq_drain(struct rtpp_uring_rxq *q)
+{
+    int n;
+
+    n = q->len;
+    rtpp_uring_rxq_flush(q);
+    return (n);
+}
+
+int
+rtpp_uring_rxq_len(const struct rtpp_uring_rxq *q)
+{
+
+    return (q->len);
+}
+
+/*
+ * Parse the recvmsg header in front of the payload of a packet returned by
+ * the rtpp_uring_rxq_pull(). Source address is stored into the rmp->from,
+ * destination address (if any) into rmp->to, which must not point into
+ * the packet's _laddr as that is where the header is.
+ */
+void
+rtpp_uring_rx_unpack(const struct rtp_packet *pkt, struct rtpp_rxmsg *rmp,
+  int mtype)
+{
+    struct io_uring_recvmsg_out out;
+    const unsigned char *base;
+    struct msghdr msg;
+
+    base = RXBUF_BASE(pkt);
+    memcpy(&out, base, sizeof(out));
+    rmp->size = out.payloadlen;
+    rmp->fromlen = (out.namelen > RTPP_URING_NAMELEN) ? RTPP_URING_NAMELEN :
+      out.namelen;
+    memcpy(rmp->from, base + sizeof(out), rmp->fromlen);
+    memset(&msg, '\0', sizeof(msg));
+    msg.msg_control = (void *)(base + sizeof(out) + RTPP_URING_NAMELEN);
+    msg.msg_controllen = out.controllen;
+    rtpp_rxmsg_cmsgs(&msg, rmp, mtype);
+}
+#else
+struct rtpp_uring *
+rtpp_uring_ctor(unsigned int entries)
+{
+
+    errno = ENOSYS;
+    return (NULL);
+}
+
+void
+rtpp_uring_dtor(struct rtpp_uring *rp)
+{
+
+    abort();
+}
+
+int
+rtpp_uring_sendmsgs(struct rtpp_uring *rp, struct rtpp_uring_msg *msgs,
+  int nmsgs)
+{
+
+    errno = ENOSYS;
+    return (-1);
+}
+
+/*
+ * Receive side stubs, nothing can be added to a ring that can't be
+ * created in the first place, so the rest is unreachable.
+ */
+struct rtpp_uring_rx *
+rtpp_uring_rx_ctor(unsigned int nbufs)
+{
+
+    errno = ENOSYS;
+    return (NULL);
+}
+
+void
+rtpp_uring_rx_dtor(struct rtpp_uring_rx *urx)
+{
+
+    abort();
+}
+
+struct rtpp_uring_rxq *
+rtpp_uring_rx_add(struct rtpp_uring_rx *urx, int fd, struct rtpp_refcnt *rcnt,
+  void *owner, int idx)
+{
+
+    abort();
+}
+
+void
+rtpp_uring_rx_del(struct rtpp_uring_rxq *q)
+{
+
+    abort();
+}
+
+void
+rtpp_uring_rxq_setidx(struct rtpp_uring_rxq *q, int idx)
+{
+
+    abort();
+}
+
+int
+rtpp_uring_rx_reap(struct rtpp_uring_rx *urx)
+{
+
+    abort();
+}
+
+int
+rtpp_uring_rx_ready(struct rtpp_uring_rx *urx, void *owner, int *idxs,
+  int nidxs)
+{
+
+    abort();
+}
+
+int
+rtpp_uring_rxq_pull(struct rtpp_uring_rxq *q, struct rtp_packet **pkts,
+  int npkts)
+{
+
+    abort();
+}
+
+int
+rtpp_uring_rxq_drain(struct rtpp_uring_rxq *q)
+{
+
+    abort();
+}
+
+int
+rtpp_uring_rxq_len(const struct rtpp_uring_rxq *q)
+{
+
+    abort();
+}
+
+void
+rtpp_uring_rx_unpack(const struct rtp_packet *pkt, struct rtpp_rxmsg *rmp,
+  int mtype)
+{
+
+    abort();
+}
+#endif /* HAVE_LINUX_IO_URING_H */
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2019 Sippy Software, Inc., http://www.sippysoft.com
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#ifndef _RTPP_URING_H_
+#define _RTPP_URING_H_
+
+struct rtpp_uring;
+struct rtpp_uring_rx;
+struct rtpp_uring_rxq;
+struct rtpp_refcnt;
+struct rtp_packet;
+struct rtpp_rxmsg;
+
+struct rtpp_uring_msg {
+    int sock;
+    int flags;
+    struct msghdr msg;
+    /* Filled in upon completion: bytes sent or -errno */
+    int res;
+};
+
+struct rtpp_uring *rtpp_uring_ctor(unsigned int);
+void rtpp_uring_dtor(struct rtpp_uring *);
+int rtpp_uring_sendmsgs(struct rtpp_uring *, struct rtpp_uring_msg *, int);
+
+struct rtpp_uring_rx *rtpp_uring_rx_ctor(unsigned int);
+void rtpp_uring_rx_dtor(struct rtpp_uring_rx *);
+struct rtpp_uring_rxq *rtpp_uring_rx_add(struct rtpp_uring_rx *, int,
+  struct rtpp_refcnt *, void *, int);
+void rtpp_uring_rx_del(struct rtpp_uring_rxq *);
+void rtpp_uring_rxq_setidx(struct rtpp_uring_rxq *, int);
+int rtpp_uring_rx_reap(struct rtpp_uring_rx *);
+int rtpp_uring_rx_ready(struct rtpp_uring_rx *, void *, int *, int);
+int rtpp_uring_rxq_pull(struct rtpp_uring_rxq *, struct rtp_packet **, int);
+int rtpp_uring_rxq_drain(struct rtpp_uring_rxq *);
+int rtpp_uring_rxq_len(const struct rtpp_uring_rxq *);
+void rtpp_uring_rx_unpack(const struct rtp_packet *, struct rtpp_rxmsg *, int);
+
+#endif
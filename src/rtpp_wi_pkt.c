@@ -131,8 +131,15 @@ rtpp_wi_malloc_pkt_na(int sock, struct rtp_packet *pkt,
     wipp->flags = 0;
     wipp->msg = pkt->data.buf;
     wipp->msg_len = pkt->size;
-    wipp->sendto = sstosa(&pkt->sendto);
-    wipp->tolen = CALL_SMETHOD(sendto, get, wipp->sendto, sizeof(pkt->raddr));
+    if (sendto != NULL) {
+        wipp->sendto = sstosa(&pkt->sendto);
+        wipp->tolen = CALL_SMETHOD(sendto, get, wipp->sendto,
+          sizeof(pkt->raddr));
+    } else {
+        /* Socket is connected */
+        wipp->sendto = NULL;
+        wipp->tolen = 0;
+    }
     wipp->nsend = nsend;
     return (&(wipp->pub));
 }
@@ -42,6 +42,12 @@ struct rtpp_wi_pvt {
     void *free_ptr;
     void *msg;
     int nsend;
+    /* SCM_TXTIME departure time (CLOCK_MONOTONIC, ns), 0 if none */
+    uint64_t txtime;
+    /* Egress state of the socket to be updated once sent, if any */
+    _Atomic unsigned int *inflight;
+    /* Peer the socket is connected to at the moment, if known */
+    _Atomic(uint64_t) *cpeer;
     int debug;
     struct rtpp_log *log;
     char data[0];